@@ -0,0 +1,37 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+
+// Helpers shared by the benchmark functions
+
+// Best of reps runs of fn, in seconds
+template <typename F>
+double best_seconds(const F& fn, int reps = 5) {
+    double best = 0.0;
+    for (int rep = 0; rep < reps; rep++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        best = (rep == 0) ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+// Positive integer from an environment variable, else fallback
+inline size_t env_size(const char* name, size_t fallback) {
+    const char* env = std::getenv(name);
+    if (env != nullptr) {
+        long n = std::strtol(env, nullptr, 10);
+        if (n > 0) {
+            return static_cast<size_t>(n);
+        }
+    }
+    return fallback;
+}
+
+#endif // BENCH_UTIL_H
@@ -0,0 +1,56 @@
+#include "cpu_features.h"
+#include <cstring>
+#include <string>
+
+#ifdef __x86_64__
+#include <cpuid.h>
+#endif
+
+static CpuFeatures detect_cpu_features() {
+    CpuFeatures f = {};
+#ifdef __x86_64__
+    // __builtin_cpu_supports reads CPUID and checks that the OS saves the
+    // wider register state (XGETBV) before reporting AVX-class features
+    __builtin_cpu_init();
+    f.sse2 = __builtin_cpu_supports("sse2");
+    f.avx2 = __builtin_cpu_supports("avx2");
+    f.fma = __builtin_cpu_supports("fma");
+    f.f16c = __builtin_cpu_supports("f16c");
+    f.avx512f = __builtin_cpu_supports("avx512f");
+    f.avx512bw = __builtin_cpu_supports("avx512bw");
+    f.avx512vnni = __builtin_cpu_supports("avx512vnni");
+#endif
+    return f;
+}
+
+const CpuFeatures& cpu_features() {
+    static const CpuFeatures features = detect_cpu_features();
+    return features;
+}
+
+static std::string detect_cpu_model() {
+    std::string model;
+#ifdef __x86_64__
+    unsigned int regs[12];
+    if (__get_cpuid_max(0x80000000u, nullptr) >= 0x80000004u) {
+        for (unsigned int i = 0; i < 3; i++) {
+            __get_cpuid(0x80000002u + i, &regs[4 * i], &regs[4 * i + 1], &regs[4 * i + 2], &regs[4 * i + 3]);
+        }
+        char brand[sizeof(regs) + 1];
+        std::memcpy(brand, regs, sizeof(regs));
+        brand[sizeof(regs)] = '\0';
+        model = brand;
+    }
+#endif
+    size_t first = model.find_first_not_of(' ');
+    size_t last = model.find_last_not_of(' ');
+    if (first == std::string::npos) {
+        return "generic";
+    }
+    return model.substr(first, last - first + 1);
+}
+
+const char* cpu_model_name() {
+    static const std::string model = detect_cpu_model();
+    return model.c_str();
+}
@@ -0,0 +1,31 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Instruction set extensions detected once at startup through CPUID.
+// Every flag is false on non-x86 builds.
+struct CpuFeatures {
+    bool sse2;
+    bool avx2;
+    bool fma;
+    bool f16c;
+    bool avx512f;
+    bool avx512bw;
+    bool avx512vnni;
+};
+
+const CpuFeatures& cpu_features();
+
+// Processor brand string from CPUID (e.g. "Intel(R) Xeon(R) ..."), with
+// surrounding spaces trimmed; "generic" when unavailable
+const char* cpu_model_name();
+
+// Per-function target attributes for kernels that are compiled for a wider
+// ISA than the build baseline and only called after a cpu_features() check
+#ifdef __x86_64__
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_F16C __attribute__((target("avx,f16c")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#define TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+#endif
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,615 @@
+#include "elementwise.h"
+#include "bench_util.h"
+#include "cpu_features.h"
+#include "random_fill.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Elements per block of work
+static const size_t kElementBlock = 1 << 14;
+// Elements below which the work stays on the calling thread
+static const size_t kElementParallelMin = 1 << 16;
+
+// Operation applied to each element. Unary maps and kOpScale read only a;
+// kOpAxpy computes b + alpha * a.
+enum ElementOp { kOpAdd, kOpSub, kOpMul, kOpScale, kOpAxpy, kOpExp, kOpRelu, kOpClamp };
+
+struct ElementParams {
+    double alpha;
+    double lo;
+    double hi;
+};
+
+template <typename T>
+struct ElementKernel {
+    typedef void (*Fn)(const T* a, const T* b, T* out, size_t n, const ElementParams& p);
+};
+
+// e^x = 2^n e^r with n = round(x / ln2) and |r| <= ln2 / 2. ln2 is split so
+// that n * kLn2Hi is exact (Cody and Waite). 2^n is applied as two factors
+// so that both stay normal from the overflow threshold down into the
+// subnormal range.
+static const double kLog2e = 1.4426950408889634;
+static const double kLn2Hi = 6.93147180369123816490e-01;
+static const double kLn2Lo = 1.90821492927058770002e-10;
+// Taylor coefficients 1/13! ... 1/0!; degree 13 is exact to 4e-18 on |r| <= ln2 / 2
+static const double kExpCoeffs[14] = {
+    1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0,
+    1.0 / 40320.0,      1.0 / 5040.0,      1.0 / 720.0,      1.0 / 120.0,     1.0 / 24.0,
+    1.0 / 6.0,          0.5,               1.0,              1.0
+};
+// Inputs are clamped here first; beyond them e^x is 0 or inf anyway
+static const double kExpMin = -746.0, kExpMax = 710.0;
+
+// Single precision: Cephes expf, whose polynomial gives e^r to within 1 ulp
+static const float kLn2HiF = 0.693359375f;
+static const float kLn2LoF = -2.12194440e-4f;
+static const float kExpCoeffsF[6] = {
+    1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f
+};
+static const float kExpMinF = -104.0f, kExpMaxF = 89.0f;
+
+#if !USE_X86_SIMD
+template <int Op, typename T>
+static inline T op_scalar(T a, T b, const ElementParams& p) {
+    switch (Op) {
+    case kOpAdd: return a + b;
+    case kOpSub: return a - b;
+    case kOpMul: return a * b;
+    case kOpScale: return static_cast<T>(p.alpha) * a;
+    case kOpAxpy: return b + static_cast<T>(p.alpha) * a;
+    case kOpExp: return std::exp(a);
+    case kOpRelu: return a < T(0) ? T(0) : a;
+    default: return a < static_cast<T>(p.lo) ? static_cast<T>(p.lo) : a > static_cast<T>(p.hi) ? static_cast<T>(p.hi) : a;
+    }
+}
+
+template <int Op, typename T>
+static void elementwise_scalar(const T* a, const T* b, T* out, size_t n, const ElementParams& p) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = op_scalar<Op>(a[i], b[i], p);
+    }
+}
+#endif
+
+#if USE_X86_SIMD
+// Copies the last n < W elements into zero-padded blocks, so every element
+// goes through the same vector arithmetic wherever its run ends
+template <typename T, size_t W>
+struct PaddedTail {
+    T a[W];
+    T b[W];
+    T out[W];
+
+    PaddedTail(const T* src_a, const T* src_b, size_t n) {
+        std::fill(a, a + W, T(0));
+        std::fill(b, b + W, T(0));
+        std::copy(src_a, src_a + n, a);
+        std::copy(src_b, src_b + n, b);
+    }
+};
+
+// Where x is NaN, x; elsewhere y
+static inline __m128d keep_nan_pd2(__m128d x, __m128d y) {
+    __m128d nan = _mm_cmpunord_pd(x, x);
+    return _mm_or_pd(_mm_and_pd(nan, x), _mm_andnot_pd(nan, y));
+}
+
+static inline __m128 keep_nan_ps4(__m128 x, __m128 y) {
+    __m128 nan = _mm_cmpunord_ps(x, x);
+    return _mm_or_ps(_mm_and_ps(nan, x), _mm_andnot_ps(nan, y));
+}
+
+// 2^n for each int32 lane n in [-1022, 1023] of the low half
+static inline __m128d pow2_pd2(__m128i n) {
+    __m128i biased = _mm_add_epi32(n, _mm_set1_epi32(1023));
+    return _mm_castsi128_pd(_mm_slli_epi64(_mm_unpacklo_epi32(biased, _mm_setzero_si128()), 52));
+}
+
+static inline __m128 pow2_ps4(__m128i n) {
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+}
+
+static inline __m128d exp_pd2(__m128d x) {
+    __m128d xc = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(kExpMin)), _mm_set1_pd(kExpMax));
+    __m128i n = _mm_cvtpd_epi32(_mm_mul_pd(xc, _mm_set1_pd(kLog2e)));
+    __m128d t = _mm_cvtepi32_pd(n);
+    __m128d r = _mm_sub_pd(xc, _mm_mul_pd(t, _mm_set1_pd(kLn2Hi)));
+    r = _mm_sub_pd(r, _mm_mul_pd(t, _mm_set1_pd(kLn2Lo)));
+    __m128d p = _mm_set1_pd(kExpCoeffs[0]);
+    for (int k = 1; k < 14; k++) {
+        p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(kExpCoeffs[k]));
+    }
+    __m128i n1 = _mm_srai_epi32(n, 1);
+    __m128i n2 = _mm_sub_epi32(n, n1);
+    return keep_nan_pd2(x, _mm_mul_pd(_mm_mul_pd(p, pow2_pd2(n1)), pow2_pd2(n2)));
+}
+
+static inline __m128 exp_ps4(__m128 x) {
+    __m128 xc = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(kExpMinF)), _mm_set1_ps(kExpMaxF));
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(xc, _mm_set1_ps(static_cast<float>(kLog2e))));
+    __m128 t = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(xc, _mm_mul_ps(t, _mm_set1_ps(kLn2HiF)));
+    r = _mm_sub_ps(r, _mm_mul_ps(t, _mm_set1_ps(kLn2LoF)));
+    __m128 p = _mm_set1_ps(kExpCoeffsF[0]);
+    for (int k = 1; k < 6; k++) {
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(kExpCoeffsF[k]));
+    }
+    p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+    __m128i n1 = _mm_srai_epi32(n, 1);
+    __m128i n2 = _mm_sub_epi32(n, n1);
+    return keep_nan_ps4(x, _mm_mul_ps(_mm_mul_ps(p, pow2_ps4(n1)), pow2_ps4(n2)));
+}
+
+// max(0, x) and min(hi, max(lo, x)) return x when it is NaN
+template <int Op>
+static inline __m128d op_pd2(__m128d a, __m128d b, __m128d alpha, __m128d lo, __m128d hi) {
+    switch (Op) {
+    case kOpAdd: return _mm_add_pd(a, b);
+    case kOpSub: return _mm_sub_pd(a, b);
+    case kOpMul: return _mm_mul_pd(a, b);
+    case kOpScale: return _mm_mul_pd(alpha, a);
+    case kOpAxpy: return _mm_add_pd(b, _mm_mul_pd(alpha, a));
+    case kOpExp: return exp_pd2(a);
+    case kOpRelu: return _mm_max_pd(_mm_setzero_pd(), a);
+    default: return _mm_min_pd(hi, _mm_max_pd(lo, a));
+    }
+}
+
+template <int Op>
+static inline __m128 op_ps4(__m128 a, __m128 b, __m128 alpha, __m128 lo, __m128 hi) {
+    switch (Op) {
+    case kOpAdd: return _mm_add_ps(a, b);
+    case kOpSub: return _mm_sub_ps(a, b);
+    case kOpMul: return _mm_mul_ps(a, b);
+    case kOpScale: return _mm_mul_ps(alpha, a);
+    case kOpAxpy: return _mm_add_ps(b, _mm_mul_ps(alpha, a));
+    case kOpExp: return exp_ps4(a);
+    case kOpRelu: return _mm_max_ps(_mm_setzero_ps(), a);
+    default: return _mm_min_ps(hi, _mm_max_ps(lo, a));
+    }
+}
+
+// Two registers per step; both are loaded before either is stored, so out
+// may be a or b
+template <int Op>
+static inline void block_sse2(const double* a, const double* b, double* out, __m128d alpha, __m128d lo,
+                              __m128d hi) {
+    __m128d r0 = op_pd2<Op>(_mm_loadu_pd(a), _mm_loadu_pd(b), alpha, lo, hi);
+    __m128d r1 = op_pd2<Op>(_mm_loadu_pd(a + 2), _mm_loadu_pd(b + 2), alpha, lo, hi);
+    _mm_storeu_pd(out, r0);
+    _mm_storeu_pd(out + 2, r1);
+}
+
+template <int Op>
+static inline void block_sse2(const float* a, const float* b, float* out, __m128 alpha, __m128 lo, __m128 hi) {
+    __m128 r0 = op_ps4<Op>(_mm_loadu_ps(a), _mm_loadu_ps(b), alpha, lo, hi);
+    __m128 r1 = op_ps4<Op>(_mm_loadu_ps(a + 4), _mm_loadu_ps(b + 4), alpha, lo, hi);
+    _mm_storeu_ps(out, r0);
+    _mm_storeu_ps(out + 4, r1);
+}
+
+template <int Op>
+static void elementwise_sse2(const double* a, const double* b, double* out, size_t n, const ElementParams& p) {
+    const __m128d alpha = _mm_set1_pd(p.alpha), lo = _mm_set1_pd(p.lo), hi = _mm_set1_pd(p.hi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        block_sse2<Op>(a + i, b + i, out + i, alpha, lo, hi);
+    }
+    if (i < n) {
+        PaddedTail<double, 4> tail(a + i, b + i, n - i);
+        block_sse2<Op>(tail.a, tail.b, tail.out, alpha, lo, hi);
+        std::copy(tail.out, tail.out + (n - i), out + i);
+    }
+}
+
+template <int Op>
+static void elementwise_sse2(const float* a, const float* b, float* out, size_t n, const ElementParams& p) {
+    const __m128 alpha = _mm_set1_ps(static_cast<float>(p.alpha));
+    const __m128 lo = _mm_set1_ps(static_cast<float>(p.lo)), hi = _mm_set1_ps(static_cast<float>(p.hi));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        block_sse2<Op>(a + i, b + i, out + i, alpha, lo, hi);
+    }
+    if (i < n) {
+        PaddedTail<float, 8> tail(a + i, b + i, n - i);
+        block_sse2<Op>(tail.a, tail.b, tail.out, alpha, lo, hi);
+        std::copy(tail.out, tail.out + (n - i), out + i);
+    }
+}
+
+TARGET_AVX2 static inline __m256d exp_pd4(__m256d x) {
+    __m256d xc = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(kExpMin)), _mm256_set1_pd(kExpMax));
+    __m256d t = _mm256_round_pd(_mm256_mul_pd(xc, _mm256_set1_pd(kLog2e)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(t, _mm256_set1_pd(kLn2Hi), xc);
+    r = _mm256_fnmadd_pd(t, _mm256_set1_pd(kLn2Lo), r);
+    __m256d p = _mm256_set1_pd(kExpCoeffs[0]);
+    for (int k = 1; k < 14; k++) {
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(kExpCoeffs[k]));
+    }
+    const __m128i bias = _mm_set1_epi32(1023);
+    __m128i n = _mm256_cvtpd_epi32(t);
+    __m128i n1 = _mm_srai_epi32(n, 1);
+    __m128i n2 = _mm_sub_epi32(n, n1);
+    __m256d s1 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_add_epi32(n1, bias)), 52));
+    __m256d s2 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_add_epi32(n2, bias)), 52));
+    __m256d y = _mm256_mul_pd(_mm256_mul_pd(p, s1), s2);
+    return _mm256_blendv_pd(y, x, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+}
+
+TARGET_AVX2 static inline __m256 exp_ps8(__m256 x) {
+    __m256 xc = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(kExpMinF)), _mm256_set1_ps(kExpMaxF));
+    __m256 t = _mm256_round_ps(_mm256_mul_ps(xc, _mm256_set1_ps(static_cast<float>(kLog2e))),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(t, _mm256_set1_ps(kLn2HiF), xc);
+    r = _mm256_fnmadd_ps(t, _mm256_set1_ps(kLn2LoF), r);
+    __m256 p = _mm256_set1_ps(kExpCoeffsF[0]);
+    for (int k = 1; k < 6; k++) {
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpCoeffsF[k]));
+    }
+    p = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(p, r), r, r), _mm256_set1_ps(1.0f));
+    const __m256i bias = _mm256_set1_epi32(127);
+    __m256i n = _mm256_cvtps_epi32(t);
+    __m256i n1 = _mm256_srai_epi32(n, 1);
+    __m256i n2 = _mm256_sub_epi32(n, n1);
+    __m256 s1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, bias), 23));
+    __m256 s2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n2, bias), 23));
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(p, s1), s2);
+    return _mm256_blendv_ps(y, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+}
+
+template <int Op>
+TARGET_AVX2 static inline __m256d op_pd4(__m256d a, __m256d b, __m256d alpha, __m256d lo, __m256d hi) {
+    switch (Op) {
+    case kOpAdd: return _mm256_add_pd(a, b);
+    case kOpSub: return _mm256_sub_pd(a, b);
+    case kOpMul: return _mm256_mul_pd(a, b);
+    case kOpScale: return _mm256_mul_pd(alpha, a);
+    case kOpAxpy: return _mm256_fmadd_pd(alpha, a, b);
+    case kOpExp: return exp_pd4(a);
+    case kOpRelu: return _mm256_max_pd(_mm256_setzero_pd(), a);
+    default: return _mm256_min_pd(hi, _mm256_max_pd(lo, a));
+    }
+}
+
+template <int Op>
+TARGET_AVX2 static inline __m256 op_ps8(__m256 a, __m256 b, __m256 alpha, __m256 lo, __m256 hi) {
+    switch (Op) {
+    case kOpAdd: return _mm256_add_ps(a, b);
+    case kOpSub: return _mm256_sub_ps(a, b);
+    case kOpMul: return _mm256_mul_ps(a, b);
+    case kOpScale: return _mm256_mul_ps(alpha, a);
+    case kOpAxpy: return _mm256_fmadd_ps(alpha, a, b);
+    case kOpExp: return exp_ps8(a);
+    case kOpRelu: return _mm256_max_ps(_mm256_setzero_ps(), a);
+    default: return _mm256_min_ps(hi, _mm256_max_ps(lo, a));
+    }
+}
+
+template <int Op>
+TARGET_AVX2 static inline void block_avx2(const double* a, const double* b, double* out, __m256d alpha,
+                                          __m256d lo, __m256d hi) {
+    __m256d r0 = op_pd4<Op>(_mm256_loadu_pd(a), _mm256_loadu_pd(b), alpha, lo, hi);
+    __m256d r1 = op_pd4<Op>(_mm256_loadu_pd(a + 4), _mm256_loadu_pd(b + 4), alpha, lo, hi);
+    _mm256_storeu_pd(out, r0);
+    _mm256_storeu_pd(out + 4, r1);
+}
+
+template <int Op>
+TARGET_AVX2 static inline void block_avx2(const float* a, const float* b, float* out, __m256 alpha, __m256 lo,
+                                          __m256 hi) {
+    __m256 r0 = op_ps8<Op>(_mm256_loadu_ps(a), _mm256_loadu_ps(b), alpha, lo, hi);
+    __m256 r1 = op_ps8<Op>(_mm256_loadu_ps(a + 8), _mm256_loadu_ps(b + 8), alpha, lo, hi);
+    _mm256_storeu_ps(out, r0);
+    _mm256_storeu_ps(out + 8, r1);
+}
+
+template <int Op>
+TARGET_AVX2 static void elementwise_avx2(const double* a, const double* b, double* out, size_t n,
+                                         const ElementParams& p) {
+    const __m256d alpha = _mm256_set1_pd(p.alpha), lo = _mm256_set1_pd(p.lo), hi = _mm256_set1_pd(p.hi);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        block_avx2<Op>(a + i, b + i, out + i, alpha, lo, hi);
+    }
+    if (i < n) {
+        PaddedTail<double, 8> tail(a + i, b + i, n - i);
+        block_avx2<Op>(tail.a, tail.b, tail.out, alpha, lo, hi);
+        std::copy(tail.out, tail.out + (n - i), out + i);
+    }
+}
+
+template <int Op>
+TARGET_AVX2 static void elementwise_avx2(const float* a, const float* b, float* out, size_t n,
+                                         const ElementParams& p) {
+    const __m256 alpha = _mm256_set1_ps(static_cast<float>(p.alpha));
+    const __m256 lo = _mm256_set1_ps(static_cast<float>(p.lo)), hi = _mm256_set1_ps(static_cast<float>(p.hi));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        block_avx2<Op>(a + i, b + i, out + i, alpha, lo, hi);
+    }
+    if (i < n) {
+        PaddedTail<float, 16> tail(a + i, b + i, n - i);
+        block_avx2<Op>(tail.a, tail.b, tail.out, alpha, lo, hi);
+        std::copy(tail.out, tail.out + (n - i), out + i);
+    }
+}
+#endif
+
+template <int Op, typename T>
+static typename ElementKernel<T>::Fn element_kernel() {
+#if USE_X86_SIMD
+    typename ElementKernel<T>::Fn avx2 = elementwise_avx2<Op>;
+    typename ElementKernel<T>::Fn sse2 = elementwise_sse2<Op>;
+    return (cpu_features().avx2 && cpu_features().fma) ? avx2 : sse2;
+#else
+    return elementwise_scalar<Op, T>;
+#endif
+}
+
+// Inputs may be the output exactly, element for element; any other overlap
+// would read elements already overwritten
+template <typename T>
+static void check_operand(const BasicConstMatrixView<T>& x, const BasicMatrixView<T>& out) {
+    if (x.getRows() != out.getRows() || x.getCols() != out.getCols()) {
+        throw std::runtime_error("Matrix dimensions must match for element-wise operation");
+    }
+    bool same = x.empty() || (x.row(0) == out.row(0) && (x.getRows() == 1 || x.getStride() == out.getStride()));
+    if (!same && views_overlap(x, BasicConstMatrixView<T>(out))) {
+        throw std::runtime_error("Element-wise output overlaps an input");
+    }
+}
+
+// out = op(a, b) over the row pieces of fixed element blocks
+template <int Op, typename T>
+static void run_elementwise(const BasicConstMatrixView<T>& a, const BasicConstMatrixView<T>& b,
+                            const BasicMatrixView<T>& out, const ElementParams& p, size_t num_threads) {
+    check_operand(a, out);
+    check_operand(b, out);
+    const size_t count = out.getRows() * out.getCols();
+    if (count == 0) {
+        return;
+    }
+    const typename ElementKernel<T>::Fn kernel = element_kernel<Op, T>();
+    const size_t cols = out.getCols();
+    const size_t blocks = (count + kElementBlock - 1) / kElementBlock;
+    parallel_blocks(blocks, count, kElementParallelMin, num_threads, [&](size_t block) {
+        size_t begin = block * kElementBlock, end = std::min(count, begin + kElementBlock);
+        for_each_row_piece(cols, begin, end, [&](size_t i, size_t j, size_t n) {
+            kernel(a.row(i) + j, b.row(i) + j, out.row(i) + j, n, p);
+        });
+    });
+}
+
+template <int Op, typename T>
+static void binary_impl(const BasicConstMatrixView<T>& a, const BasicConstMatrixView<T>& b,
+                        const BasicMatrixView<T>& out, size_t num_threads) {
+    const ElementParams p = { 1.0, 0.0, 0.0 };
+    run_elementwise<Op>(a, b, out, p, num_threads);
+}
+
+template <int Op, typename T>
+static void unary_impl(const BasicConstMatrixView<T>& a, const BasicMatrixView<T>& out, double alpha, double lo,
+                       double hi, size_t num_threads) {
+    const ElementParams p = { alpha, lo, hi };
+    run_elementwise<Op>(a, a, out, p, num_threads);
+}
+
+void matrix_add(const ConstMatrixView& a, const ConstMatrixView& b, const MatrixView& out, size_t num_threads) {
+    binary_impl<kOpAdd>(a, b, out, num_threads);
+}
+
+void matrix_add(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, const MatrixViewF32& out,
+                size_t num_threads) {
+    binary_impl<kOpAdd>(a, b, out, num_threads);
+}
+
+void matrix_subtract(const ConstMatrixView& a, const ConstMatrixView& b, const MatrixView& out,
+                     size_t num_threads) {
+    binary_impl<kOpSub>(a, b, out, num_threads);
+}
+
+void matrix_subtract(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, const MatrixViewF32& out,
+                     size_t num_threads) {
+    binary_impl<kOpSub>(a, b, out, num_threads);
+}
+
+void matrix_hadamard(const ConstMatrixView& a, const ConstMatrixView& b, const MatrixView& out,
+                     size_t num_threads) {
+    binary_impl<kOpMul>(a, b, out, num_threads);
+}
+
+void matrix_hadamard(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, const MatrixViewF32& out,
+                     size_t num_threads) {
+    binary_impl<kOpMul>(a, b, out, num_threads);
+}
+
+void matrix_add(const MatrixView& a, const ConstMatrixView& b, size_t num_threads) {
+    binary_impl<kOpAdd, double>(a, b, a, num_threads);
+}
+
+void matrix_add(const MatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads) {
+    binary_impl<kOpAdd, float>(a, b, a, num_threads);
+}
+
+void matrix_subtract(const MatrixView& a, const ConstMatrixView& b, size_t num_threads) {
+    binary_impl<kOpSub, double>(a, b, a, num_threads);
+}
+
+void matrix_subtract(const MatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads) {
+    binary_impl<kOpSub, float>(a, b, a, num_threads);
+}
+
+void matrix_hadamard(const MatrixView& a, const ConstMatrixView& b, size_t num_threads) {
+    binary_impl<kOpMul, double>(a, b, a, num_threads);
+}
+
+void matrix_hadamard(const MatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads) {
+    binary_impl<kOpMul, float>(a, b, a, num_threads);
+}
+
+void matrix_scale(const ConstMatrixView& a, double alpha, const MatrixView& out, size_t num_threads) {
+    unary_impl<kOpScale>(a, out, alpha, 0.0, 0.0, num_threads);
+}
+
+void matrix_scale(const ConstMatrixViewF32& a, float alpha, const MatrixViewF32& out, size_t num_threads) {
+    unary_impl<kOpScale>(a, out, alpha, 0.0, 0.0, num_threads);
+}
+
+void matrix_scale(const MatrixView& a, double alpha, size_t num_threads) {
+    unary_impl<kOpScale, double>(a, a, alpha, 0.0, 0.0, num_threads);
+}
+
+void matrix_scale(const MatrixViewF32& a, float alpha, size_t num_threads) {
+    unary_impl<kOpScale, float>(a, a, alpha, 0.0, 0.0, num_threads);
+}
+
+void matrix_axpy(double alpha, const ConstMatrixView& x, const MatrixView& y, size_t num_threads) {
+    const ElementParams p = { alpha, 0.0, 0.0 };
+    run_elementwise<kOpAxpy, double>(x, y, y, p, num_threads);
+}
+
+void matrix_axpy(float alpha, const ConstMatrixViewF32& x, const MatrixViewF32& y, size_t num_threads) {
+    const ElementParams p = { alpha, 0.0, 0.0 };
+    run_elementwise<kOpAxpy, float>(x, y, y, p, num_threads);
+}
+
+void matrix_exp(const ConstMatrixView& a, const MatrixView& out, size_t num_threads) {
+    unary_impl<kOpExp>(a, out, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_exp(const ConstMatrixViewF32& a, const MatrixViewF32& out, size_t num_threads) {
+    unary_impl<kOpExp>(a, out, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_exp(const MatrixView& a, size_t num_threads) {
+    unary_impl<kOpExp, double>(a, a, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_exp(const MatrixViewF32& a, size_t num_threads) {
+    unary_impl<kOpExp, float>(a, a, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_relu(const ConstMatrixView& a, const MatrixView& out, size_t num_threads) {
+    unary_impl<kOpRelu>(a, out, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_relu(const ConstMatrixViewF32& a, const MatrixViewF32& out, size_t num_threads) {
+    unary_impl<kOpRelu>(a, out, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_relu(const MatrixView& a, size_t num_threads) {
+    unary_impl<kOpRelu, double>(a, a, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_relu(const MatrixViewF32& a, size_t num_threads) {
+    unary_impl<kOpRelu, float>(a, a, 1.0, 0.0, 0.0, num_threads);
+}
+
+void matrix_clamp(const ConstMatrixView& a, double lo, double hi, const MatrixView& out, size_t num_threads) {
+    unary_impl<kOpClamp>(a, out, 1.0, lo, hi, num_threads);
+}
+
+void matrix_clamp(const ConstMatrixViewF32& a, float lo, float hi, const MatrixViewF32& out,
+                  size_t num_threads) {
+    unary_impl<kOpClamp>(a, out, 1.0, lo, hi, num_threads);
+}
+
+void matrix_clamp(const MatrixView& a, double lo, double hi, size_t num_threads) {
+    unary_impl<kOpClamp, double>(a, a, 1.0, lo, hi, num_threads);
+}
+
+void matrix_clamp(const MatrixViewF32& a, float lo, float hi, size_t num_threads) {
+    unary_impl<kOpClamp, float>(a, a, 1.0, lo, hi, num_threads);
+}
+
+// Largest distance from std::exp in units in the last place of the reference
+template <typename T>
+static double max_exp_ulps(const BasicMatrix<T>& x, const BasicMatrix<T>& y) {
+    double worst = 0.0;
+    for (size_t i = 0; i < x.getRows(); i++) {
+        for (size_t j = 0; j < x.getCols(); j++) {
+            T ref = std::exp(x(i, j));
+            T ulp = std::nextafter(ref, std::numeric_limits<T>::infinity()) - ref;
+            worst = std::max(worst, std::fabs(static_cast<double>(y(i, j)) - ref) / ulp);
+        }
+    }
+    return worst;
+}
+
+void benchmark_elementwise() {
+    std::cout << "\n=== Element-wise Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    // 64 MB per operand, well beyond the last-level cache
+    const size_t rows = 2048, cols = 4096;
+    Matrix a(rows, cols);
+    Matrix b(rows, cols);
+    Matrix c(rows, cols);
+    a.randomize();
+    b.randomize();
+    const double bytes = static_cast<double>(rows) * cols * sizeof(double);
+
+    double seconds = best_seconds([&] {
+        for (size_t i = 0; i < rows; i++) {
+            const double* x = a.row(i);
+            const double* y = b.row(i);
+            double* z = c.row(i);
+            for (size_t j = 0; j < cols; j++) {
+                z[j] = x[j] + y[j];
+            }
+        }
+    });
+    std::cout << "add " << rows << "x" << cols << " scalar loop: " << 3 * bytes / seconds / 1e9 << " GB/s"
+              << std::endl;
+    seconds = best_seconds([&] { matrix_add(a, b, c); });
+    std::cout << "add: " << 3 * bytes / seconds / 1e9 << " GB/s" << std::endl;
+    seconds = best_seconds([&] { matrix_add(c, b); });
+    std::cout << "add in place: " << 3 * bytes / seconds / 1e9 << " GB/s" << std::endl;
+    seconds = best_seconds([&] { matrix_hadamard(a, b, c); });
+    std::cout << "hadamard: " << 3 * bytes / seconds / 1e9 << " GB/s" << std::endl;
+    seconds = best_seconds([&] { matrix_scale(c, 0.5); });
+    std::cout << "scale in place: " << 2 * bytes / seconds / 1e9 << " GB/s" << std::endl;
+    seconds = best_seconds([&] { matrix_axpy(0.5, a, c); });
+    std::cout << "axpy: " << 3 * bytes / seconds / 1e9 << " GB/s" << std::endl;
+    seconds = best_seconds([&] { matrix_clamp(a, 2.0, 8.0, c); });
+    std::cout << "clamp: " << 2 * bytes / seconds / 1e9 << " GB/s" << std::endl;
+
+    // exp over its whole finite range
+    random_uniform(a, -700.0, 700.0, get_random_seed(), next_random_stream());
+    const double elements = static_cast<double>(rows) * cols;
+    seconds = best_seconds([&] {
+        for (size_t i = 0; i < rows; i++) {
+            const double* x = a.row(i);
+            double* z = c.row(i);
+            for (size_t j = 0; j < cols; j++) {
+                z[j] = std::exp(x[j]);
+            }
+        }
+    });
+    std::cout << "exp std::exp loop: " << elements / seconds / 1e6 << " M/s" << std::endl;
+    seconds = best_seconds([&] { matrix_exp(a, c); });
+    std::cout << "exp: " << elements / seconds / 1e6 << " M/s, max error " << max_exp_ulps(a, c) << " ulp"
+              << std::endl;
+
+    MatrixF32 f(rows, cols);
+    MatrixF32 g(rows, cols);
+    random_uniform(f, -80.0, 80.0, get_random_seed(), next_random_stream());
+    seconds = best_seconds([&] { matrix_exp(f, g); });
+    std::cout << "fp32 exp: " << elements / seconds / 1e6 << " M/s, max error " << max_exp_ulps(f, g) << " ulp"
+              << std::endl;
+    seconds = best_seconds([&] { matrix_relu(f); });
+    std::cout << "fp32 relu in place: " << bytes / seconds / 1e9 << " GB/s" << std::endl;
+}
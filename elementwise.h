@@ -0,0 +1,70 @@
+#ifndef ELEMENTWISE_H
+#define ELEMENTWISE_H
+
+#include <cstddef>
+#include "matrix_operations.h"
+
+// Vectorized element-wise operations on double and float matrices and views
+// (AVX2 or SSE2), split across the thread pool above 64K elements
+// (num_threads caps the workers, 0 = global pool).
+//
+// Every operation has an out-of-place form writing `out` and an in-place
+// form updating its first operand. `out` must have the operands' shape and
+// may be one of them exactly (same memory and stride), which is the same as
+// the in-place form; any other overlap throws std::runtime_error. For whole
+// chains of +, - and scalar * prefer matrix_expr.h, which fuses them.
+
+// out = a + b, a - b, or a .* b (Hadamard product)
+void matrix_add(const ConstMatrixView& a, const ConstMatrixView& b, const MatrixView& out,
+                size_t num_threads = 0);
+void matrix_add(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, const MatrixViewF32& out,
+                size_t num_threads = 0);
+void matrix_subtract(const ConstMatrixView& a, const ConstMatrixView& b, const MatrixView& out,
+                     size_t num_threads = 0);
+void matrix_subtract(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, const MatrixViewF32& out,
+                     size_t num_threads = 0);
+void matrix_hadamard(const ConstMatrixView& a, const ConstMatrixView& b, const MatrixView& out,
+                     size_t num_threads = 0);
+void matrix_hadamard(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, const MatrixViewF32& out,
+                     size_t num_threads = 0);
+
+// a += b, a -= b, a .*= b
+void matrix_add(const MatrixView& a, const ConstMatrixView& b, size_t num_threads = 0);
+void matrix_add(const MatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads = 0);
+void matrix_subtract(const MatrixView& a, const ConstMatrixView& b, size_t num_threads = 0);
+void matrix_subtract(const MatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads = 0);
+void matrix_hadamard(const MatrixView& a, const ConstMatrixView& b, size_t num_threads = 0);
+void matrix_hadamard(const MatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads = 0);
+
+// out = alpha * a, or a *= alpha
+void matrix_scale(const ConstMatrixView& a, double alpha, const MatrixView& out, size_t num_threads = 0);
+void matrix_scale(const ConstMatrixViewF32& a, float alpha, const MatrixViewF32& out, size_t num_threads = 0);
+void matrix_scale(const MatrixView& a, double alpha, size_t num_threads = 0);
+void matrix_scale(const MatrixViewF32& a, float alpha, size_t num_threads = 0);
+
+// y += alpha * x
+void matrix_axpy(double alpha, const ConstMatrixView& x, const MatrixView& y, size_t num_threads = 0);
+void matrix_axpy(float alpha, const ConstMatrixViewF32& x, const MatrixViewF32& y, size_t num_threads = 0);
+
+// Unary maps: e^x (within 2 ulp of std::exp, overflowing to inf and
+// underflowing through subnormals to 0), max(x, 0) and min(max(x, lo), hi).
+// NaN inputs give NaN.
+void matrix_exp(const ConstMatrixView& a, const MatrixView& out, size_t num_threads = 0);
+void matrix_exp(const ConstMatrixViewF32& a, const MatrixViewF32& out, size_t num_threads = 0);
+void matrix_exp(const MatrixView& a, size_t num_threads = 0);
+void matrix_exp(const MatrixViewF32& a, size_t num_threads = 0);
+void matrix_relu(const ConstMatrixView& a, const MatrixView& out, size_t num_threads = 0);
+void matrix_relu(const ConstMatrixViewF32& a, const MatrixViewF32& out, size_t num_threads = 0);
+void matrix_relu(const MatrixView& a, size_t num_threads = 0);
+void matrix_relu(const MatrixViewF32& a, size_t num_threads = 0);
+void matrix_clamp(const ConstMatrixView& a, double lo, double hi, const MatrixView& out,
+                  size_t num_threads = 0);
+void matrix_clamp(const ConstMatrixViewF32& a, float lo, float hi, const MatrixViewF32& out,
+                  size_t num_threads = 0);
+void matrix_clamp(const MatrixView& a, double lo, double hi, size_t num_threads = 0);
+void matrix_clamp(const MatrixViewF32& a, float lo, float hi, size_t num_threads = 0);
+
+// Benchmark function: element-wise GB/s against scalar loops, exp accuracy
+void benchmark_elementwise();
+
+#endif // ELEMENTWISE_H
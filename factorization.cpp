@@ -0,0 +1,425 @@
+#include "factorization.h"
+#include "reductions.h"
+#include "thread_pool.h"
+#include "transpose.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+// Columns per step of the blocked factorizations
+static const size_t kFactorBlock = 128;
+// Blocks at or below this size are solved or factored element by element;
+// larger ones are halved, with the coupling done by GEMM
+static const size_t kFactorLeaf = 16;
+// Right-hand-side columns per task in the element-wise solves
+static const size_t kSolveStripe = 256;
+
+// Runs fn(c0, c1) over stripes of [0, cols), in parallel for wide ranges
+template <typename F>
+static void for_each_stripe(size_t cols, size_t num_threads, const F& fn) {
+    const size_t stripes = (cols + kSolveStripe - 1) / kSolveStripe;
+    if (std::min(resolve_threads(num_threads), stripes) <= 1) {
+        fn(0, cols);
+        return;
+    }
+    parallel_blocks(stripes, cols, 0, num_threads, [&](size_t s) {
+        fn(s * kSolveStripe, std::min(cols, (s + 1) * kSolveStripe));
+    });
+}
+
+// One triangular solve: B = op(T)^-1 B
+template <typename T>
+struct TriangularSolve {
+    BasicConstMatrixView<T> t;
+    BasicMatrixView<T> b;
+    bool transposed;
+    bool unit;
+    size_t num_threads;
+
+    T op(size_t i, size_t j) const { return transposed ? t(j, i) : t(i, j); }
+
+    // op(T) rows [r0, r0 + r) x cols [c0, c0 + c); a transpose is copied
+    // into scratch
+    BasicConstMatrixView<T> block(size_t r0, size_t c0, size_t r, size_t c, BasicMatrix<T>& scratch) const {
+        if (!transposed) {
+            return t.submatrix(r0, c0, r, c);
+        }
+        scratch = BasicMatrix<T>(r, c);
+        transpose(c, r, t.row(c0) + r0, t.getStride(), scratch.row(0), scratch.getStride(), num_threads);
+        return scratch.view();
+    }
+
+    // Rows [r0, r0 + n) by substitution; forward when op(T) is lower
+    void leaf(size_t r0, size_t n, bool forward) const {
+        for_each_stripe(b.getCols(), num_threads, [&](size_t c0, size_t c1) {
+            for (size_t s = 0; s < n; s++) {
+                size_t i = r0 + (forward ? s : n - 1 - s);
+                T* bi = b.row(i);
+                size_t j_begin = forward ? r0 : i + 1;
+                size_t j_end = forward ? i : r0 + n;
+                for (size_t j = j_begin; j < j_end; j++) {
+                    T l = op(i, j);
+                    if (l == T(0)) {
+                        continue;
+                    }
+                    const T* bj = b.row(j);
+                    for (size_t c = c0; c < c1; c++) {
+                        bi[c] -= l * bj[c];
+                    }
+                }
+                if (!unit) {
+                    T d = op(i, i);
+                    for (size_t c = c0; c < c1; c++) {
+                        bi[c] /= d;
+                    }
+                }
+            }
+        });
+    }
+
+    // Rows [r0, r0 + n): solve one half, GEMM its contribution out of the
+    // other half, solve that
+    void solve(size_t r0, size_t n, bool forward) const {
+        if (n <= kFactorLeaf) {
+            leaf(r0, n, forward);
+            return;
+        }
+        const size_t cols = b.getCols();
+        const size_t n1 = (n / 2 + kFactorLeaf - 1) / kFactorLeaf * kFactorLeaf;
+        const size_t n2 = n - n1;
+        BasicMatrix<T> scratch(0, 0);
+        if (forward) {
+            solve(r0, n1, true);
+            gemm(-1, block(r0 + n1, r0, n2, n1, scratch), b.submatrix(r0, 0, n1, cols), 1,
+                 b.submatrix(r0 + n1, 0, n2, cols), num_threads);
+            solve(r0 + n1, n2, true);
+        } else {
+            solve(r0 + n1, n2, false);
+            gemm(-1, block(r0, r0 + n1, n1, n2, scratch), b.submatrix(r0 + n1, 0, n2, cols), 1,
+                 b.submatrix(r0, 0, n1, cols), num_threads);
+            solve(r0, n1, false);
+        }
+    }
+};
+
+template <typename T>
+static void triangular_solve_impl(Triangle uplo, bool transposed, Diagonal diag,
+                                  const BasicConstMatrixView<T>& t, const BasicMatrixView<T>& b,
+                                  size_t num_threads) {
+    if (t.getRows() != t.getCols() || t.getRows() != b.getRows()) {
+        throw std::runtime_error("Invalid matrix dimensions for triangular solve");
+    }
+    if (t.empty() || b.empty()) {
+        return;
+    }
+    TriangularSolve<T> s = { t, b, transposed, diag == Diagonal::Unit, num_threads };
+    s.solve(0, t.getRows(), (uplo == Triangle::Lower) != transposed);
+}
+
+// Row i swapped with row pivots[i], for i in [first, first + count), within
+// columns [c0, c0 + w)
+template <typename T>
+static void apply_swaps(const BasicMatrixView<T>& a, const std::vector<size_t>& pivots, size_t first,
+                        size_t count, size_t c0, size_t w) {
+    if (w == 0) {
+        return;
+    }
+    for (size_t i = first; i < first + count; i++) {
+        size_t p = pivots[i];
+        if (p != i) {
+            std::swap_ranges(a.row(i) + c0, a.row(i) + c0 + w, a.row(p) + c0);
+        }
+    }
+}
+
+// LU of the m x w panel whose top-left element (r0, r0) is on the diagonal,
+// swapping rows only within the panel's columns
+template <typename T>
+static void lu_panel(const BasicMatrixView<T>& a, std::vector<size_t>& pivots, size_t r0, size_t m,
+                     size_t w, size_t num_threads) {
+    if (w <= kFactorLeaf) {
+        for (size_t j = 0; j < w; j++) {
+            const size_t d = r0 + j;
+            size_t p = d;
+            T best = std::fabs(a(d, d));
+            for (size_t i = d + 1; i < r0 + m; i++) {
+                T v = std::fabs(a(i, d));
+                if (v > best) {
+                    best = v;
+                    p = i;
+                }
+            }
+            if (best == T(0)) {
+                throw std::runtime_error("Matrix is singular");
+            }
+            pivots[d] = p;
+            if (p != d) {
+                std::swap_ranges(a.row(d) + r0, a.row(d) + r0 + w, a.row(p) + r0);
+            }
+            const T pivot = a(d, d);
+            const T* u = a.row(d);
+            for (size_t i = d + 1; i < r0 + m; i++) {
+                T* row = a.row(i);
+                T l = row[d] / pivot;
+                row[d] = l;
+                for (size_t c = d + 1; c < r0 + w; c++) {
+                    row[c] -= l * u[c];
+                }
+            }
+        }
+        return;
+    }
+
+    const size_t w1 = (w / 2 + kFactorLeaf - 1) / kFactorLeaf * kFactorLeaf;
+    const size_t w2 = w - w1;
+    lu_panel(a, pivots, r0, m, w1, num_threads);
+    apply_swaps(a, pivots, r0, w1, r0 + w1, w2);
+    triangular_solve_impl<T>(Triangle::Lower, false, Diagonal::Unit, a.submatrix(r0, r0, w1, w1),
+                             a.submatrix(r0, r0 + w1, w1, w2), num_threads);
+    gemm(-1, a.submatrix(r0 + w1, r0, m - w1, w1), a.submatrix(r0, r0 + w1, w1, w2), 1,
+         a.submatrix(r0 + w1, r0 + w1, m - w1, w2), num_threads);
+    lu_panel(a, pivots, r0 + w1, m - w1, w2, num_threads);
+    apply_swaps(a, pivots, r0 + w1, w2, r0, w1);
+}
+
+template <typename T>
+static void lu_factor_impl(const BasicMatrixView<T>& a, std::vector<size_t>& pivots, size_t num_threads) {
+    if (a.getRows() != a.getCols()) {
+        throw std::runtime_error("LU factorization requires a square matrix");
+    }
+    const size_t n = a.getRows();
+    pivots.resize(n);
+    for (size_t k = 0; k < n; k += kFactorBlock) {
+        const size_t kb = std::min(kFactorBlock, n - k);
+        const size_t rest = n - k - kb;
+        lu_panel(a, pivots, k, n - k, kb, num_threads);
+        apply_swaps(a, pivots, k, kb, 0, k);
+        apply_swaps(a, pivots, k, kb, k + kb, rest);
+        if (rest == 0) {
+            break;
+        }
+        // U12 = L11^-1 A12, then A22 -= L21 U12
+        triangular_solve_impl<T>(Triangle::Lower, false, Diagonal::Unit, a.submatrix(k, k, kb, kb),
+                                 a.submatrix(k, k + kb, kb, rest), num_threads);
+        gemm(-1, a.submatrix(k + kb, k, rest, kb), a.submatrix(k, k + kb, kb, rest), 1,
+             a.submatrix(k + kb, k + kb, rest, rest), num_threads);
+    }
+}
+
+// Unblocked Cholesky of a diagonal block
+template <typename T>
+static void cholesky_block(const BasicMatrixView<T>& a) {
+    const size_t n = a.getRows();
+    for (size_t j = 0; j < n; j++) {
+        const T* rj = a.row(j);
+        T d = rj[j];
+        for (size_t p = 0; p < j; p++) {
+            d -= rj[p] * rj[p];
+        }
+        if (!(d > T(0))) {
+            throw std::runtime_error("Matrix is not positive definite");
+        }
+        d = std::sqrt(d);
+        a(j, j) = d;
+        for (size_t i = j + 1; i < n; i++) {
+            T* ri = a.row(i);
+            T v = ri[j];
+            for (size_t p = 0; p < j; p++) {
+                v -= ri[p] * rj[p];
+            }
+            ri[j] = v / d;
+        }
+    }
+}
+
+template <typename T>
+static void cholesky_factor_impl(const BasicMatrixView<T>& a, size_t num_threads) {
+    if (a.getRows() != a.getCols()) {
+        throw std::runtime_error("Cholesky factorization requires a square matrix");
+    }
+    const size_t n = a.getRows();
+    for (size_t k = 0; k < n; k += kFactorBlock) {
+        const size_t kb = std::min(kFactorBlock, n - k);
+        const size_t m = n - k - kb;
+        cholesky_block(a.submatrix(k, k, kb, kb));
+        if (m == 0) {
+            break;
+        }
+
+        // L21 = A21 L11^-T, computed transposed as L11^-1 A21^T; the
+        // transposed copy then feeds the update
+        BasicMatrixView<T> l21 = a.submatrix(k + kb, k, m, kb);
+        BasicMatrix<T> l21t(kb, m);
+        transpose(m, kb, l21.row(0), l21.getStride(), l21t.row(0), l21t.getStride(), num_threads);
+        triangular_solve_impl<T>(Triangle::Lower, false, Diagonal::NonUnit, a.submatrix(k, k, kb, kb),
+                                 l21t.view(), num_threads);
+        transpose(kb, m, l21t.row(0), l21t.getStride(), l21.row(0), l21.getStride(), num_threads);
+
+        // A22 -= L21 L21^T over the lower triangle, a block column at a time;
+        // diagonal blocks are computed aside so their upper part stays intact
+        BasicMatrix<T> diag(0, 0);
+        for (size_t j = 0; j < m; j += kFactorBlock) {
+            const size_t jb = std::min(kFactorBlock, m - j);
+            BasicConstMatrixView<T> right = l21t.submatrix(0, j, kb, jb);
+            if (diag.getRows() != jb) {
+                diag = BasicMatrix<T>(jb, jb);
+            }
+            gemm(1, l21.submatrix(j, 0, jb, kb), right, 0, diag.view(), num_threads);
+            for (size_t r = 0; r < jb; r++) {
+                T* dst = a.row(k + kb + j + r) + k + kb + j;
+                for (size_t c = 0; c <= r; c++) {
+                    dst[c] -= diag(r, c);
+                }
+            }
+            if (j + jb < m) {
+                gemm(-1, l21.submatrix(j + jb, 0, m - j - jb, kb), right, 1,
+                     a.submatrix(k + kb + j + jb, k + kb + j, m - j - jb, jb), num_threads);
+            }
+        }
+    }
+}
+
+template <typename T>
+static void lu_solve_impl(const BasicConstMatrixView<T>& lu, const std::vector<size_t>& pivots,
+                          const BasicMatrixView<T>& b, size_t num_threads) {
+    if (pivots.size() != lu.getRows()) {
+        throw std::runtime_error("LU pivots do not match the factor");
+    }
+    if (b.getRows() != lu.getRows()) {
+        throw std::runtime_error("Invalid matrix dimensions for triangular solve");
+    }
+    apply_swaps(b, pivots, 0, pivots.size(), 0, b.getCols());
+    triangular_solve_impl(Triangle::Lower, false, Diagonal::Unit, lu, b, num_threads);
+    triangular_solve_impl(Triangle::Upper, false, Diagonal::NonUnit, lu, b, num_threads);
+}
+
+template <typename T>
+static void cholesky_solve_impl(const BasicConstMatrixView<T>& l, const BasicMatrixView<T>& b,
+                                size_t num_threads) {
+    triangular_solve_impl(Triangle::Lower, false, Diagonal::NonUnit, l, b, num_threads);
+    triangular_solve_impl(Triangle::Lower, true, Diagonal::NonUnit, l, b, num_threads);
+}
+
+template <typename T>
+static BasicMatrix<T> solve_impl(const BasicConstMatrixView<T>& a, const BasicConstMatrixView<T>& b,
+                                 size_t num_threads) {
+    BasicMatrix<T> lu(a);
+    std::vector<size_t> pivots;
+    lu_factor_impl(lu.view(), pivots, num_threads);
+    BasicMatrix<T> x(b);
+    lu_solve_impl<T>(lu.view(), pivots, x.view(), num_threads);
+    return x;
+}
+
+void lu_factor(const MatrixView& a, std::vector<size_t>& pivots, size_t num_threads) {
+    lu_factor_impl(a, pivots, num_threads);
+}
+
+void lu_factor(const MatrixViewF32& a, std::vector<size_t>& pivots, size_t num_threads) {
+    lu_factor_impl(a, pivots, num_threads);
+}
+
+void cholesky_factor(const MatrixView& a, size_t num_threads) {
+    cholesky_factor_impl(a, num_threads);
+}
+
+void cholesky_factor(const MatrixViewF32& a, size_t num_threads) {
+    cholesky_factor_impl(a, num_threads);
+}
+
+void triangular_solve(Triangle uplo, bool transposed, Diagonal diag, const ConstMatrixView& t,
+                      const MatrixView& b, size_t num_threads) {
+    triangular_solve_impl(uplo, transposed, diag, t, b, num_threads);
+}
+
+void triangular_solve(Triangle uplo, bool transposed, Diagonal diag, const ConstMatrixViewF32& t,
+                      const MatrixViewF32& b, size_t num_threads) {
+    triangular_solve_impl(uplo, transposed, diag, t, b, num_threads);
+}
+
+void lu_solve(const ConstMatrixView& lu, const std::vector<size_t>& pivots, const MatrixView& b,
+              size_t num_threads) {
+    lu_solve_impl(lu, pivots, b, num_threads);
+}
+
+void lu_solve(const ConstMatrixViewF32& lu, const std::vector<size_t>& pivots, const MatrixViewF32& b,
+              size_t num_threads) {
+    lu_solve_impl(lu, pivots, b, num_threads);
+}
+
+void cholesky_solve(const ConstMatrixView& l, const MatrixView& b, size_t num_threads) {
+    cholesky_solve_impl(l, b, num_threads);
+}
+
+void cholesky_solve(const ConstMatrixViewF32& l, const MatrixViewF32& b, size_t num_threads) {
+    cholesky_solve_impl(l, b, num_threads);
+}
+
+Matrix solve(const ConstMatrixView& a, const ConstMatrixView& b, size_t num_threads) {
+    return solve_impl(a, b, num_threads);
+}
+
+MatrixF32 solve(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads) {
+    return solve_impl(a, b, num_threads);
+}
+
+static double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// ||A X - B|| / (||A|| ||X||), Frobenius norms
+static double relative_residual(const Matrix& a, const Matrix& x, const Matrix& b) {
+    Matrix r(b);
+    gemm(1, a.view(), x.view(), -1, r.view());
+    return norm_frobenius(r) / (norm_frobenius(a) * norm_frobenius(x));
+}
+
+static void benchmark_factorization_size(size_t n) {
+    Matrix a(n, n);
+    Matrix b(n, 16);
+    a.randomize();
+    b.randomize();
+    const double cube = static_cast<double>(n) * n * n;
+
+    Matrix c(n, n);
+    auto start = std::chrono::high_resolution_clock::now();
+    a.multiply_into(a, c);
+    double gemm_seconds = elapsed_seconds(start);
+
+    Matrix lu(a);
+    std::vector<size_t> pivots;
+    start = std::chrono::high_resolution_clock::now();
+    lu_factor(lu, pivots);
+    double lu_seconds = elapsed_seconds(start);
+    Matrix x(b);
+    lu_solve(lu, pivots, x);
+
+    // A A^T + n I is symmetric positive definite
+    Matrix at = a.transpose();
+    Matrix spd(n, n);
+    gemm(1, a.view(), at.view(), 0, spd.view());
+    for (size_t i = 0; i < n; i++) {
+        spd(i, i) += static_cast<double>(n);
+    }
+    Matrix l(spd);
+    start = std::chrono::high_resolution_clock::now();
+    cholesky_factor(l);
+    double chol_seconds = elapsed_seconds(start);
+    Matrix y(b);
+    cholesky_solve(l, y);
+
+    std::cout << n << "x" << n << ": gemm " << 2 * cube / gemm_seconds / 1e9 << " GFLOP/s, LU "
+              << 2 * cube / 3 / lu_seconds / 1e9 << " GFLOP/s (residual " << relative_residual(a, x, b)
+              << "), Cholesky " << cube / 3 / chol_seconds / 1e9 << " GFLOP/s (residual "
+              << relative_residual(spd, y, b) << ")" << std::endl;
+}
+
+void benchmark_factorization() {
+    std::cout << "\n=== Factorization Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    benchmark_factorization_size(500);
+    benchmark_factorization_size(2000);
+}
@@ -0,0 +1,58 @@
+#ifndef FACTORIZATION_H
+#define FACTORIZATION_H
+
+#include <cstddef>
+#include <vector>
+#include "matrix_operations.h"
+
+// Dense factorizations and triangular solves built on the GEMM engine.
+//
+// Both factorizations are right-looking and blocked: a narrow panel is
+// factored, then the trailing matrix is updated with one GEMM per block
+// step, so most of the work runs at multiply speed. LU factors its panel
+// recursively, so the panel updates are GEMMs too. num_threads caps the
+// worker count (0 = global pool); results do not depend on it.
+
+// Which triangle of a matrix holds the factor
+enum class Triangle { Lower, Upper };
+// Unit: the diagonal is taken as all ones and never read
+enum class Diagonal { NonUnit, Unit };
+
+// P A = L U in place for square A, with partial pivoting. On return the
+// strict lower triangle holds L (unit diagonal, not stored) and the upper
+// triangle holds U. Row i was swapped with row pivots[i] at step i, in
+// order. Throws std::runtime_error if a pivot is exactly zero.
+void lu_factor(const MatrixView& a, std::vector<size_t>& pivots, size_t num_threads = 0);
+void lu_factor(const MatrixViewF32& a, std::vector<size_t>& pivots, size_t num_threads = 0);
+
+// A = L L^T in place for symmetric positive definite A. Only the lower
+// triangle is read and overwritten with L; the strict upper triangle is
+// left untouched. Throws std::runtime_error if A is not positive definite.
+void cholesky_factor(const MatrixView& a, size_t num_threads = 0);
+void cholesky_factor(const MatrixViewF32& a, size_t num_threads = 0);
+
+// B = op(T)^-1 B in place, where op(T) is T or its transpose and T is the
+// given triangle of t (n x n); B is n x nrhs. t and b must not overlap.
+void triangular_solve(Triangle uplo, bool transposed, Diagonal diag, const ConstMatrixView& t,
+                      const MatrixView& b, size_t num_threads = 0);
+void triangular_solve(Triangle uplo, bool transposed, Diagonal diag, const ConstMatrixViewF32& t,
+                      const MatrixViewF32& b, size_t num_threads = 0);
+
+// B = A^-1 B from lu_factor's output
+void lu_solve(const ConstMatrixView& lu, const std::vector<size_t>& pivots, const MatrixView& b,
+              size_t num_threads = 0);
+void lu_solve(const ConstMatrixViewF32& lu, const std::vector<size_t>& pivots, const MatrixViewF32& b,
+              size_t num_threads = 0);
+
+// B = A^-1 B from cholesky_factor's output
+void cholesky_solve(const ConstMatrixView& l, const MatrixView& b, size_t num_threads = 0);
+void cholesky_solve(const ConstMatrixViewF32& l, const MatrixViewF32& b, size_t num_threads = 0);
+
+// X solving A X = B by LU, leaving A and B unchanged
+Matrix solve(const ConstMatrixView& a, const ConstMatrixView& b, size_t num_threads = 0);
+MatrixF32 solve(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, size_t num_threads = 0);
+
+// Benchmark function: LU and Cholesky GFLOP/s against GEMM, with residuals
+void benchmark_factorization();
+
+#endif // FACTORIZATION_H
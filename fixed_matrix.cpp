@@ -0,0 +1,64 @@
+#include "fixed_matrix.h"
+#include "matrix_operations.h"
+#include "random_fill.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+void fixed_matrix_randomize(double* data, size_t rows, size_t cols) {
+    random_uniform(MatrixView(data, rows, cols, cols), 0.0, 10.0, get_random_seed(), next_random_stream());
+}
+
+// Multiply count pairs drawn from a small working set that stays in L1, so
+// the timing reflects per-multiply overhead rather than memory traffic
+template <size_t N>
+static void run_small_matrix_benchmark(size_t count) {
+    const size_t pool = 256;
+    std::vector<FixedMatrix<N, N> > a(pool);
+    std::vector<FixedMatrix<N, N> > b(pool);
+    for (size_t i = 0; i < pool; i++) {
+        a[i].randomize();
+        b[i].randomize();
+    }
+
+    double checksum = 0.0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        FixedMatrix<N, N> c = a[i % pool].multiply(b[(i * 7) % pool]);
+        checksum += c(i % N, 0);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    // Same work through the heap-allocated Matrix, at a tenth of the count
+    const size_t dynamic_count = count / 10;
+    Matrix da(N, N);
+    Matrix db(N, N);
+    da.randomize();
+    db.randomize();
+    double dynamic_checksum = 0.0;
+    auto dyn_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < dynamic_count; i++) {
+        Matrix dc = da.multiply(db);
+        dynamic_checksum += dc(i % N, 0);
+    }
+    auto dyn_end = std::chrono::high_resolution_clock::now();
+    double dyn_seconds = std::chrono::duration<double>(dyn_end - dyn_start).count();
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+    std::cout << "Matrix size: " << N << "x" << N << std::endl;
+    std::cout << "Multiplies: " << count << std::endl;
+    std::cout << "Time: " << duration.count() << " ms" << std::endl;
+    std::cout << "FixedMatrix: " << count / seconds / 1e6 << " M multiplies/s" << std::endl;
+    std::cout << "Matrix: " << dynamic_count / dyn_seconds / 1e6 << " M multiplies/s" << std::endl;
+    std::cout << "Checksum: " << checksum + dynamic_checksum << std::endl;
+}
+
+void benchmark_small_matrix_ops() {
+    std::cout << "\n=== Small Matrix Multiplication Benchmark ===" << std::endl;
+
+    run_small_matrix_benchmark<3>(4000000);
+    run_small_matrix_benchmark<4>(4000000);
+    run_small_matrix_benchmark<8>(1000000);
+}
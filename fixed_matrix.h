@@ -0,0 +1,148 @@
+#ifndef FIXED_MATRIX_H
+#define FIXED_MATRIX_H
+
+#include <cstddef>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define FIXED_MATRIX_X86_SIMD 1
+#else
+#define FIXED_MATRIX_X86_SIMD 0
+#endif
+
+// Fills rows x cols contiguous doubles with uniform [0, 10) values from the
+// process seed and the next stream, like Matrix::randomize (random_fill.h)
+void fixed_matrix_randomize(double* data, size_t rows, size_t cols);
+
+// Compile-time sized matrix stored inline (on the stack when local).
+// Same interface shape as Matrix, but no heap allocation, no stride
+// bookkeeping, and loop bounds the compiler can fully unroll.
+template <size_t R, size_t C>
+class FixedMatrix {
+private:
+    alignas(16) double data[R * C];
+
+public:
+    FixedMatrix() : data() {}
+
+    void randomize() { fixed_matrix_randomize(data, R, C); }
+
+    template <size_t K>
+    FixedMatrix<R, K> multiply(const FixedMatrix<C, K>& other) const;
+
+    double sum() const {
+        double total = 0.0;
+        for (size_t i = 0; i < R * C; i++) {
+            total += data[i];
+        }
+        return total;
+    }
+
+    size_t getRows() const { return R; }
+    size_t getCols() const { return C; }
+    size_t getStride() const { return C; }
+
+    double* row(size_t i) { return data + i * C; }
+    const double* row(size_t i) const { return data + i * C; }
+
+    double& operator()(size_t i, size_t j) { return data[i * C + j]; }
+    double operator()(size_t i, size_t j) const { return data[i * C + j]; }
+};
+
+// out = a * b for any shape; constant trip counts let the compiler unroll
+template <size_t R, size_t C, size_t K>
+inline void fixed_multiply(const FixedMatrix<R, C>& a, const FixedMatrix<C, K>& b,
+                           FixedMatrix<R, K>& out) {
+    for (size_t i = 0; i < R; i++) {
+        double acc[K] = {};
+        for (size_t k = 0; k < C; k++) {
+            const double aik = a(i, k);
+            const double* brow = b.row(k);
+            for (size_t j = 0; j < K; j++) {
+                acc[j] += aik * brow[j];
+            }
+        }
+        double* orow = out.row(i);
+        for (size_t j = 0; j < K; j++) {
+            orow[j] = acc[j];
+        }
+    }
+}
+
+// 3x3: odd width does not map onto SIMD pairs, so unroll it as scalars
+inline void fixed_multiply(const FixedMatrix<3, 3>& a, const FixedMatrix<3, 3>& b,
+                           FixedMatrix<3, 3>& out) {
+    for (size_t i = 0; i < 3; i++) {
+        const double a0 = a(i, 0), a1 = a(i, 1), a2 = a(i, 2);
+        out(i, 0) = a0 * b(0, 0) + a1 * b(1, 0) + a2 * b(2, 0);
+        out(i, 1) = a0 * b(0, 1) + a1 * b(1, 1) + a2 * b(2, 1);
+        out(i, 2) = a0 * b(0, 2) + a1 * b(1, 2) + a2 * b(2, 2);
+    }
+}
+
+#if FIXED_MATRIX_X86_SIMD
+// 4x4: B held in 8 registers, each output row is 4 broadcast multiply-adds
+inline void fixed_multiply(const FixedMatrix<4, 4>& a, const FixedMatrix<4, 4>& b,
+                           FixedMatrix<4, 4>& out) {
+    const __m128d b00 = _mm_load_pd(b.row(0)), b01 = _mm_load_pd(b.row(0) + 2);
+    const __m128d b10 = _mm_load_pd(b.row(1)), b11 = _mm_load_pd(b.row(1) + 2);
+    const __m128d b20 = _mm_load_pd(b.row(2)), b21 = _mm_load_pd(b.row(2) + 2);
+    const __m128d b30 = _mm_load_pd(b.row(3)), b31 = _mm_load_pd(b.row(3) + 2);
+
+#define FIXED_MATRIX_ROW4(i)                                                   \
+    {                                                                          \
+        const __m128d a0 = _mm_set1_pd(a(i, 0)), a1 = _mm_set1_pd(a(i, 1));    \
+        const __m128d a2 = _mm_set1_pd(a(i, 2)), a3 = _mm_set1_pd(a(i, 3));    \
+        __m128d lo = _mm_add_pd(_mm_mul_pd(a0, b00), _mm_mul_pd(a1, b10));     \
+        __m128d hi = _mm_add_pd(_mm_mul_pd(a0, b01), _mm_mul_pd(a1, b11));     \
+        lo = _mm_add_pd(lo, _mm_add_pd(_mm_mul_pd(a2, b20), _mm_mul_pd(a3, b30))); \
+        hi = _mm_add_pd(hi, _mm_add_pd(_mm_mul_pd(a2, b21), _mm_mul_pd(a3, b31))); \
+        _mm_store_pd(out.row(i), lo);                                          \
+        _mm_store_pd(out.row(i) + 2, hi);                                      \
+    }
+    FIXED_MATRIX_ROW4(0)
+    FIXED_MATRIX_ROW4(1)
+    FIXED_MATRIX_ROW4(2)
+    FIXED_MATRIX_ROW4(3)
+#undef FIXED_MATRIX_ROW4
+}
+
+// 8x8: each output row lives in 4 accumulators across the unrolled k loop
+inline void fixed_multiply(const FixedMatrix<8, 8>& a, const FixedMatrix<8, 8>& b,
+                           FixedMatrix<8, 8>& out) {
+    for (size_t i = 0; i < 8; i++) {
+        __m128d c0 = _mm_setzero_pd(), c1 = _mm_setzero_pd();
+        __m128d c2 = _mm_setzero_pd(), c3 = _mm_setzero_pd();
+#define FIXED_MATRIX_STEP8(k)                                                  \
+        {                                                                      \
+            const __m128d aik = _mm_set1_pd(a(i, k));                          \
+            const double* brow = b.row(k);                                     \
+            c0 = _mm_add_pd(c0, _mm_mul_pd(aik, _mm_load_pd(brow)));           \
+            c1 = _mm_add_pd(c1, _mm_mul_pd(aik, _mm_load_pd(brow + 2)));       \
+            c2 = _mm_add_pd(c2, _mm_mul_pd(aik, _mm_load_pd(brow + 4)));       \
+            c3 = _mm_add_pd(c3, _mm_mul_pd(aik, _mm_load_pd(brow + 6)));       \
+        }
+        FIXED_MATRIX_STEP8(0) FIXED_MATRIX_STEP8(1) FIXED_MATRIX_STEP8(2) FIXED_MATRIX_STEP8(3)
+        FIXED_MATRIX_STEP8(4) FIXED_MATRIX_STEP8(5) FIXED_MATRIX_STEP8(6) FIXED_MATRIX_STEP8(7)
+#undef FIXED_MATRIX_STEP8
+        double* orow = out.row(i);
+        _mm_store_pd(orow, c0);
+        _mm_store_pd(orow + 2, c1);
+        _mm_store_pd(orow + 4, c2);
+        _mm_store_pd(orow + 6, c3);
+    }
+}
+#endif
+
+template <size_t R, size_t C>
+template <size_t K>
+FixedMatrix<R, K> FixedMatrix<R, C>::multiply(const FixedMatrix<C, K>& other) const {
+    FixedMatrix<R, K> result;
+    fixed_multiply(*this, other, result);
+    return result;
+}
+
+// Benchmark function: millions of 3x3, 4x4 and 8x8 multiplies
+void benchmark_small_matrix_ops();
+
+#endif // FIXED_MATRIX_H
@@ -0,0 +1,1000 @@
+#include "gemm.h"
+#include "cpu_features.h"
+#include "gemm_tuner.h"
+#include "memory_operations.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// GotoBLAS-style GEMM: B is packed into kc x nc panels, A into mc x kc
+// blocks, and a register-blocked micro-kernel computes one MR x NR tile of C
+// from an MR-row sliver of packed A and an NR-column sliver of packed B.
+//
+// C is split into a fixed grid of mc x nc tiles, each computed start to
+// finish (all of k) by one thread with its own packing buffers. The grid
+// depends only on the problem shape and the blocking, never on the thread
+// count, so every element sees the same sequence of operations and the
+// result is bit-identical however many threads run.
+//
+// The driver is templated on the compute type T (double or float) and the
+// storage type S of A and B. bf16/fp16 operands are widened to float while
+// packing, so they run the fp32 micro-kernels and accumulate in fp32.
+
+// C[mr x nr] = alpha * A_sliver * B_sliver + beta * C (C not read if beta == 0)
+template <typename T>
+struct GemmKernel {
+    typedef void (*MicroKernel)(size_t kc, T alpha, const T* a, const T* b,
+                                T beta, T* c, size_t ldc);
+    size_t mr;
+    size_t nr;
+    MicroKernel fn;
+};
+
+// Largest micro-tile of any kernel, for the edge scratch tile
+static const size_t kMaxTile = 8 * 16;
+
+static GemmBlocking g_blocking = { 128, 256, 512 };
+static std::once_flag g_blocking_once;
+
+// Tuned settings for this CPU from the profile file (gemm_tuner.h), read once
+static const GemmProfile* startup_profile() {
+    static GemmProfile profile;
+    static const bool found = gemm_load_profile(gemm_profile_path(), cpu_model_name(), profile);
+    return found ? &profile : nullptr;
+}
+
+// The profile's blocking replaces the defaults before anything reads or sets them
+static void load_startup_blocking() {
+    std::call_once(g_blocking_once, [] {
+        const GemmProfile* profile = startup_profile();
+        if (profile != nullptr) {
+            g_blocking = profile->blocking;
+        }
+    });
+}
+
+GemmBlocking gemm_get_blocking() {
+    load_startup_blocking();
+    return g_blocking;
+}
+
+void gemm_set_blocking(const GemmBlocking& blocking) {
+    load_startup_blocking();
+    GemmBlocking b = blocking;
+    // mc and nc are rounded to the active kernel's tile at multiply time
+    b.mc = std::max<size_t>(1, b.mc);
+    b.kc = std::max<size_t>(1, b.kc);
+    b.nc = std::max<size_t>(1, b.nc);
+    g_blocking = b;
+}
+
+static thread_local ScratchBuffer t_packed_a;
+static thread_local ScratchBuffer t_packed_b;
+static thread_local ScratchBuffer t_batch_c;
+
+// Copy n contiguous elements of a B row into the packed panel, widening
+// 16-bit storage with the vectorized converters
+template <typename T, typename S>
+static inline void copy_row(const S* src, size_t n, T* dst) {
+    for (size_t c = 0; c < n; c++) {
+        dst[c] = static_cast<T>(src[c]);
+    }
+}
+
+static inline void copy_row(const bfloat16* src, size_t n, float* dst) {
+    convert_to_float(src, dst, n);
+}
+
+static inline void copy_row(const float16* src, size_t n, float* dst) {
+    convert_to_float(src, dst, n);
+}
+
+// Pack an mc x kc block of A into mr-row slivers, k-major within a sliver.
+// Rows past the edge of A are zero-filled so the micro-kernel never branches.
+template <typename T, typename S>
+static void pack_a(size_t mr, size_t mc, size_t kc, const S* a, size_t lda, T* dst) {
+    for (size_t i = 0; i < mc; i += mr) {
+        size_t rows = std::min(mr, mc - i);
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t r = 0; r < rows; r++) {
+                dst[r] = static_cast<T>(a[(i + r) * lda + p]);
+            }
+            for (size_t r = rows; r < mr; r++) {
+                dst[r] = T(0);
+            }
+            dst += mr;
+        }
+    }
+}
+
+// Pack a kc x nc panel of B into nr-column slivers, k-major within a sliver
+template <typename T, typename S>
+static void pack_b(size_t nr, size_t kc, size_t nc, const S* b, size_t ldb, T* dst) {
+    for (size_t j = 0; j < nc; j += nr) {
+        size_t cols = std::min(nr, nc - j);
+        for (size_t p = 0; p < kc; p++) {
+            copy_row(b + p * ldb + j, cols, dst);
+            for (size_t c = cols; c < nr; c++) {
+                dst[c] = T(0);
+            }
+            dst += nr;
+        }
+    }
+}
+
+// Fallback scalar implementation, 4x4 tile
+template <typename T>
+static void gemm_kernel_scalar(size_t kc, T alpha, const T* a, const T* b,
+                               T beta, T* c, size_t ldc) {
+    T acc[4][4] = {};
+    for (size_t p = 0; p < kc; p++) {
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t j = 0; j < 4; j++) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += 4;
+        b += 4;
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        T* row = c + i * ldc;
+        for (size_t j = 0; j < 4; j++) {
+            T v = alpha * acc[i][j];
+            if (beta != T(0)) {
+                v += beta * row[j];
+            }
+            row[j] = v;
+        }
+    }
+}
+
+#if USE_X86_SIMD
+// SSE2 baseline, 4x4 tile in 8 accumulators
+static void dgemm_kernel_sse2(size_t kc, double alpha, const double* a, const double* b,
+                              double beta, double* c, size_t ldc) {
+    __m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+    __m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+    __m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+    __m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+
+    for (size_t p = 0; p < kc; p++) {
+        __m128d b0 = _mm_load_pd(b);
+        __m128d b1 = _mm_load_pd(b + 2);
+
+        __m128d a0 = _mm_set1_pd(a[0]);
+        c00 = _mm_add_pd(c00, _mm_mul_pd(a0, b0));
+        c01 = _mm_add_pd(c01, _mm_mul_pd(a0, b1));
+        __m128d a1 = _mm_set1_pd(a[1]);
+        c10 = _mm_add_pd(c10, _mm_mul_pd(a1, b0));
+        c11 = _mm_add_pd(c11, _mm_mul_pd(a1, b1));
+        __m128d a2 = _mm_set1_pd(a[2]);
+        c20 = _mm_add_pd(c20, _mm_mul_pd(a2, b0));
+        c21 = _mm_add_pd(c21, _mm_mul_pd(a2, b1));
+        __m128d a3 = _mm_set1_pd(a[3]);
+        c30 = _mm_add_pd(c30, _mm_mul_pd(a3, b0));
+        c31 = _mm_add_pd(c31, _mm_mul_pd(a3, b1));
+
+        a += 4;
+        b += 4;
+    }
+
+    __m128d acc[4][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+    __m128d alpha_vec = _mm_set1_pd(alpha);
+    __m128d beta_vec = _mm_set1_pd(beta);
+    for (size_t i = 0; i < 4; i++) {
+        double* row = c + i * ldc;
+        for (size_t h = 0; h < 2; h++) {
+            __m128d v = _mm_mul_pd(alpha_vec, acc[i][h]);
+            if (beta != 0.0) {
+                v = _mm_add_pd(v, _mm_mul_pd(beta_vec, _mm_loadu_pd(row + 2 * h)));
+            }
+            _mm_storeu_pd(row + 2 * h, v);
+        }
+    }
+}
+
+// AVX2 + FMA, 4x8 tile in 8 accumulators
+TARGET_AVX2
+static void dgemm_kernel_avx2(size_t kc, double alpha, const double* a, const double* b,
+                              double beta, double* c, size_t ldc) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+    for (size_t p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_load_pd(b);
+        __m256d b1 = _mm256_load_pd(b + 4);
+
+        __m256d a0 = _mm256_broadcast_sd(a);
+        c00 = _mm256_fmadd_pd(a0, b0, c00);
+        c01 = _mm256_fmadd_pd(a0, b1, c01);
+        __m256d a1 = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(a1, b0, c10);
+        c11 = _mm256_fmadd_pd(a1, b1, c11);
+        __m256d a2 = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(a2, b0, c20);
+        c21 = _mm256_fmadd_pd(a2, b1, c21);
+        __m256d a3 = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(a3, b0, c30);
+        c31 = _mm256_fmadd_pd(a3, b1, c31);
+
+        a += 4;
+        b += 8;
+    }
+
+    __m256d acc[4][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+    __m256d alpha_vec = _mm256_set1_pd(alpha);
+    __m256d beta_vec = _mm256_set1_pd(beta);
+    for (size_t i = 0; i < 4; i++) {
+        double* row = c + i * ldc;
+        for (size_t h = 0; h < 2; h++) {
+            __m256d v = _mm256_mul_pd(alpha_vec, acc[i][h]);
+            if (beta != 0.0) {
+                v = _mm256_fmadd_pd(beta_vec, _mm256_loadu_pd(row + 4 * h), v);
+            }
+            _mm256_storeu_pd(row + 4 * h, v);
+        }
+    }
+}
+
+// AVX-512F, 8x8 tile with one zmm accumulator per row
+TARGET_AVX512
+static void dgemm_kernel_avx512(size_t kc, double alpha, const double* a, const double* b,
+                                double beta, double* c, size_t ldc) {
+    __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd();
+    __m512d c2 = _mm512_setzero_pd(), c3 = _mm512_setzero_pd();
+    __m512d c4 = _mm512_setzero_pd(), c5 = _mm512_setzero_pd();
+    __m512d c6 = _mm512_setzero_pd(), c7 = _mm512_setzero_pd();
+
+    for (size_t p = 0; p < kc; p++) {
+        __m512d b0 = _mm512_load_pd(b);
+
+        c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[0]), b0, c0);
+        c1 = _mm512_fmadd_pd(_mm512_set1_pd(a[1]), b0, c1);
+        c2 = _mm512_fmadd_pd(_mm512_set1_pd(a[2]), b0, c2);
+        c3 = _mm512_fmadd_pd(_mm512_set1_pd(a[3]), b0, c3);
+        c4 = _mm512_fmadd_pd(_mm512_set1_pd(a[4]), b0, c4);
+        c5 = _mm512_fmadd_pd(_mm512_set1_pd(a[5]), b0, c5);
+        c6 = _mm512_fmadd_pd(_mm512_set1_pd(a[6]), b0, c6);
+        c7 = _mm512_fmadd_pd(_mm512_set1_pd(a[7]), b0, c7);
+
+        a += 8;
+        b += 8;
+    }
+
+    __m512d acc[8] = { c0, c1, c2, c3, c4, c5, c6, c7 };
+    __m512d alpha_vec = _mm512_set1_pd(alpha);
+    __m512d beta_vec = _mm512_set1_pd(beta);
+    for (size_t i = 0; i < 8; i++) {
+        double* row = c + i * ldc;
+        __m512d v = _mm512_mul_pd(alpha_vec, acc[i]);
+        if (beta != 0.0) {
+            v = _mm512_fmadd_pd(beta_vec, _mm512_loadu_pd(row), v);
+        }
+        _mm512_storeu_pd(row, v);
+    }
+}
+
+// SSE, 4x8 float tile in 8 accumulators
+static void sgemm_kernel_sse2(size_t kc, float alpha, const float* a, const float* b,
+                              float beta, float* c, size_t ldc) {
+    __m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+    __m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+    __m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+    __m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+
+    for (size_t p = 0; p < kc; p++) {
+        __m128 b0 = _mm_load_ps(b);
+        __m128 b1 = _mm_load_ps(b + 4);
+
+        __m128 a0 = _mm_set1_ps(a[0]);
+        c00 = _mm_add_ps(c00, _mm_mul_ps(a0, b0));
+        c01 = _mm_add_ps(c01, _mm_mul_ps(a0, b1));
+        __m128 a1 = _mm_set1_ps(a[1]);
+        c10 = _mm_add_ps(c10, _mm_mul_ps(a1, b0));
+        c11 = _mm_add_ps(c11, _mm_mul_ps(a1, b1));
+        __m128 a2 = _mm_set1_ps(a[2]);
+        c20 = _mm_add_ps(c20, _mm_mul_ps(a2, b0));
+        c21 = _mm_add_ps(c21, _mm_mul_ps(a2, b1));
+        __m128 a3 = _mm_set1_ps(a[3]);
+        c30 = _mm_add_ps(c30, _mm_mul_ps(a3, b0));
+        c31 = _mm_add_ps(c31, _mm_mul_ps(a3, b1));
+
+        a += 4;
+        b += 8;
+    }
+
+    __m128 acc[4][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+    __m128 alpha_vec = _mm_set1_ps(alpha);
+    __m128 beta_vec = _mm_set1_ps(beta);
+    for (size_t i = 0; i < 4; i++) {
+        float* row = c + i * ldc;
+        for (size_t h = 0; h < 2; h++) {
+            __m128 v = _mm_mul_ps(alpha_vec, acc[i][h]);
+            if (beta != 0.0f) {
+                v = _mm_add_ps(v, _mm_mul_ps(beta_vec, _mm_loadu_ps(row + 4 * h)));
+            }
+            _mm_storeu_ps(row + 4 * h, v);
+        }
+    }
+}
+
+// AVX2 + FMA, 4x16 float tile in 8 accumulators
+TARGET_AVX2
+static void sgemm_kernel_avx2(size_t kc, float alpha, const float* a, const float* b,
+                              float beta, float* c, size_t ldc) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+    for (size_t p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+
+        __m256 a0 = _mm256_broadcast_ss(a);
+        c00 = _mm256_fmadd_ps(a0, b0, c00);
+        c01 = _mm256_fmadd_ps(a0, b1, c01);
+        __m256 a1 = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(a1, b0, c10);
+        c11 = _mm256_fmadd_ps(a1, b1, c11);
+        __m256 a2 = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(a2, b0, c20);
+        c21 = _mm256_fmadd_ps(a2, b1, c21);
+        __m256 a3 = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(a3, b0, c30);
+        c31 = _mm256_fmadd_ps(a3, b1, c31);
+
+        a += 4;
+        b += 16;
+    }
+
+    __m256 acc[4][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+    __m256 alpha_vec = _mm256_set1_ps(alpha);
+    __m256 beta_vec = _mm256_set1_ps(beta);
+    for (size_t i = 0; i < 4; i++) {
+        float* row = c + i * ldc;
+        for (size_t h = 0; h < 2; h++) {
+            __m256 v = _mm256_mul_ps(alpha_vec, acc[i][h]);
+            if (beta != 0.0f) {
+                v = _mm256_fmadd_ps(beta_vec, _mm256_loadu_ps(row + 8 * h), v);
+            }
+            _mm256_storeu_ps(row + 8 * h, v);
+        }
+    }
+}
+
+// AVX-512F, 8x16 float tile with one zmm accumulator per row
+TARGET_AVX512
+static void sgemm_kernel_avx512(size_t kc, float alpha, const float* a, const float* b,
+                                float beta, float* c, size_t ldc) {
+    __m512 c0 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps();
+    __m512 c2 = _mm512_setzero_ps(), c3 = _mm512_setzero_ps();
+    __m512 c4 = _mm512_setzero_ps(), c5 = _mm512_setzero_ps();
+    __m512 c6 = _mm512_setzero_ps(), c7 = _mm512_setzero_ps();
+
+    for (size_t p = 0; p < kc; p++) {
+        __m512 b0 = _mm512_load_ps(b);
+
+        c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), b0, c0);
+        c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), b0, c1);
+        c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), b0, c2);
+        c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), b0, c3);
+        c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), b0, c4);
+        c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), b0, c5);
+        c6 = _mm512_fmadd_ps(_mm512_set1_ps(a[6]), b0, c6);
+        c7 = _mm512_fmadd_ps(_mm512_set1_ps(a[7]), b0, c7);
+
+        a += 8;
+        b += 16;
+    }
+
+    __m512 acc[8] = { c0, c1, c2, c3, c4, c5, c6, c7 };
+    __m512 alpha_vec = _mm512_set1_ps(alpha);
+    __m512 beta_vec = _mm512_set1_ps(beta);
+    for (size_t i = 0; i < 8; i++) {
+        float* row = c + i * ldc;
+        __m512 v = _mm512_mul_ps(alpha_vec, acc[i]);
+        if (beta != 0.0f) {
+            v = _mm512_fmadd_ps(beta_vec, _mm512_loadu_ps(row), v);
+        }
+        _mm512_storeu_ps(row, v);
+    }
+}
+#endif
+
+// Instruction set levels, best first. Every precision has one kernel per
+// level, in the same order, so one selection covers all of them.
+static const char* const kKernelLevels[] = {
+#if USE_X86_SIMD
+    "avx512", "avx2", "sse2",
+#endif
+    "scalar",
+};
+static const size_t kNumKernelLevels = sizeof(kKernelLevels) / sizeof(kKernelLevels[0]);
+
+template <typename T>
+struct KernelTable;
+
+template <>
+struct KernelTable<double> {
+    static const GemmKernel<double> kernels[kNumKernelLevels];
+};
+
+const GemmKernel<double> KernelTable<double>::kernels[kNumKernelLevels] = {
+#if USE_X86_SIMD
+    { 8, 8, dgemm_kernel_avx512 },
+    { 4, 8, dgemm_kernel_avx2 },
+    { 4, 4, dgemm_kernel_sse2 },
+#endif
+    { 4, 4, gemm_kernel_scalar<double> },
+};
+
+template <>
+struct KernelTable<float> {
+    static const GemmKernel<float> kernels[kNumKernelLevels];
+};
+
+const GemmKernel<float> KernelTable<float>::kernels[kNumKernelLevels] = {
+#if USE_X86_SIMD
+    { 8, 16, sgemm_kernel_avx512 },
+    { 4, 16, sgemm_kernel_avx2 },
+    { 4, 8, sgemm_kernel_sse2 },
+#endif
+    { 4, 4, gemm_kernel_scalar<float> },
+};
+
+static bool level_supported(size_t level) {
+    const CpuFeatures& cpu = cpu_features();
+    const char* name = kKernelLevels[level];
+    if (std::strcmp(name, "avx512") == 0) {
+        return cpu.avx512f;
+    }
+    if (std::strcmp(name, "avx2") == 0) {
+        return cpu.avx2 && cpu.fma;
+    }
+    if (std::strcmp(name, "sse2") == 0) {
+        return cpu.sse2;
+    }
+    return true;
+}
+
+static int find_level(const char* name) {
+    for (size_t i = 0; i < kNumKernelLevels; i++) {
+        if (std::strcmp(kKernelLevels[i], name) == 0 && level_supported(i)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Picked once: the GEMM_KERNEL override if set and usable, else the tuned
+// profile's kernel, else the best supported
+static int select_startup_level() {
+    const char* forced = std::getenv("GEMM_KERNEL");
+    if (forced != nullptr && *forced != '\0') {
+        int level = find_level(forced);
+        if (level >= 0) {
+            return level;
+        }
+        std::cerr << "GEMM_KERNEL=" << forced
+                  << " is unknown or unsupported on this CPU, ignoring" << std::endl;
+    }
+    const GemmProfile* profile = startup_profile();
+    if (profile != nullptr) {
+        int level = find_level(profile->kernel.c_str());
+        if (level >= 0) {
+            return level;
+        }
+    }
+    for (size_t i = 0; i < kNumKernelLevels; i++) {
+        if (level_supported(i)) {
+            return static_cast<int>(i);
+        }
+    }
+    return static_cast<int>(kNumKernelLevels - 1);
+}
+
+static std::atomic<int> g_kernel_level(-1);
+
+static size_t active_level() {
+    int level = g_kernel_level.load();
+    if (level < 0) {
+        static const int startup = select_startup_level();
+        int expected = -1;
+        g_kernel_level.compare_exchange_strong(expected, startup);
+        level = g_kernel_level.load();
+    }
+    return static_cast<size_t>(level);
+}
+
+const char* gemm_kernel_name() {
+    return kKernelLevels[active_level()];
+}
+
+bool gemm_set_kernel(const char* name) {
+    int level = find_level(name);
+    if (level < 0) {
+        return false;
+    }
+    g_kernel_level.store(level);
+    return true;
+}
+
+// Multiply a packed mc x kc block of A by a packed kc x nc panel of B into C
+template <typename T>
+static void macro_kernel(const GemmKernel<T>& kernel, size_t mc, size_t nc, size_t kc,
+                         T alpha, const T* packed_a, const T* packed_b,
+                         T beta, T* c, size_t ldc) {
+    const size_t mr = kernel.mr;
+    const size_t nr = kernel.nr;
+    T edge[kMaxTile];
+
+    for (size_t j = 0; j < nc; j += nr) {
+        size_t cols = std::min(nr, nc - j);
+        const T* b = packed_b + j * kc;
+
+        for (size_t i = 0; i < mc; i += mr) {
+            size_t rows = std::min(mr, mc - i);
+            const T* a = packed_a + i * kc;
+            T* ct = c + i * ldc + j;
+
+            if (rows == mr && cols == nr) {
+                kernel.fn(kc, alpha, a, b, beta, ct, ldc);
+                continue;
+            }
+
+            // Partial tile: compute the full tile aside, then merge the valid part
+            kernel.fn(kc, alpha, a, b, T(0), edge, nr);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t s = 0; s < cols; s++) {
+                    T v = edge[r * nr + s];
+                    if (beta != T(0)) {
+                        v += beta * ct[r * ldc + s];
+                    }
+                    ct[r * ldc + s] = v;
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+static void scale_c(size_t m, size_t n, T beta, T* c, size_t ldc) {
+    for (size_t i = 0; i < m; i++) {
+        T* row = c + i * ldc;
+        for (size_t j = 0; j < n; j++) {
+            row[j] = (beta == T(0)) ? T(0) : beta * row[j];
+        }
+    }
+}
+
+// Below this many multiply-adds a parallel launch costs more than it saves
+static const double kParallelMinFlops = 64.0 * 64.0 * 64.0;
+
+// Compute one mc x nc tile of C over the full depth k
+template <typename T, typename S>
+static void gemm_tile(const GemmKernel<T>& kernel, size_t mc, size_t nc, size_t k, size_t kc_block,
+                      T alpha, const S* a, size_t lda,
+                      const S* b, size_t ldb,
+                      T beta, T* c, size_t ldc) {
+    const size_t mr = kernel.mr;
+    const size_t nr = kernel.nr;
+    size_t kc_max = std::min(kc_block, k);
+    T* packed_a = t_packed_a.reserve<T>(((mc + mr - 1) / mr * mr) * kc_max);
+    T* packed_b = t_packed_b.reserve<T>(kc_max * ((nc + nr - 1) / nr * nr));
+
+    for (size_t pc = 0; pc < k; pc += kc_block) {
+        size_t kc = std::min(kc_block, k - pc);
+        // beta applies once; later depth slices accumulate into C
+        T beta_pc = (pc == 0) ? beta : T(1);
+        pack_b(nr, kc, nc, b + pc * ldb, ldb, packed_b);
+        pack_a(mr, mc, kc, a + pc, lda, packed_a);
+        macro_kernel(kernel, mc, nc, kc, alpha, packed_a, packed_b, beta_pc, c, ldc);
+    }
+}
+
+template <typename T, typename S>
+static void gemm_driver(size_t m, size_t n, size_t k,
+                        T alpha, const S* a, size_t lda,
+                        const S* b, size_t ldb,
+                        T beta, T* c, size_t ldc,
+                        size_t num_threads) {
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0 || alpha == T(0)) {
+        if (beta != T(1)) {
+            scale_c(m, n, beta, c, ldc);
+        }
+        return;
+    }
+
+    // One kernel for the whole call keeps every tile's arithmetic identical
+    const GemmKernel<T>& kernel = KernelTable<T>::kernels[active_level()];
+    const GemmBlocking blk = gemm_get_blocking();
+    const size_t mc_block = std::max(kernel.mr, blk.mc / kernel.mr * kernel.mr);
+    const size_t nc_block = std::max(kernel.nr, blk.nc / kernel.nr * kernel.nr);
+    const size_t row_tiles = (m + mc_block - 1) / mc_block;
+    const size_t col_tiles = (n + nc_block - 1) / nc_block;
+    const size_t tiles = row_tiles * col_tiles;
+
+    auto run_tile = [&](size_t t) {
+        size_t ic = (t / col_tiles) * mc_block;
+        size_t jc = (t % col_tiles) * nc_block;
+        gemm_tile(kernel, std::min(mc_block, m - ic), std::min(nc_block, n - jc), k, blk.kc,
+                  alpha, a + ic * lda, lda, b + jc, ldb, beta, c + ic * ldc + jc, ldc);
+    };
+
+    size_t threads = 1;
+    if (tiles > 1 && 1.0 * m * n * k >= kParallelMinFlops) {
+        threads = std::min(resolve_threads(num_threads), tiles);
+    }
+
+    if (threads <= 1) {
+        for (size_t t = 0; t < tiles; t++) {
+            run_tile(t);
+        }
+        return;
+    }
+
+    // Each participant pulls tiles until the grid is exhausted
+    std::atomic<size_t> next_tile(0);
+    global_thread_pool().parallel_for(threads, [&](size_t) {
+        for (size_t t = next_tile.fetch_add(1); t < tiles; t = next_tile.fetch_add(1)) {
+            run_tile(t);
+        }
+    });
+}
+
+void dgemm(size_t m, size_t n, size_t k,
+           double alpha, const double* a, size_t lda,
+           const double* b, size_t ldb,
+           double beta, double* c, size_t ldc,
+           size_t num_threads) {
+    gemm_driver(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
+
+void sgemm(size_t m, size_t n, size_t k,
+           float alpha, const float* a, size_t lda,
+           const float* b, size_t ldb,
+           float beta, float* c, size_t ldc,
+           size_t num_threads) {
+    gemm_driver(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
+
+void gemm_bf16(size_t m, size_t n, size_t k,
+               float alpha, const bfloat16* a, size_t lda,
+               const bfloat16* b, size_t ldb,
+               float beta, float* c, size_t ldc,
+               size_t num_threads) {
+    gemm_driver(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
+
+void gemm_f16(size_t m, size_t n, size_t k,
+              float alpha, const float16* a, size_t lda,
+              const float16* b, size_t ldb,
+              float beta, float* c, size_t ldc,
+              size_t num_threads) {
+    gemm_driver(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
+
+// Batched GEMM.
+// A group of kBatchLanes small problems is interleaved element by element,
+// so lane l of every vector belongs to problem l and one vector multiply-add
+// advances all of them. Partial groups pad the unused lanes with zeros.
+
+static const size_t kBatchLanes = 4;
+// Interleaving beats a loop of per-problem dgemm up to about 6x6x6; from 8
+// on, the blocked kernels (AVX-512 included) are as fast or faster
+static const size_t kBatchTinyDim = 6;
+// Problems per parallel task, so tiny batches are not split into slivers
+static const size_t kBatchGrain = 64;
+
+struct BatchOperands {
+    const double* a;
+    const double* b;
+    double* c;
+    size_t stride_a;
+    size_t stride_b;
+    size_t stride_c;
+    const double* const* a_list;
+    const double* const* b_list;
+    double* const* c_list;
+
+    const double* get_a(size_t i) const { return a_list ? a_list[i] : a + i * stride_a; }
+    const double* get_b(size_t i) const { return b_list ? b_list[i] : b + i * stride_b; }
+    double* get_c(size_t i) const { return c_list ? c_list[i] : c + i * stride_c; }
+};
+
+// acc[(i * n + j) * L + l] = sum_p A_l[i][p] * B_l[p][j] on interleaved operands
+static void batch_group_scalar(size_t m, size_t n, size_t k,
+                               const double* ai, const double* bi, double* acc) {
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            double s[kBatchLanes] = {};
+            for (size_t p = 0; p < k; p++) {
+                const double* av = ai + (i * k + p) * kBatchLanes;
+                const double* bv = bi + (p * n + j) * kBatchLanes;
+                for (size_t l = 0; l < kBatchLanes; l++) {
+                    s[l] += av[l] * bv[l];
+                }
+            }
+            for (size_t l = 0; l < kBatchLanes; l++) {
+                acc[(i * n + j) * kBatchLanes + l] = s[l];
+            }
+        }
+    }
+}
+
+#if USE_X86_SIMD
+static void batch_group_sse2(size_t m, size_t n, size_t k,
+                             const double* ai, const double* bi, double* acc) {
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            __m128d s0 = _mm_setzero_pd();
+            __m128d s1 = _mm_setzero_pd();
+            for (size_t p = 0; p < k; p++) {
+                const double* av = ai + (i * k + p) * kBatchLanes;
+                const double* bv = bi + (p * n + j) * kBatchLanes;
+                s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_load_pd(av), _mm_load_pd(bv)));
+                s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_load_pd(av + 2), _mm_load_pd(bv + 2)));
+            }
+            _mm_store_pd(acc + (i * n + j) * kBatchLanes, s0);
+            _mm_store_pd(acc + (i * n + j) * kBatchLanes + 2, s1);
+        }
+    }
+}
+
+TARGET_AVX2
+static void batch_group_avx2(size_t m, size_t n, size_t k,
+                             const double* ai, const double* bi, double* acc) {
+    for (size_t i = 0; i < m; i++) {
+        const double* arow = ai + i * k * kBatchLanes;
+        double* crow = acc + i * n * kBatchLanes;
+        size_t j = 0;
+        // Four output columns at a time share each broadcast of A's lanes
+        for (; j + 4 <= n; j += 4) {
+            __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+            __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+            for (size_t p = 0; p < k; p++) {
+                __m256d av = _mm256_load_pd(arow + p * kBatchLanes);
+                const double* bv = bi + (p * n + j) * kBatchLanes;
+                s0 = _mm256_fmadd_pd(av, _mm256_load_pd(bv), s0);
+                s1 = _mm256_fmadd_pd(av, _mm256_load_pd(bv + 4), s1);
+                s2 = _mm256_fmadd_pd(av, _mm256_load_pd(bv + 8), s2);
+                s3 = _mm256_fmadd_pd(av, _mm256_load_pd(bv + 12), s3);
+            }
+            _mm256_store_pd(crow + j * kBatchLanes, s0);
+            _mm256_store_pd(crow + (j + 1) * kBatchLanes, s1);
+            _mm256_store_pd(crow + (j + 2) * kBatchLanes, s2);
+            _mm256_store_pd(crow + (j + 3) * kBatchLanes, s3);
+        }
+        for (; j < n; j++) {
+            __m256d s = _mm256_setzero_pd();
+            for (size_t p = 0; p < k; p++) {
+                s = _mm256_fmadd_pd(_mm256_load_pd(arow + p * kBatchLanes),
+                                    _mm256_load_pd(bi + (p * n + j) * kBatchLanes), s);
+            }
+            _mm256_store_pd(crow + j * kBatchLanes, s);
+        }
+    }
+}
+#endif
+
+// Interleave up to kBatchLanes row-major rows x cols matrices into dst
+static void interleave_group(const double* const* src, size_t lanes, size_t rows, size_t cols,
+                             size_t ld, double* dst) {
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            double* d = dst + (i * cols + j) * kBatchLanes;
+            for (size_t l = 0; l < kBatchLanes; l++) {
+                d[l] = (l < lanes) ? src[l][i * ld + j] : 0.0;
+            }
+        }
+    }
+}
+
+// C_l = alpha * acc_l + beta * C_l for each live lane
+static void scatter_group(const double* acc, size_t lanes, size_t m, size_t n,
+                          double alpha, double beta, double* const* dst, size_t ldc) {
+    for (size_t l = 0; l < lanes; l++) {
+        double* c = dst[l];
+        for (size_t i = 0; i < m; i++) {
+            for (size_t j = 0; j < n; j++) {
+                double v = alpha * acc[(i * n + j) * kBatchLanes + l];
+                if (beta != 0.0) {
+                    v += beta * c[i * ldc + j];
+                }
+                c[i * ldc + j] = v;
+            }
+        }
+    }
+}
+
+#if USE_X86_SIMD
+// 4x4 transpose: row q of the input becomes lane q of every output
+TARGET_AVX2
+static inline void transpose4_avx2(__m256d& r0, __m256d& r1, __m256d& r2, __m256d& r3) {
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    r0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+    r1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+    r2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+    r3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+// Full groups with rows of whole vectors are interleaved by register transposes
+TARGET_AVX2
+static void interleave_group_avx2(const double* const* src, size_t lanes, size_t rows,
+                                  size_t cols, size_t ld, double* dst) {
+    if (lanes != kBatchLanes || cols % 4 != 0) {
+        interleave_group(src, lanes, rows, cols, ld, dst);
+        return;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j += 4) {
+            __m256d r0 = _mm256_loadu_pd(src[0] + i * ld + j);
+            __m256d r1 = _mm256_loadu_pd(src[1] + i * ld + j);
+            __m256d r2 = _mm256_loadu_pd(src[2] + i * ld + j);
+            __m256d r3 = _mm256_loadu_pd(src[3] + i * ld + j);
+            transpose4_avx2(r0, r1, r2, r3);
+            double* d = dst + (i * cols + j) * kBatchLanes;
+            _mm256_store_pd(d, r0);
+            _mm256_store_pd(d + 4, r1);
+            _mm256_store_pd(d + 8, r2);
+            _mm256_store_pd(d + 12, r3);
+        }
+    }
+}
+
+TARGET_AVX2
+static void scatter_group_avx2(const double* acc, size_t lanes, size_t m, size_t n,
+                               double alpha, double beta, double* const* dst, size_t ldc) {
+    if (lanes != kBatchLanes || n % 4 != 0) {
+        scatter_group(acc, lanes, m, n, alpha, beta, dst, ldc);
+        return;
+    }
+    const __m256d alpha_vec = _mm256_set1_pd(alpha);
+    const __m256d beta_vec = _mm256_set1_pd(beta);
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j += 4) {
+            const double* s = acc + (i * n + j) * kBatchLanes;
+            __m256d r[4] = { _mm256_load_pd(s), _mm256_load_pd(s + 4),
+                             _mm256_load_pd(s + 8), _mm256_load_pd(s + 12) };
+            transpose4_avx2(r[0], r[1], r[2], r[3]);
+            for (size_t l = 0; l < kBatchLanes; l++) {
+                double* c = dst[l] + i * ldc + j;
+                __m256d v = _mm256_mul_pd(alpha_vec, r[l]);
+                if (beta != 0.0) {
+                    v = _mm256_fmadd_pd(beta_vec, _mm256_loadu_pd(c), v);
+                }
+                _mm256_storeu_pd(c, v);
+            }
+        }
+    }
+}
+#endif
+
+struct BatchLaneKernels {
+    void (*interleave)(const double* const* src, size_t lanes, size_t rows, size_t cols,
+                       size_t ld, double* dst);
+    void (*multiply)(size_t m, size_t n, size_t k, const double* ai, const double* bi,
+                     double* acc);
+    void (*scatter)(const double* acc, size_t lanes, size_t m, size_t n,
+                    double alpha, double beta, double* const* dst, size_t ldc);
+};
+
+static BatchLaneKernels select_batch_lane_kernels() {
+    BatchLaneKernels kernels = { interleave_group, batch_group_scalar, scatter_group };
+#if USE_X86_SIMD
+    const CpuFeatures& cpu = cpu_features();
+    if (cpu.avx2 && cpu.fma) {
+        kernels.interleave = interleave_group_avx2;
+        kernels.multiply = batch_group_avx2;
+        kernels.scatter = scatter_group_avx2;
+    } else if (cpu.sse2) {
+        kernels.multiply = batch_group_sse2;
+    }
+#endif
+    return kernels;
+}
+
+static void batch_tiny_range(size_t m, size_t n, size_t k, double alpha,
+                             const BatchOperands& ops, size_t lda, size_t ldb,
+                             double beta, size_t ldc, size_t first, size_t last) {
+    static const BatchLaneKernels kernels = select_batch_lane_kernels();
+    double* ai = t_packed_a.reserve<double>(m * k * kBatchLanes);
+    double* bi = t_packed_b.reserve<double>(k * n * kBatchLanes);
+    double* acc = t_batch_c.reserve<double>(m * n * kBatchLanes);
+
+    for (size_t g = first; g < last; g += kBatchLanes) {
+        size_t lanes = std::min(kBatchLanes, last - g);
+        const double* a_src[kBatchLanes];
+        const double* b_src[kBatchLanes];
+        double* c_dst[kBatchLanes];
+        for (size_t l = 0; l < lanes; l++) {
+            a_src[l] = ops.get_a(g + l);
+            b_src[l] = ops.get_b(g + l);
+            c_dst[l] = ops.get_c(g + l);
+        }
+        kernels.interleave(a_src, lanes, m, k, lda, ai);
+        kernels.interleave(b_src, lanes, k, n, ldb, bi);
+        kernels.multiply(m, n, k, ai, bi, acc);
+        kernels.scatter(acc, lanes, m, n, alpha, beta, c_dst, ldc);
+    }
+}
+
+static void dgemm_batch_impl(size_t m, size_t n, size_t k, double alpha,
+                             const BatchOperands& ops, size_t lda, size_t ldb,
+                             double beta, size_t ldc, size_t batch_count, size_t num_threads) {
+    if (batch_count == 0 || m == 0 || n == 0) {
+        return;
+    }
+
+    const bool tiny = m <= kBatchTinyDim && n <= kBatchTinyDim && k <= kBatchTinyDim
+                      && k > 0 && alpha != 0.0;
+    auto run_range = [&](size_t first, size_t last) {
+        if (tiny) {
+            batch_tiny_range(m, n, k, alpha, ops, lda, ldb, beta, ldc, first, last);
+            return;
+        }
+        for (size_t i = first; i < last; i++) {
+            dgemm(m, n, k, alpha, ops.get_a(i), lda, ops.get_b(i), ldb,
+                  beta, ops.get_c(i), ldc, 1);
+        }
+    };
+
+    // Chunks are whole lane groups so no group straddles two tasks
+    const size_t grain = tiny ? kBatchGrain : 1;
+    const size_t chunks = (batch_count + grain - 1) / grain;
+    size_t threads = 1;
+    if (chunks > 1) {
+        threads = std::min(resolve_threads(num_threads), chunks);
+    }
+
+    if (threads <= 1) {
+        run_range(0, batch_count);
+        return;
+    }
+
+    std::atomic<size_t> next_chunk(0);
+    global_thread_pool().parallel_for(threads, [&](size_t) {
+        for (size_t ch = next_chunk.fetch_add(1); ch < chunks; ch = next_chunk.fetch_add(1)) {
+            run_range(ch * grain, std::min(batch_count, (ch + 1) * grain));
+        }
+    });
+}
+
+void dgemm_batch_strided(size_t m, size_t n, size_t k, double alpha,
+                         const double* a, size_t lda, size_t stride_a,
+                         const double* b, size_t ldb, size_t stride_b,
+                         double beta, double* c, size_t ldc, size_t stride_c,
+                         size_t batch_count, size_t num_threads) {
+    BatchOperands ops = { a, b, c, stride_a, stride_b, stride_c, nullptr, nullptr, nullptr };
+    dgemm_batch_impl(m, n, k, alpha, ops, lda, ldb, beta, ldc, batch_count, num_threads);
+}
+
+void dgemm_batch(size_t m, size_t n, size_t k, double alpha,
+                 const double* const* a, size_t lda,
+                 const double* const* b, size_t ldb,
+                 double beta, double* const* c, size_t ldc,
+                 size_t batch_count, size_t num_threads) {
+    BatchOperands ops = { nullptr, nullptr, nullptr, 0, 0, 0, a, b, c };
+    dgemm_batch_impl(m, n, k, alpha, ops, lda, ldb, beta, ldc, batch_count, num_threads);
+}
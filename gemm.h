@@ -0,0 +1,77 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include "half_precision.h"
+
+// Cache blocking parameters of the packed GEMM engine.
+// A kc x nr micro-panel of B stays in L1, an mc x kc block of packed A
+// stays in L2 and a kc x nc panel of packed B stays in L3.
+struct GemmBlocking {
+    size_t mc;
+    size_t kc;
+    size_t nc;
+};
+
+// Defaults to { 128, 256, 512 }, or the tuned profile's values for this
+// CPU (gemm_tuner.h)
+GemmBlocking gemm_get_blocking();
+void gemm_set_blocking(const GemmBlocking& blocking);
+
+// Micro-kernel selection. The best kernel the CPU supports ("avx512",
+// "avx2", "sse2", "scalar") is picked on first use unless the GEMM_KERNEL
+// environment variable or the tuned profile names another. gemm_set_kernel
+// returns false if the name is unknown or the CPU lacks the instructions.
+const char* gemm_kernel_name();
+bool gemm_set_kernel(const char* name);
+
+// C = alpha * A * B + beta * C for row-major A (m x k), B (k x n), C (m x n)
+// with leading dimensions lda, ldb, ldc. C is not read when beta == 0.
+// num_threads caps the worker count (0 = the whole global thread pool);
+// the result is bit-identical for every thread count.
+void dgemm(size_t m, size_t n, size_t k,
+           double alpha, const double* a, size_t lda,
+           const double* b, size_t ldb,
+           double beta, double* c, size_t ldc,
+           size_t num_threads = 0);
+
+// Single precision: C = alpha * A * B + beta * C in fp32
+void sgemm(size_t m, size_t n, size_t k,
+           float alpha, const float* a, size_t lda,
+           const float* b, size_t ldb,
+           float beta, float* c, size_t ldc,
+           size_t num_threads = 0);
+
+// 16-bit storage: A and B are widened to fp32 while packing, so the product
+// accumulates in fp32 and C is fp32
+void gemm_bf16(size_t m, size_t n, size_t k,
+               float alpha, const bfloat16* a, size_t lda,
+               const bfloat16* b, size_t ldb,
+               float beta, float* c, size_t ldc,
+               size_t num_threads = 0);
+void gemm_f16(size_t m, size_t n, size_t k,
+              float alpha, const float16* a, size_t lda,
+              const float16* b, size_t ldb,
+              float beta, float* c, size_t ldc,
+              size_t num_threads = 0);
+
+// Batched C_i = alpha * A_i * B_i + beta * C_i over batch_count independent
+// problems of the same shape. Matrices up to 6x6x6 are interleaved four
+// to a SIMD register (one matrix per lane); larger ones each run the blocked
+// engine. The batch is split across num_threads (0 = global pool).
+
+// Strided batch: A_i starts at a + i * stride_a, and likewise for B and C
+void dgemm_batch_strided(size_t m, size_t n, size_t k, double alpha,
+                         const double* a, size_t lda, size_t stride_a,
+                         const double* b, size_t ldb, size_t stride_b,
+                         double beta, double* c, size_t ldc, size_t stride_c,
+                         size_t batch_count, size_t num_threads = 0);
+
+// Pointer-array batch: A_i is a[i], B_i is b[i], C_i is c[i]
+void dgemm_batch(size_t m, size_t n, size_t k, double alpha,
+                 const double* const* a, size_t lda,
+                 const double* const* b, size_t ldb,
+                 double beta, double* const* c, size_t ldc,
+                 size_t batch_count, size_t num_threads = 0);
+
+#endif // GEMM_H
@@ -0,0 +1,197 @@
+#include "gemm_tuner.h"
+#include "bench_util.h"
+#include "cpu_features.h"
+#include "matrix_operations.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+static const char* const kTuneKernels[] = { "avx512", "avx2", "sse2" };
+
+// Candidate values per dimension; mc values are multiples of every kernel's mr
+static const size_t kTuneMc[] = { 48, 96, 144, 192, 288, 384 };
+static const size_t kTuneKc[] = { 128, 192, 256, 320, 384, 512 };
+static const size_t kTuneNc[] = { 256, 512, 1024, 2048, 4096 };
+// Full sweeps of the three dimensions
+static const int kTunePasses = 2;
+
+std::string gemm_profile_path() {
+    const char* env = std::getenv("GEMM_PROFILE");
+    return (env != nullptr && *env != '\0') ? env : "gemm_profile.txt";
+}
+
+// Splits "kernel mc kc nc model" into its fields; false if malformed
+static bool parse_profile_line(const std::string& line, GemmProfile& profile, std::string& model) {
+    std::istringstream in(line);
+    GemmProfile p;
+    if (!(in >> p.kernel >> p.blocking.mc >> p.blocking.kc >> p.blocking.nc)) {
+        return false;
+    }
+    if (p.blocking.mc == 0 || p.blocking.kc == 0 || p.blocking.nc == 0) {
+        return false;
+    }
+    std::getline(in, model);
+    size_t first = model.find_first_not_of(" \t");
+    size_t last = model.find_last_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return false;
+    }
+    model = model.substr(first, last - first + 1);
+    profile = p;
+    return true;
+}
+
+static bool is_comment(const std::string& line) {
+    size_t first = line.find_first_not_of(" \t\r");
+    return first == std::string::npos || line[first] == '#';
+}
+
+bool gemm_load_profile(const std::string& path, const std::string& cpu_model, GemmProfile& profile) {
+    std::ifstream in(path.c_str());
+    std::string line;
+    while (std::getline(in, line)) {
+        GemmProfile p;
+        std::string model;
+        if (!is_comment(line) && parse_profile_line(line, p, model) && model == cpu_model) {
+            profile = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+void gemm_save_profile(const std::string& path, const std::string& cpu_model, const GemmProfile& profile) {
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path.c_str());
+        std::string line;
+        while (std::getline(in, line)) {
+            GemmProfile p;
+            std::string model;
+            if (is_comment(line) || !parse_profile_line(line, p, model) || model != cpu_model) {
+                lines.push_back(line);
+            }
+        }
+    }
+    if (lines.empty()) {
+        lines.push_back("# GEMM tuning profile: kernel mc kc nc cpu-model");
+    }
+    std::ostringstream entry;
+    entry << profile.kernel << " " << profile.blocking.mc << " " << profile.blocking.kc << " "
+          << profile.blocking.nc << " " << cpu_model;
+    lines.push_back(entry.str());
+
+    // Write aside and rename, so readers never see a partial file
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp.c_str(), std::ios::trunc);
+        for (const std::string& line : lines) {
+            out << line << "\n";
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("Failed to write GEMM profile: " + tmp);
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Failed to replace GEMM profile: " + path);
+    }
+}
+
+// Best of a few dgemm runs, in seconds
+static double time_dgemm(const Matrix& a, const Matrix& b, Matrix& c, size_t num_threads) {
+    const size_t n = a.getRows();
+    double best = 0.0;
+    for (int rep = 0; rep < 3; rep++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        dgemm(n, n, n, 1.0, a.row(0), a.getStride(), b.row(0), b.getStride(), 0.0, c.row(0),
+              c.getStride(), num_threads);
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        best = (rep == 0) ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+GemmProfile gemm_autotune(size_t size, size_t num_threads) {
+    Matrix a(size, size);
+    Matrix b(size, size);
+    Matrix c(size, size);
+    a.randomize();
+    b.randomize();
+    const double flops = 2.0 * size * size * size;
+
+    const GemmBlocking defaults = { 128, 256, 512 };
+    const size_t* const values[3] = { kTuneKc, kTuneMc, kTuneNc };
+    const size_t counts[3] = { sizeof(kTuneKc) / sizeof(kTuneKc[0]), sizeof(kTuneMc) / sizeof(kTuneMc[0]),
+                               sizeof(kTuneNc) / sizeof(kTuneNc[0]) };
+
+    GemmProfile best;
+    double best_seconds = 0.0;
+    for (const char* kernel : kTuneKernels) {
+        if (!gemm_set_kernel(kernel)) {
+            continue;
+        }
+        GemmBlocking blk = defaults;
+        gemm_set_blocking(blk);
+        double kernel_best = time_dgemm(a, b, c, num_threads);
+
+        // kc first: it sizes the L1-resident B sliver that mc and nc build on
+        for (int pass = 0; pass < kTunePasses; pass++) {
+            for (size_t dim = 0; dim < 3; dim++) {
+                for (size_t v = 0; v < counts[dim]; v++) {
+                    GemmBlocking trial = blk;
+                    size_t* field = (dim == 0) ? &trial.kc : (dim == 1) ? &trial.mc : &trial.nc;
+                    if (*field == values[dim][v]) {
+                        continue;
+                    }
+                    *field = values[dim][v];
+                    gemm_set_blocking(trial);
+                    double seconds = time_dgemm(a, b, c, num_threads);
+                    if (seconds < kernel_best) {
+                        kernel_best = seconds;
+                        blk = trial;
+                    }
+                }
+            }
+        }
+
+        std::cout << kernel << ": mc " << blk.mc << ", kc " << blk.kc << ", nc " << blk.nc << ": "
+                  << flops / kernel_best / 1e9 << " GFLOP/s" << std::endl;
+        if (best.kernel.empty() || kernel_best < best_seconds) {
+            best.kernel = kernel;
+            best.blocking = blk;
+            best_seconds = kernel_best;
+        }
+    }
+
+    if (best.kernel.empty()) {
+        best.kernel = "scalar";
+        best.blocking = defaults;
+    }
+    gemm_set_kernel(best.kernel.c_str());
+    gemm_set_blocking(best.blocking);
+    return best;
+}
+
+void benchmark_gemm_tune() {
+    std::cout << "\n=== GEMM Autotune ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+    std::cout << "CPU: " << cpu_model_name() << std::endl;
+
+    const size_t size = env_size("GEMM_TUNE_SIZE", 1024);
+    std::cout << "Problem: " << size << "x" << size << " dgemm" << std::endl;
+    GemmProfile best = gemm_autotune(size);
+
+    const std::string path = gemm_profile_path();
+    gemm_save_profile(path, cpu_model_name(), best);
+    std::cout << "Selected " << best.kernel << " with mc " << best.blocking.mc << ", kc "
+              << best.blocking.kc << ", nc " << best.blocking.nc << "; written to " << path << std::endl;
+}
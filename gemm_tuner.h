@@ -0,0 +1,46 @@
+#ifndef GEMM_TUNER_H
+#define GEMM_TUNER_H
+
+#include <cstddef>
+#include <string>
+#include "gemm.h"
+
+// GEMM autotuning and the per-CPU profile file.
+//
+// The profile is a text file with one line per CPU model, so a single file
+// can serve a fleet of different machines:
+//
+//   # kernel mc kc nc cpu-model
+//   avx512 144 384 2048 Intel(R) Xeon(R) Platinum 8375C CPU @ 2.90GHz
+//
+// The GEMM engine reads the line for cpu_model_name() on first use and
+// takes its kernel and blocking; GEMM_KERNEL, gemm_set_kernel() and
+// gemm_set_blocking() still take precedence.
+
+// Tuned settings for one CPU model
+struct GemmProfile {
+    std::string kernel;      // gemm_set_kernel() name
+    GemmBlocking blocking;
+};
+
+// GEMM_PROFILE if set, else gemm_profile.txt in the working directory
+std::string gemm_profile_path();
+
+// Entry for cpu_model; false if the file, the entry or its fields are
+// missing or malformed
+bool gemm_load_profile(const std::string& path, const std::string& cpu_model, GemmProfile& profile);
+
+// Adds or replaces the entry for cpu_model and keeps every other line.
+// Throws std::runtime_error if the file cannot be written.
+void gemm_save_profile(const std::string& path, const std::string& cpu_model, const GemmProfile& profile);
+
+// Times a size x size dgemm for every supported micro-kernel over a sweep of
+// mc, kc and nc (coordinate descent from the defaults), applies the fastest
+// setting to the engine and returns it
+GemmProfile gemm_autotune(size_t size, size_t num_threads = 0);
+
+// Benchmark entry "tune": autotune at GEMM_TUNE_SIZE (default 1024) and
+// write the result for this CPU to gemm_profile_path()
+void benchmark_gemm_tune();
+
+#endif // GEMM_TUNER_H
@@ -0,0 +1,519 @@
+#include "gemv.h"
+#include "bench_util.h"
+#include "cpu_features.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Rows per block of the plain product; a multiple of the kernels' 4 rows
+static const size_t kGemvRowBlock = 64;
+// Rows summed into one partial result by the transposed product, and
+// columns per block of its work
+static const size_t kGemvTransRows = 512;
+static const size_t kGemvTransCols = 4096;
+// Columns of the transposed product's accumulator updated per pass over
+// the rows; 4 KB of doubles, so it stays in L1
+static const size_t kGemvStripe = 512;
+// Dot products per block of a batch
+static const size_t kDotBlock = 64;
+// Matrix elements below which the work stays on the calling thread
+static const size_t kGemvParallelMin = 1 << 16;
+
+template <typename T>
+struct GemvKernels {
+    // x . y
+    T (*dot)(const T* x, const T* y, size_t n);
+    // dots[r] = A_r . x for the first rows rows of A
+    void (*rows)(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* dots);
+    // acc[j] += sum over r of x[r] * A_rj, for j < n
+    void (*trans)(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* acc);
+};
+
+#if !USE_X86_SIMD
+template <typename T>
+static T dot_scalar(const T* x, const T* y, size_t n) {
+    T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += x[i] * y[i];
+        s1 += x[i + 1] * y[i + 1];
+        s2 += x[i + 2] * y[i + 2];
+        s3 += x[i + 3] * y[i + 3];
+    }
+    T total = (s0 + s1) + (s2 + s3);
+    for (; i < n; i++) {
+        total += x[i] * y[i];
+    }
+    return total;
+}
+
+template <typename T>
+static void gemv_rows_scalar(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* dots) {
+    for (size_t r = 0; r < rows; r++) {
+        dots[r] = dot_scalar(a + r * lda, x, n);
+    }
+}
+
+template <typename T>
+static void gemv_trans_scalar(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* acc) {
+    for (size_t r = 0; r < rows; r++) {
+        const T* row = a + r * lda;
+        for (size_t j = 0; j < n; j++) {
+            acc[j] += row[j] * x[r];
+        }
+    }
+}
+#endif
+
+#if USE_X86_SIMD
+// Overloads on the element type, so each kernel below serves double and float
+template <typename T>
+struct Sse2Vec;
+template <>
+struct Sse2Vec<double> {
+    typedef __m128d type;
+    static const size_t width = 2;
+};
+template <>
+struct Sse2Vec<float> {
+    typedef __m128 type;
+    static const size_t width = 4;
+};
+
+static inline __m128d sse2_load(const double* p) { return _mm_loadu_pd(p); }
+static inline __m128 sse2_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void sse2_store(double* p, __m128d v) { _mm_storeu_pd(p, v); }
+static inline void sse2_store(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+static inline __m128d sse2_set1(double v) { return _mm_set1_pd(v); }
+static inline __m128 sse2_set1(float v) { return _mm_set1_ps(v); }
+static inline __m128d sse2_add(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+static inline __m128 sse2_add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+// c + a * b
+static inline __m128d sse2_madd(__m128d a, __m128d b, __m128d c) { return _mm_add_pd(c, _mm_mul_pd(a, b)); }
+static inline __m128 sse2_madd(__m128 a, __m128 b, __m128 c) { return _mm_add_ps(c, _mm_mul_ps(a, b)); }
+static inline double sse2_hsum(__m128d v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+static inline float sse2_hsum(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+}
+
+template <typename T>
+static T dot_sse2(const T* x, const T* y, size_t n) {
+    typedef typename Sse2Vec<T>::type V;
+    const size_t w = Sse2Vec<T>::width;
+    V s0 = sse2_set1(T(0)), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 4 * w <= n; i += 4 * w) {
+        s0 = sse2_madd(sse2_load(x + i), sse2_load(y + i), s0);
+        s1 = sse2_madd(sse2_load(x + i + w), sse2_load(y + i + w), s1);
+        s2 = sse2_madd(sse2_load(x + i + 2 * w), sse2_load(y + i + 2 * w), s2);
+        s3 = sse2_madd(sse2_load(x + i + 3 * w), sse2_load(y + i + 3 * w), s3);
+    }
+    for (; i + w <= n; i += w) {
+        s0 = sse2_madd(sse2_load(x + i), sse2_load(y + i), s0);
+    }
+    T total = sse2_hsum(sse2_add(sse2_add(s0, s1), sse2_add(s2, s3)));
+    for (; i < n; i++) {
+        total += x[i] * y[i];
+    }
+    return total;
+}
+
+// Four rows at a time share each load of x, two accumulators per row
+template <typename T>
+static void gemv_rows_sse2(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* dots) {
+    typedef typename Sse2Vec<T>::type V;
+    const size_t w = Sse2Vec<T>::width;
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const T* a0 = a + r * lda;
+        const T* a1 = a0 + lda;
+        const T* a2 = a1 + lda;
+        const T* a3 = a2 + lda;
+        V s0 = sse2_set1(T(0)), s1 = s0, s2 = s0, s3 = s0;
+        V t0 = s0, t1 = s0, t2 = s0, t3 = s0;
+        size_t j = 0;
+        for (; j + 2 * w <= n; j += 2 * w) {
+            V x0 = sse2_load(x + j), x1 = sse2_load(x + j + w);
+            s0 = sse2_madd(sse2_load(a0 + j), x0, s0);
+            t0 = sse2_madd(sse2_load(a0 + j + w), x1, t0);
+            s1 = sse2_madd(sse2_load(a1 + j), x0, s1);
+            t1 = sse2_madd(sse2_load(a1 + j + w), x1, t1);
+            s2 = sse2_madd(sse2_load(a2 + j), x0, s2);
+            t2 = sse2_madd(sse2_load(a2 + j + w), x1, t2);
+            s3 = sse2_madd(sse2_load(a3 + j), x0, s3);
+            t3 = sse2_madd(sse2_load(a3 + j + w), x1, t3);
+        }
+        T d0 = sse2_hsum(sse2_add(s0, t0)), d1 = sse2_hsum(sse2_add(s1, t1));
+        T d2 = sse2_hsum(sse2_add(s2, t2)), d3 = sse2_hsum(sse2_add(s3, t3));
+        for (; j < n; j++) {
+            d0 += a0[j] * x[j];
+            d1 += a1[j] * x[j];
+            d2 += a2[j] * x[j];
+            d3 += a3[j] * x[j];
+        }
+        dots[r] = d0;
+        dots[r + 1] = d1;
+        dots[r + 2] = d2;
+        dots[r + 3] = d3;
+    }
+    for (; r < rows; r++) {
+        dots[r] = dot_sse2(a + r * lda, x, n);
+    }
+}
+
+// Four rows at a time per load and store of the accumulator
+template <typename T>
+static void gemv_trans_sse2(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* acc) {
+    typedef typename Sse2Vec<T>::type V;
+    const size_t w = Sse2Vec<T>::width;
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const T* a0 = a + r * lda;
+        const T* a1 = a0 + lda;
+        const T* a2 = a1 + lda;
+        const T* a3 = a2 + lda;
+        const V x0 = sse2_set1(x[r]), x1 = sse2_set1(x[r + 1]);
+        const V x2 = sse2_set1(x[r + 2]), x3 = sse2_set1(x[r + 3]);
+        size_t j = 0;
+        for (; j + w <= n; j += w) {
+            V s = sse2_load(acc + j);
+            s = sse2_madd(sse2_load(a0 + j), x0, s);
+            s = sse2_madd(sse2_load(a1 + j), x1, s);
+            s = sse2_madd(sse2_load(a2 + j), x2, s);
+            s = sse2_madd(sse2_load(a3 + j), x3, s);
+            sse2_store(acc + j, s);
+        }
+        for (; j < n; j++) {
+            acc[j] = acc[j] + a0[j] * x[r] + a1[j] * x[r + 1] + a2[j] * x[r + 2] + a3[j] * x[r + 3];
+        }
+    }
+    for (; r < rows; r++) {
+        const T* row = a + r * lda;
+        const V xr = sse2_set1(x[r]);
+        size_t j = 0;
+        for (; j + w <= n; j += w) {
+            sse2_store(acc + j, sse2_madd(sse2_load(row + j), xr, sse2_load(acc + j)));
+        }
+        for (; j < n; j++) {
+            acc[j] += row[j] * x[r];
+        }
+    }
+}
+
+template <typename T>
+struct Avx2Vec;
+template <>
+struct Avx2Vec<double> {
+    typedef __m256d type;
+    static const size_t width = 4;
+};
+template <>
+struct Avx2Vec<float> {
+    typedef __m256 type;
+    static const size_t width = 8;
+};
+
+TARGET_AVX2 static inline __m256d avx2_load(const double* p) { return _mm256_loadu_pd(p); }
+TARGET_AVX2 static inline __m256 avx2_load(const float* p) { return _mm256_loadu_ps(p); }
+TARGET_AVX2 static inline void avx2_store(double* p, __m256d v) { _mm256_storeu_pd(p, v); }
+TARGET_AVX2 static inline void avx2_store(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+TARGET_AVX2 static inline __m256d avx2_set1(double v) { return _mm256_set1_pd(v); }
+TARGET_AVX2 static inline __m256 avx2_set1(float v) { return _mm256_set1_ps(v); }
+TARGET_AVX2 static inline __m256d avx2_add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+TARGET_AVX2 static inline __m256 avx2_add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+TARGET_AVX2 static inline __m256d avx2_madd(__m256d a, __m256d b, __m256d c) { return _mm256_fmadd_pd(a, b, c); }
+TARGET_AVX2 static inline __m256 avx2_madd(__m256 a, __m256 b, __m256 c) { return _mm256_fmadd_ps(a, b, c); }
+TARGET_AVX2 static inline double avx2_hsum(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+TARGET_AVX2 static inline float avx2_hsum(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+template <typename T>
+TARGET_AVX2 static T dot_avx2(const T* x, const T* y, size_t n) {
+    typedef typename Avx2Vec<T>::type V;
+    const size_t w = Avx2Vec<T>::width;
+    V s0 = avx2_set1(T(0)), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 4 * w <= n; i += 4 * w) {
+        s0 = avx2_madd(avx2_load(x + i), avx2_load(y + i), s0);
+        s1 = avx2_madd(avx2_load(x + i + w), avx2_load(y + i + w), s1);
+        s2 = avx2_madd(avx2_load(x + i + 2 * w), avx2_load(y + i + 2 * w), s2);
+        s3 = avx2_madd(avx2_load(x + i + 3 * w), avx2_load(y + i + 3 * w), s3);
+    }
+    for (; i + w <= n; i += w) {
+        s0 = avx2_madd(avx2_load(x + i), avx2_load(y + i), s0);
+    }
+    T total = avx2_hsum(avx2_add(avx2_add(s0, s1), avx2_add(s2, s3)));
+    for (; i < n; i++) {
+        total += x[i] * y[i];
+    }
+    return total;
+}
+
+template <typename T>
+TARGET_AVX2 static void gemv_rows_avx2(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* dots) {
+    typedef typename Avx2Vec<T>::type V;
+    const size_t w = Avx2Vec<T>::width;
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const T* a0 = a + r * lda;
+        const T* a1 = a0 + lda;
+        const T* a2 = a1 + lda;
+        const T* a3 = a2 + lda;
+        V s0 = avx2_set1(T(0)), s1 = s0, s2 = s0, s3 = s0;
+        V t0 = s0, t1 = s0, t2 = s0, t3 = s0;
+        size_t j = 0;
+        for (; j + 2 * w <= n; j += 2 * w) {
+            V x0 = avx2_load(x + j), x1 = avx2_load(x + j + w);
+            s0 = avx2_madd(avx2_load(a0 + j), x0, s0);
+            t0 = avx2_madd(avx2_load(a0 + j + w), x1, t0);
+            s1 = avx2_madd(avx2_load(a1 + j), x0, s1);
+            t1 = avx2_madd(avx2_load(a1 + j + w), x1, t1);
+            s2 = avx2_madd(avx2_load(a2 + j), x0, s2);
+            t2 = avx2_madd(avx2_load(a2 + j + w), x1, t2);
+            s3 = avx2_madd(avx2_load(a3 + j), x0, s3);
+            t3 = avx2_madd(avx2_load(a3 + j + w), x1, t3);
+        }
+        T d0 = avx2_hsum(avx2_add(s0, t0)), d1 = avx2_hsum(avx2_add(s1, t1));
+        T d2 = avx2_hsum(avx2_add(s2, t2)), d3 = avx2_hsum(avx2_add(s3, t3));
+        for (; j < n; j++) {
+            d0 += a0[j] * x[j];
+            d1 += a1[j] * x[j];
+            d2 += a2[j] * x[j];
+            d3 += a3[j] * x[j];
+        }
+        dots[r] = d0;
+        dots[r + 1] = d1;
+        dots[r + 2] = d2;
+        dots[r + 3] = d3;
+    }
+    for (; r < rows; r++) {
+        dots[r] = dot_avx2(a + r * lda, x, n);
+    }
+}
+
+template <typename T>
+TARGET_AVX2 static void gemv_trans_avx2(const T* a, size_t lda, size_t rows, const T* x, size_t n, T* acc) {
+    typedef typename Avx2Vec<T>::type V;
+    const size_t w = Avx2Vec<T>::width;
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const T* a0 = a + r * lda;
+        const T* a1 = a0 + lda;
+        const T* a2 = a1 + lda;
+        const T* a3 = a2 + lda;
+        const V x0 = avx2_set1(x[r]), x1 = avx2_set1(x[r + 1]);
+        const V x2 = avx2_set1(x[r + 2]), x3 = avx2_set1(x[r + 3]);
+        size_t j = 0;
+        for (; j + w <= n; j += w) {
+            V s = avx2_load(acc + j);
+            s = avx2_madd(avx2_load(a0 + j), x0, s);
+            s = avx2_madd(avx2_load(a1 + j), x1, s);
+            s = avx2_madd(avx2_load(a2 + j), x2, s);
+            s = avx2_madd(avx2_load(a3 + j), x3, s);
+            avx2_store(acc + j, s);
+        }
+        for (; j < n; j++) {
+            acc[j] = acc[j] + a0[j] * x[r] + a1[j] * x[r + 1] + a2[j] * x[r + 2] + a3[j] * x[r + 3];
+        }
+    }
+    for (; r < rows; r++) {
+        const T* row = a + r * lda;
+        const V xr = avx2_set1(x[r]);
+        size_t j = 0;
+        for (; j + w <= n; j += w) {
+            avx2_store(acc + j, avx2_madd(avx2_load(row + j), xr, avx2_load(acc + j)));
+        }
+        for (; j < n; j++) {
+            acc[j] += row[j] * x[r];
+        }
+    }
+}
+#endif
+
+template <typename T>
+static GemvKernels<T> gemv_kernels() {
+    GemvKernels<T> k;
+#if USE_X86_SIMD
+    if (cpu_features().avx2 && cpu_features().fma) {
+        k.dot = dot_avx2<T>;
+        k.rows = gemv_rows_avx2<T>;
+        k.trans = gemv_trans_avx2<T>;
+    } else {
+        k.dot = dot_sse2<T>;
+        k.rows = gemv_rows_sse2<T>;
+        k.trans = gemv_trans_sse2<T>;
+    }
+#else
+    k.dot = dot_scalar<T>;
+    k.rows = gemv_rows_scalar<T>;
+    k.trans = gemv_trans_scalar<T>;
+#endif
+    return k;
+}
+
+template <typename T>
+static void gemv_impl(bool transposed, size_t m, size_t n, T alpha, const T* a, size_t lda, const T* x, T beta,
+                      T* y, size_t num_threads) {
+    const GemvKernels<T> k = gemv_kernels<T>();
+    if (!transposed) {
+        const size_t blocks = (m + kGemvRowBlock - 1) / kGemvRowBlock;
+        parallel_blocks(blocks, m * n, kGemvParallelMin, num_threads, [&](size_t block) {
+            const size_t r0 = block * kGemvRowBlock, rows = std::min(kGemvRowBlock, m - r0);
+            T dots[kGemvRowBlock];
+            k.rows(a + r0 * lda, lda, rows, x, n, dots);
+            for (size_t r = 0; r < rows; r++) {
+                y[r0 + r] = alpha * dots[r] + (beta == T(0) ? T(0) : beta * y[r0 + r]);
+            }
+        });
+        return;
+    }
+
+    // Each block of rows accumulates its own partial A^T x, split into
+    // column tiles; the partials are then added in row-block order
+    const size_t row_blocks = (m + kGemvTransRows - 1) / kGemvTransRows;
+    const size_t col_tiles = (n + kGemvTransCols - 1) / kGemvTransCols;
+    std::vector<T> partial(std::max<size_t>(row_blocks, 1) * n, T(0));
+    parallel_blocks(row_blocks * col_tiles, m * n, kGemvParallelMin, num_threads, [&](size_t tile) {
+        const size_t rb = tile / col_tiles, ct = tile % col_tiles;
+        const size_t r0 = rb * kGemvTransRows, rows = std::min(kGemvTransRows, m - r0);
+        const size_t c0 = ct * kGemvTransCols, cols = std::min(kGemvTransCols, n - c0);
+        T* acc = &partial[rb * n + c0];
+        for (size_t s = 0; s < cols; s += kGemvStripe) {
+            k.trans(a + r0 * lda + c0 + s, lda, rows, x + r0, std::min(kGemvStripe, cols - s), acc + s);
+        }
+    });
+    parallel_blocks(col_tiles, row_blocks * n, kGemvParallelMin, num_threads, [&](size_t ct) {
+        const size_t c0 = ct * kGemvTransCols, cols = std::min(kGemvTransCols, n - c0);
+        T* total = &partial[c0];
+        for (size_t rb = 1; rb < row_blocks; rb++) {
+            const T* p = &partial[rb * n + c0];
+            for (size_t j = 0; j < cols; j++) {
+                total[j] += p[j];
+            }
+        }
+        for (size_t j = 0; j < cols; j++) {
+            y[c0 + j] = alpha * total[j] + (beta == T(0) ? T(0) : beta * y[c0 + j]);
+        }
+    });
+}
+
+void dgemv(bool transposed, size_t m, size_t n, double alpha, const double* a, size_t lda, const double* x,
+           double beta, double* y, size_t num_threads) {
+    gemv_impl(transposed, m, n, alpha, a, lda, x, beta, y, num_threads);
+}
+
+void sgemv(bool transposed, size_t m, size_t n, float alpha, const float* a, size_t lda, const float* x,
+           float beta, float* y, size_t num_threads) {
+    gemv_impl(transposed, m, n, alpha, a, lda, x, beta, y, num_threads);
+}
+
+void gemv(bool transposed, double alpha, const ConstMatrixView& a, const double* x, double beta, double* y,
+          size_t num_threads) {
+    gemv_impl(transposed, a.getRows(), a.getCols(), alpha, a.row(0), a.getStride(), x, beta, y, num_threads);
+}
+
+void gemv(bool transposed, float alpha, const ConstMatrixViewF32& a, const float* x, float beta, float* y,
+          size_t num_threads) {
+    gemv_impl(transposed, a.getRows(), a.getCols(), alpha, a.row(0), a.getStride(), x, beta, y, num_threads);
+}
+
+// Vectors of a batch, given either by base pointer and stride or by arrays
+// of pointers
+struct DotOperands {
+    const double* x;
+    const double* y;
+    size_t stride_x;
+    size_t stride_y;
+    const double* const* xs;
+    const double* const* ys;
+};
+
+static void ddot_batch_impl(size_t n, const DotOperands& ops, double* result, size_t batch_count,
+                            size_t num_threads) {
+    const GemvKernels<double> k = gemv_kernels<double>();
+    const size_t blocks = (batch_count + kDotBlock - 1) / kDotBlock;
+    parallel_blocks(blocks, batch_count * n, kGemvParallelMin, num_threads, [&](size_t block) {
+        const size_t end = std::min(batch_count, (block + 1) * kDotBlock);
+        for (size_t i = block * kDotBlock; i < end; i++) {
+            const double* x = ops.xs ? ops.xs[i] : ops.x + i * ops.stride_x;
+            const double* y = ops.ys ? ops.ys[i] : ops.y + i * ops.stride_y;
+            result[i] = k.dot(x, y, n);
+        }
+    });
+}
+
+void ddot_batch_strided(size_t n, const double* x, size_t stride_x, const double* y, size_t stride_y,
+                        double* result, size_t batch_count, size_t num_threads) {
+    DotOperands ops = { x, y, stride_x, stride_y, nullptr, nullptr };
+    ddot_batch_impl(n, ops, result, batch_count, num_threads);
+}
+
+void ddot_batch(size_t n, const double* const* x, const double* const* y, double* result, size_t batch_count,
+                size_t num_threads) {
+    DotOperands ops = { nullptr, nullptr, 0, 0, x, y };
+    ddot_batch_impl(n, ops, result, batch_count, num_threads);
+}
+
+void benchmark_gemv() {
+    std::cout << "\n=== GEMV Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    // 64 MB of matrix, well beyond the last-level cache
+    const size_t m = 4096, n = 2048;
+    Matrix a(m, n);
+    Matrix xm(n, 1);
+    a.randomize();
+    xm.randomize();
+    std::vector<double> x(n);
+    for (size_t j = 0; j < n; j++) {
+        x[j] = xm(j, 0);
+    }
+    std::vector<double> y(m);
+    const double bytes = static_cast<double>(m) * n * sizeof(double);
+
+    Matrix ym = a.multiply(xm);
+    double seconds = best_seconds([&] { ym = a.multiply(xm); });
+    std::cout << "multiply " << m << "x" << n << " by " << n << "x1: " << bytes / seconds / 1e9 << " GB/s"
+              << std::endl;
+    seconds = best_seconds([&] { gemv(false, 1.0, a, x.data(), 0.0, y.data()); });
+    double diff = 0.0;
+    for (size_t i = 0; i < m; i++) {
+        diff = std::max(diff, std::fabs(y[i] - ym(i, 0)));
+    }
+    std::cout << "dgemv: " << bytes / seconds / 1e9 << " GB/s, max difference " << diff << std::endl;
+
+    std::vector<double> xt(m, 0.5), yt(n);
+    seconds = best_seconds([&] { gemv(true, 1.0, a, xt.data(), 0.0, yt.data()); });
+    std::cout << "dgemv transposed: " << bytes / seconds / 1e9 << " GB/s" << std::endl;
+
+    MatrixF32 af(m, n);
+    af.randomize();
+    std::vector<float> xf(n, 0.5f), yf(m);
+    seconds = best_seconds([&] { gemv(false, 1.0f, af, xf.data(), 0.0f, yf.data()); });
+    std::cout << "sgemv: " << bytes / 2 / seconds / 1e9 << " GB/s" << std::endl;
+
+    // One dot product per row pair of two matrices
+    Matrix b(m, n);
+    b.randomize();
+    std::vector<double> dots(m);
+    seconds = best_seconds([&] {
+        ddot_batch_strided(n, a.row(0), a.getStride(), b.row(0), b.getStride(), dots.data(), m);
+    });
+    std::cout << "ddot batch of " << m << " x " << n << ": " << 2 * bytes / seconds / 1e9 << " GB/s" << std::endl;
+}
@@ -0,0 +1,39 @@
+#ifndef GEMV_H
+#define GEMV_H
+
+#include <cstddef>
+#include "matrix_operations.h"
+
+// Matrix-vector products and batched dot products. Unlike GEMM these read
+// every matrix element once, so they are bound by memory bandwidth: the
+// kernels (AVX2 or SSE2) keep several independent accumulators in flight
+// and split rows across the thread pool. num_threads caps the workers
+// (0 = global pool); results do not depend on it.
+
+// y = alpha * A * x + beta * y for row-major A (m x n) with leading
+// dimension lda, x of length n and y of length m. With transposed set,
+// y = alpha * A^T * x + beta * y with x of length m and y of length n.
+// y is not read when beta == 0 and must not overlap A or x.
+void dgemv(bool transposed, size_t m, size_t n, double alpha, const double* a, size_t lda,
+           const double* x, double beta, double* y, size_t num_threads = 0);
+void sgemv(bool transposed, size_t m, size_t n, float alpha, const float* a, size_t lda,
+           const float* x, float beta, float* y, size_t num_threads = 0);
+
+// The same on views, in place of multiply() with a one-column matrix
+void gemv(bool transposed, double alpha, const ConstMatrixView& a, const double* x, double beta, double* y,
+          size_t num_threads = 0);
+void gemv(bool transposed, float alpha, const ConstMatrixViewF32& a, const float* x, float beta, float* y,
+          size_t num_threads = 0);
+
+// result[i] = x_i . y_i for batch_count pairs of length-n vectors.
+// Strided batch: x_i starts at x + i * stride_x, and likewise for y.
+void ddot_batch_strided(size_t n, const double* x, size_t stride_x, const double* y, size_t stride_y,
+                        double* result, size_t batch_count, size_t num_threads = 0);
+// Pointer-array batch: x_i is x[i] and y_i is y[i]
+void ddot_batch(size_t n, const double* const* x, const double* const* y, double* result,
+                size_t batch_count, size_t num_threads = 0);
+
+// Benchmark function: GEMV and batched dot GB/s against multiply()
+void benchmark_gemv();
+
+#endif // GEMV_H
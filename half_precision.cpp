@@ -0,0 +1,65 @@
+#include "half_precision.h"
+#include "cpu_features.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+#if USE_X86_SIMD
+TARGET_AVX2
+static size_t bf16_to_float_avx2(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m256i w = _mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16);
+        _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(w));
+    }
+    return i;
+}
+
+TARGET_F16C
+static size_t f16_to_float_f16c(const uint16_t* src, float* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+#endif
+
+void convert_to_float(const bfloat16* src, float* dst, size_t n) {
+    size_t i = 0;
+#if USE_X86_SIMD
+    const uint16_t* bits = reinterpret_cast<const uint16_t*>(src);
+    if (cpu_features().avx2) {
+        i = bf16_to_float_avx2(bits, dst, n);
+    } else {
+        // SSE2: interleaving zeros below each value is a shift left by 16
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bits + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi16(zero, h));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(zero, h));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+void convert_to_float(const float16* src, float* dst, size_t n) {
+    size_t i = 0;
+#if USE_X86_SIMD
+    if (cpu_features().f16c) {
+        i = f16_to_float_f16c(reinterpret_cast<const uint16_t*>(src), dst, n);
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
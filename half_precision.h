@@ -0,0 +1,93 @@
+#ifndef HALF_PRECISION_H
+#define HALF_PRECISION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 16-bit floating point storage types. They only hold values; arithmetic
+// converts to float, and GEMM on them accumulates in fp32.
+
+// bfloat16: the top half of an IEEE float (8-bit exponent, 7-bit mantissa)
+struct bfloat16 {
+    uint16_t bits;
+
+    bfloat16() : bits(0) {}
+    explicit bfloat16(float f) {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+        if ((x & 0x7FFFFFFFu) > 0x7F800000u) {
+            bits = static_cast<uint16_t>((x >> 16) | 0x40u);   // keep NaN quiet
+        } else {
+            x += 0x7FFFu + ((x >> 16) & 1u);                  // round to nearest even
+            bits = static_cast<uint16_t>(x >> 16);
+        }
+    }
+
+    operator float() const {
+        uint32_t x = static_cast<uint32_t>(bits) << 16;
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+};
+
+// float16: IEEE 754 binary16 (5-bit exponent, 10-bit mantissa)
+struct float16 {
+    uint16_t bits;
+
+    float16() : bits(0) {}
+    explicit float16(float f) {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+        uint32_t sign = (x >> 16) & 0x8000u;
+        uint32_t abs = x & 0x7FFFFFFFu;
+        if (abs >= 0x7F800000u) {
+            // Inf stays Inf, NaN stays a quiet NaN
+            bits = static_cast<uint16_t>(sign | 0x7C00u | (abs > 0x7F800000u ? 0x200u : 0u));
+        } else if (abs >= 0x477FF000u) {
+            // 65520 and above round to Inf
+            bits = static_cast<uint16_t>(sign | 0x7C00u);
+        } else if (abs < 0x38800000u) {
+            // Subnormal or zero: adding 0.5f lines the half ulp (2^-24) up with
+            // the float ulp, so the FPU does the round-to-nearest-even
+            float a;
+            std::memcpy(&a, &abs, sizeof(a));
+            a += 0.5f;
+            uint32_t r;
+            std::memcpy(&r, &a, sizeof(r));
+            bits = static_cast<uint16_t>(sign | (r - 0x3F000000u));
+        } else {
+            // Normal: rebias the exponent (127 -> 15) and round to nearest even
+            uint32_t mant_odd = (abs >> 13) & 1u;
+            abs += 0xC8000FFFu + mant_odd;
+            bits = static_cast<uint16_t>(sign | (abs >> 13));
+        }
+    }
+
+    operator float() const {
+        uint32_t sign = static_cast<uint32_t>(bits & 0x8000u) << 16;
+        uint32_t exp = (bits >> 10) & 0x1Fu;
+        uint32_t mant = bits & 0x3FFu;
+        uint32_t x;
+        if (exp == 0x1F) {
+            x = sign | 0x7F800000u | (mant << 13);
+        } else if (exp != 0) {
+            x = sign | ((exp + 112) << 23) | (mant << 13);
+        } else {
+            // Zero or subnormal: mant * 2^-24 is exact in float
+            float f = static_cast<float>(mant) * 5.9604644775390625e-8f;
+            std::memcpy(&x, &f, sizeof(x));
+            x |= sign;
+        }
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+};
+
+// Bulk widening to float, vectorized (SSE2/AVX2 for bf16, F16C for fp16)
+void convert_to_float(const bfloat16* src, float* dst, size_t n);
+void convert_to_float(const float16* src, float* dst, size_t n);
+
+#endif // HALF_PRECISION_H
@@ -1,8 +1,13 @@
 #include "hash_operations.h"
+#include "bench_util.h"
+#include "cpu_features.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <vector>
-#include <chrono>
-#include <iomanip>
 
 #ifdef __x86_64__
 #include <immintrin.h>
@@ -11,34 +16,213 @@
 #define USE_X86_SIMD 0
 #endif
 
-unsigned long long compute_hash(const char* data, size_t len) {
-    unsigned long long hash = 5381;
-    size_t i = 0;
+// Bytes folded into the hash at once by the vector kernels
+static const size_t kHashBlock = 512;
+// Powers of 33 are split into 15-bit digits, so that byte * digit products
+// fit the signed 16-bit multiplies of pmaddwd; five digits cover 64 bits
+static const int kHashDigits = 5;
+static const int kHashDigitBits = 15;
+
+// Byte i of a block of n <= kHashBlock bytes is weighted by 33^(n - 1 - i),
+// which is entry kHashBlock - n + i of the digit tables
+struct HashTables {
+    int16_t digits[kHashDigits][kHashBlock];
+    unsigned long long pow33[kHashBlock + 1];
+
+    HashTables() {
+        pow33[0] = 1;
+        for (size_t i = 1; i <= kHashBlock; i++) {
+            pow33[i] = pow33[i - 1] * 33;
+        }
+        for (size_t i = 0; i < kHashBlock; i++) {
+            unsigned long long p = pow33[kHashBlock - 1 - i];
+            for (int d = 0; d < kHashDigits; d++) {
+                digits[d][i] = static_cast<int16_t>((p >> (d * kHashDigitBits)) & 0x7FFF);
+            }
+        }
+    }
+};
+
+static const HashTables& hash_tables() {
+    static const HashTables tables;
+    return tables;
+}
+
+static unsigned long long hash_scalar(unsigned long long hash, const unsigned char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + data[i];
+    }
+    return hash;
+}
+
+// Sum over digits d of 2^(15 d) times the lanes of sums[d], mod 2^64. A lane
+// adds at most 128 products below 2^23 per block, so none overflows.
+static unsigned long long combine_digits(const uint32_t* sums, size_t lanes) {
+    unsigned long long total = 0;
+    for (int d = 0; d < kHashDigits; d++) {
+        unsigned long long digit = 0;
+        for (size_t l = 0; l < lanes; l++) {
+            digit += sums[d * lanes + l];
+        }
+        total += digit << (d * kHashDigitBits);
+    }
+    return total;
+}
 
 #if USE_X86_SIMD
-    // x86-64 optimized path using SSE2
-    for (; i + 16 <= len; i += 16) {
-        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
-
-        // Extract bytes and update hash
-        for (int j = 0; j < 16; j++) {
-            unsigned char byte = _mm_extract_epi16(chunk, j / 2);
-            if (j % 2 == 0) {
-                byte = byte & 0xFF;
-            } else {
-                byte = (byte >> 8) & 0xFF;
+static unsigned long long hash_sse2(unsigned long long hash, const unsigned char* data, size_t len) {
+    const HashTables& t = hash_tables();
+    const __m128i zero = _mm_setzero_si128();
+    while (len >= 16) {
+        const size_t n = std::min(len, kHashBlock) / 16 * 16;
+        const size_t offset = kHashBlock - n;
+        __m128i acc[kHashDigits];
+        for (int d = 0; d < kHashDigits; d++) {
+            acc[d] = zero;
+        }
+        for (size_t i = 0; i < n; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+            __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+            for (int d = 0; d < kHashDigits; d++) {
+                const int16_t* w = t.digits[d] + offset + i;
+                __m128i plo = _mm_madd_epi16(lo, _mm_loadu_si128(reinterpret_cast<const __m128i*>(w)));
+                __m128i phi = _mm_madd_epi16(hi, _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + 8)));
+                acc[d] = _mm_add_epi32(acc[d], _mm_add_epi32(plo, phi));
+            }
+        }
+        uint32_t sums[kHashDigits * 4];
+        for (int d = 0; d < kHashDigits; d++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + d * 4), acc[d]);
+        }
+        hash = hash * t.pow33[n] + combine_digits(sums, 4);
+        data += n;
+        len -= n;
+    }
+    return hash_scalar(hash, data, len);
+}
+
+TARGET_AVX2 static unsigned long long hash_avx2(unsigned long long hash, const unsigned char* data, size_t len) {
+    const HashTables& t = hash_tables();
+    while (len >= 32) {
+        const size_t n = std::min(len, kHashBlock) / 32 * 32;
+        const size_t offset = kHashBlock - n;
+        __m256i acc[kHashDigits];
+        for (int d = 0; d < kHashDigits; d++) {
+            acc[d] = _mm256_setzero_si256();
+        }
+        for (size_t i = 0; i < n; i += 32) {
+            __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+            __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)));
+            for (int d = 0; d < kHashDigits; d++) {
+                const int16_t* w = t.digits[d] + offset + i;
+                __m256i plo = _mm256_madd_epi16(lo, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w)));
+                __m256i phi = _mm256_madd_epi16(hi, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + 16)));
+                acc[d] = _mm256_add_epi32(acc[d], _mm256_add_epi32(plo, phi));
             }
-            hash = ((hash << 5) + hash) + byte;
         }
+        uint32_t sums[kHashDigits * 8];
+        for (int d = 0; d < kHashDigits; d++) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + d * 8), acc[d]);
+        }
+        hash = hash * t.pow33[n] + combine_digits(sums, 8);
+        data += n;
+        len -= n;
     }
+    return hash_scalar(hash, data, len);
+}
 #endif
 
-    // Process remaining bytes (or all bytes on non-x86)
-    for (; i < len; i++) {
-        hash = ((hash << 5) + hash) + data[i];
+// Folds len bytes into hash with the widest kernel the CPU supports
+static unsigned long long hash_update(unsigned long long hash, const unsigned char* data, size_t len) {
+#if USE_X86_SIMD
+    if (cpu_features().avx2) {
+        return hash_avx2(hash, data, len);
     }
+    return hash_sse2(hash, data, len);
+#else
+    return hash_scalar(hash, data, len);
+#endif
+}
 
-    return hash;
+// 33^n mod 2^64 by square-and-multiply
+static unsigned long long pow33(size_t n) {
+    unsigned long long result = 1;
+    unsigned long long base = 33;
+    while (n > 0) {
+        if (n & 1) {
+            result *= base;
+        }
+        base *= base;
+        n >>= 1;
+    }
+    return result;
+}
+
+unsigned long long compute_hash(const char* data, size_t len) {
+    return hash_update(5381, reinterpret_cast<const unsigned char*>(data), len);
+}
+
+// Chunks hashed independently by compute_hash_parallel, and the smallest
+// input worth splitting
+static const size_t kHashChunk = 1 << 18;
+static const size_t kHashParallelMin = 1 << 21;
+
+unsigned long long compute_hash_parallel(const char* data, size_t len, size_t num_threads) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    const size_t chunks = (len + kHashChunk - 1) / kHashChunk;
+    if (len < kHashParallelMin || std::min(resolve_threads(num_threads), chunks) <= 1) {
+        return compute_hash(data, len);
+    }
+
+    // Each chunk is hashed from zero: H(a || b) = H(a) * 33^|b| + H_0(b)
+    std::vector<unsigned long long> partial(chunks);
+    parallel_blocks(chunks, len, kHashParallelMin, num_threads, [&](size_t chunk) {
+        size_t begin = chunk * kHashChunk;
+        partial[chunk] = hash_update(0, bytes + begin, std::min(kHashChunk, len - begin));
+    });
+
+    const unsigned long long chunk_power = pow33(kHashChunk);
+    unsigned long long hash = 5381;
+    for (size_t chunk = 0; chunk + 1 < chunks; chunk++) {
+        hash = hash * chunk_power + partial[chunk];
+    }
+    return hash * pow33(len - (chunks - 1) * kHashChunk) + partial[chunks - 1];
+}
+
+StreamingHash::StreamingHash() {
+    static_assert(kBufferSize == kHashBlock, "StreamingHash buffers one kernel block");
+    reset();
+}
+
+void StreamingHash::reset() {
+    hash = 5381;
+    buffered = 0;
+}
+
+void StreamingHash::update(const char* data, size_t len) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (buffered > 0) {
+        size_t take = std::min(len, kBufferSize - buffered);
+        std::memcpy(buffer + buffered, bytes, take);
+        buffered += take;
+        bytes += take;
+        len -= take;
+        if (buffered < kBufferSize) {
+            return;
+        }
+        hash = hash_update(hash, buffer, kBufferSize);
+        buffered = 0;
+    }
+    // Whole blocks go straight to the kernels; only the tail is copied
+    size_t direct = len / kBufferSize * kBufferSize;
+    hash = hash_update(hash, bytes, direct);
+    std::memcpy(buffer, bytes + direct, len - direct);
+    buffered = len - direct;
+}
+
+unsigned long long StreamingHash::finalize() const {
+    return hash_update(hash, buffer, buffered);
 }
 
 void benchmark_hashing() {
@@ -52,13 +236,35 @@ void benchmark_hashing() {
         data[i] = static_cast<char>(i % 256);
     }
 
-    auto start = std::chrono::high_resolution_clock::now();
-    unsigned long long hash = compute_hash(data.data(), data_size);
-    auto end = std::chrono::high_resolution_clock::now();
-
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    unsigned long long scalar = 0;
+    double scalar_seconds = best_seconds([&] {
+        scalar = hash_scalar(5381, reinterpret_cast<const unsigned char*>(data.data()), data_size);
+    });
+    unsigned long long hash = 0;
+    double seconds = best_seconds([&] { hash = compute_hash(data.data(), data_size); });
 
     std::cout << "Data size: " << data_size / 1024 << " KB" << std::endl;
-    std::cout << "Time: " << duration.count() << " ms" << std::endl;
+    std::cout << "Time: " << static_cast<long>(seconds * 1000) << " ms" << std::endl;
     std::cout << "Hash: 0x" << std::hex << hash << std::dec << std::endl;
+    std::cout << "Scalar loop: " << data_size / scalar_seconds / 1e9 << " GB/s, SIMD: "
+              << data_size / seconds / 1e9 << " GB/s" << (hash == scalar ? "" : ", MISMATCH") << std::endl;
+
+    unsigned long long parallel = 0;
+    double parallel_seconds = best_seconds([&] { parallel = compute_hash_parallel(data.data(), data_size); });
+    std::cout << "Parallel (" << global_thread_pool().size() << " threads): "
+              << data_size / parallel_seconds / 1e9 << " GB/s" << (parallel == hash ? "" : ", MISMATCH")
+              << std::endl;
+
+    // Network-packet sized fragments through the streaming hasher
+    const size_t fragment = 1500;
+    unsigned long long streamed = 0;
+    double streamed_seconds = best_seconds([&] {
+        StreamingHash hasher;
+        for (size_t i = 0; i < data_size; i += fragment) {
+            hasher.update(data.data() + i, std::min(fragment, data_size - i));
+        }
+        streamed = hasher.finalize();
+    });
+    std::cout << "Streaming (" << fragment << "-byte updates): " << data_size / streamed_seconds / 1e9
+              << " GB/s" << (streamed == hash ? "" : ", MISMATCH") << std::endl;
 }
@@ -3,9 +3,41 @@
 
 #include <cstddef>
 
-// Hash computation using x86 SSE2 for parallel processing
+// 64-bit DJB2: hash = hash * 33 + byte from 5381, mod 2^64, with bytes
+// read as unsigned. The hash is a polynomial in 33, so the AVX2 and SSE2
+// kernels fold 512-byte blocks at once as hash * 33^n plus the bytes
+// weighted by precomputed powers of 33; the result is bit-exact with the
+// byte-at-a-time definition.
 unsigned long long compute_hash(const char* data, size_t len);
 
+// Same value as compute_hash, from 256 KB chunks hashed on the global pool
+// and chained with powers of 33 (0 threads = the whole pool). Inputs under
+// 2 MB are hashed on the calling thread.
+unsigned long long compute_hash_parallel(const char* data, size_t len, size_t num_threads = 0);
+
+// Incremental compute_hash for input that arrives in fragments: after
+// update() over any split of the data, finalize() returns the one-shot
+// hash of their concatenation. Fragments are gathered into whole blocks
+// for the vector kernels, so small updates stay on the SIMD path.
+class StreamingHash {
+private:
+    static const size_t kBufferSize = 512;
+
+    unsigned long long hash;
+    unsigned char buffer[kBufferSize];
+    size_t buffered;
+
+public:
+    StreamingHash();
+
+    // Starts a new hash, dropping anything fed so far
+    void reset();
+    void update(const char* data, size_t len);
+    // Hash of everything fed since the last reset; further updates continue
+    // from the same state
+    unsigned long long finalize() const;
+};
+
 // Benchmark function
 void benchmark_hashing();
 
@@ -4,10 +4,25 @@
  */
 
 #include <iostream>
+#include <cstring>
 #include "matrix_operations.h"
+#include "matrix_expr.h"
+#include "gemm_tuner.h"
+#include "gemv.h"
+#include "fixed_matrix.h"
+#include "quantized_gemm.h"
+#include "sparse_matrix.h"
+#include "strassen.h"
+#include "tiled_matrix.h"
+#include "transpose.h"
+#include "reductions.h"
+#include "elementwise.h"
+#include "factorization.h"
+#include "random_fill.h"
 #include "hash_operations.h"
 #include "string_search.h"
 #include "memory_operations.h"
+#include "numa.h"
 #include "polynomial_eval.h"
 
 #ifdef __x86_64__
@@ -16,7 +31,65 @@
 #define USE_X86_SIMD 0
 #endif
 
-int main() {
+struct BenchmarkEntry {
+    const char* name;
+    void (*run)();
+    bool in_default_run;
+};
+
+// Run in this order when no benchmark names are given on the command line;
+// the rest only run when named
+static const BenchmarkEntry kBenchmarks[] = {
+    { "matrix", benchmark_matrix_ops, true },
+    { "small-matrix", benchmark_small_matrix_ops, true },
+    { "matrix-expr", benchmark_matrix_expr, true },
+    { "batched-matrix", benchmark_batched_matrix_ops, true },
+    { "quantized-matrix", benchmark_quantized_matrix_ops, true },
+    { "sparse-matrix", benchmark_sparse_ops, true },
+    { "strassen", benchmark_strassen, true },
+    { "tiled-matrix", benchmark_tiled_matrix, false },
+    { "tune", benchmark_gemm_tune, false },
+    { "transpose", benchmark_transpose, true },
+    { "reductions", benchmark_reductions, true },
+    { "elementwise", benchmark_elementwise, true },
+    { "gemv", benchmark_gemv, true },
+    { "factorization", benchmark_factorization, true },
+    { "random", benchmark_random, true },
+    { "hash", benchmark_hashing, true },
+    { "string", benchmark_string_ops, true },
+    { "memory", benchmark_memory_ops, true },
+    { "numa", benchmark_numa, true },
+    { "polynomial", benchmark_polynomial, true },
+};
+
+static const size_t kNumBenchmarks = sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+
+static const BenchmarkEntry* find_benchmark(const char* name) {
+    for (size_t i = 0; i < kNumBenchmarks; i++) {
+        if (std::strcmp(kBenchmarks[i].name, name) == 0) {
+            return &kBenchmarks[i];
+        }
+    }
+    return nullptr;
+}
+
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [benchmark...]" << std::endl;
+    std::cerr << "Benchmarks:";
+    for (size_t i = 0; i < kNumBenchmarks; i++) {
+        std::cerr << " " << kBenchmarks[i].name;
+    }
+    std::cerr << std::endl;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (find_benchmark(argv[i]) == nullptr) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
     std::cout << "========================================" << std::endl;
     std::cout << "  Compute Benchmark Suite" << std::endl;
 #if USE_X86_SIMD
@@ -26,13 +99,21 @@ int main() {
     std::cout << "  NOTE: This code is optimized for x86-64" << std::endl;
 #endif
     std::cout << "========================================" << std::endl;
+    std::cout << "Random seed: " << get_random_seed() << std::endl;
 
-    // Run all benchmarks
-    benchmark_matrix_ops();
-    benchmark_hashing();
-    benchmark_string_ops();
-    benchmark_memory_ops();
-    benchmark_polynomial();
+    if (argc > 1) {
+        // Run only the named benchmarks
+        for (int i = 1; i < argc; i++) {
+            find_benchmark(argv[i])->run();
+        }
+    } else {
+        // Run all benchmarks
+        for (size_t i = 0; i < kNumBenchmarks; i++) {
+            if (kBenchmarks[i].in_default_run) {
+                kBenchmarks[i].run();
+            }
+        }
+    }
 
     std::cout << "\n========================================" << std::endl;
     std::cout << "  All benchmarks completed!" << std::endl;
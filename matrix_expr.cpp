@@ -0,0 +1,84 @@
+#include "matrix_expr.h"
+#include <chrono>
+#include <iostream>
+
+// Step-by-step baselines: each operation writes a full temporary, as
+// separate Matrix operations would
+static Matrix scaled_copy(double alpha, const Matrix& a) {
+    Matrix result(a.getRows(), a.getCols());
+    for (size_t i = 0; i < a.getRows(); i++) {
+        const double* src = a.row(i);
+        double* dst = result.row(i);
+        for (size_t j = 0; j < a.getCols(); j++) {
+            dst[j] = alpha * src[j];
+        }
+    }
+    return result;
+}
+
+static Matrix added(const Matrix& a, const Matrix& b) {
+    Matrix result(a.getRows(), a.getCols());
+    for (size_t i = 0; i < a.getRows(); i++) {
+        const double* x = a.row(i);
+        const double* y = b.row(i);
+        double* dst = result.row(i);
+        for (size_t j = 0; j < a.getCols(); j++) {
+            dst[j] = x[j] + y[j];
+        }
+    }
+    return result;
+}
+
+template <typename F>
+static double time_ms(const F& fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void benchmark_matrix_expr() {
+    std::cout << "\n=== Matrix Expression Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    // E = alpha*A + B*beta - C: three inputs, one output
+    const size_t size = 2000;
+    Matrix a(size, size);
+    Matrix b(size, size);
+    Matrix c(size, size);
+    a.randomize();
+    b.randomize();
+    c.randomize();
+    Matrix e(size, size);
+
+    double stepwise_ms = time_ms([&] {
+        e = added(added(scaled_copy(0.5, a), scaled_copy(2.0, b)), scaled_copy(-1.0, c));
+    });
+    double stepwise_sum = e.sum();
+    double fused_ms = time_ms([&] { e = 0.5 * a + b * 2.0 - c; });
+    double bytes = 4.0 * size * size * sizeof(double);
+
+    std::cout << "E = 0.5*A + B*2 - C, " << size << "x" << size << std::endl;
+    std::cout << "Step by step: " << stepwise_ms << " ms" << std::endl;
+    std::cout << "Fused: " << fused_ms << " ms, " << bytes / fused_ms / 1e6 << " GB/s" << std::endl;
+    std::cout << "Result sum: " << stepwise_sum << ", " << e.sum() << std::endl;
+
+    // D = A*B + C: the add folds into the GEMM epilogue
+    const size_t gemm_size = 1000;
+    Matrix ga(gemm_size, gemm_size);
+    Matrix gb(gemm_size, gemm_size);
+    Matrix gc(gemm_size, gemm_size);
+    ga.randomize();
+    gb.randomize();
+    gc.randomize();
+    Matrix d(gemm_size, gemm_size);
+
+    stepwise_ms = time_ms([&] { d = added(ga.multiply(gb), gc); });
+    stepwise_sum = d.sum();
+    fused_ms = time_ms([&] { d = ga * gb + gc; });
+
+    std::cout << "D = A*B + C, " << gemm_size << "x" << gemm_size << std::endl;
+    std::cout << "Step by step: " << stepwise_ms << " ms" << std::endl;
+    std::cout << "Fused: " << fused_ms << " ms" << std::endl;
+    std::cout << "Result sum: " << stepwise_sum << ", " << d.sum() << std::endl;
+}
@@ -0,0 +1,548 @@
+#ifndef MATRIX_EXPR_H
+#define MATRIX_EXPR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "matrix_operations.h"
+#include "thread_pool.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define MATRIX_EXPR_X86_SIMD 1
+#else
+#define MATRIX_EXPR_X86_SIMD 0
+#endif
+
+// Lazy expressions over Matrix and MatrixF32 and views of them.
+//
+// Operators on matrices and views build a small tree of nodes instead of
+// computing, and assigning the tree to a matrix or view evaluates it:
+//  - element-wise terms (+, -, scalar *, unary -, hadamard) are fused into a
+//    single pass that reads each operand once and writes the result once;
+//  - A * B becomes a GEMM call, and a product added to or subtracted from
+//    other terms is accumulated with beta = 1, so the add happens in the
+//    GEMM epilogue: D = A*B + C copies C into D and multiplies into it.
+// Products take matrices or views, not expressions, as operands. Nodes hold
+// views, so an expression must not outlive the memory it reads.
+//
+// Every node provides rows(), cols(), references(d) (does any operand
+// overlap the destination view d) and safe_target(d) (can the result be
+// written to d while it is still being read). Element-wise nodes also
+// provide at(i, j) and a SIMD packet(i, j); the others provide
+// assign_to(d, s) (d = s * expr) and add_to(d, s) (d += s * expr).
+
+template <typename E>
+struct MatrixExpr {
+    const E& derived() const { return static_cast<const E&>(*this); }
+};
+
+// SSE2 packets for the fused pass; width 1 elsewhere
+template <typename T>
+struct ExprPacket {
+    typedef T type;
+    static const size_t width = 1;
+    static type load(const T* p) { return *p; }
+    static void store(T* p, type v) { *p = v; }
+    static type set1(T v) { return v; }
+    static type add(type a, type b) { return a + b; }
+    static type sub(type a, type b) { return a - b; }
+    static type mul(type a, type b) { return a * b; }
+};
+
+#if MATRIX_EXPR_X86_SIMD
+template <>
+struct ExprPacket<double> {
+    typedef __m128d type;
+    static const size_t width = 2;
+    static type load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, type v) { _mm_storeu_pd(p, v); }
+    static type set1(double v) { return _mm_set1_pd(v); }
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+};
+
+template <>
+struct ExprPacket<float> {
+    typedef __m128 type;
+    static const size_t width = 4;
+    static type load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, type v) { _mm_storeu_ps(p, v); }
+    static type set1(float v) { return _mm_set1_ps(v); }
+    static type add(type a, type b) { return _mm_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+};
+#endif
+
+// Below this many elements the fused pass runs on the calling thread
+static const size_t kExprParallelMinElements = 1 << 16;
+
+// d = scale * e, or d += scale * e, in one pass over rows split across the pool
+template <typename T, typename E>
+void eval_elementwise(const BasicMatrixView<T>& d, const E& e, T scale, bool accumulate) {
+    typedef ExprPacket<T> P;
+    const size_t rows = e.rows();
+    const size_t cols = e.cols();
+
+    auto run_rows = [&](size_t begin, size_t end) {
+        const typename P::type s = P::set1(scale);
+        for (size_t i = begin; i < end; i++) {
+            T* out = d.row(i);
+            size_t j = 0;
+            for (; j + P::width <= cols; j += P::width) {
+                typename P::type v = P::mul(s, e.packet(i, j));
+                if (accumulate) {
+                    v = P::add(P::load(out + j), v);
+                }
+                P::store(out + j, v);
+            }
+            for (; j < cols; j++) {
+                T v = scale * e.at(i, j);
+                out[j] = accumulate ? out[j] + v : v;
+            }
+        }
+    };
+
+    size_t threads = 1;
+    if (rows * cols >= kExprParallelMinElements) {
+        threads = std::min(global_thread_pool().size(), rows);
+    }
+    if (threads <= 1) {
+        run_rows(0, rows);
+        return;
+    }
+    global_thread_pool().parallel_for(threads, [&](size_t t) {
+        run_rows(rows * t / threads, rows * (t + 1) / threads);
+    });
+}
+
+// Route a node to the fused pass or to its own assign_to/add_to
+template <typename E, bool Elementwise = E::elementwise>
+struct ExprEval {
+    typedef typename E::value_type T;
+    static void assign(const BasicMatrixView<T>& d, const E& e, T s) { eval_elementwise(d, e, s, false); }
+    static void add(const BasicMatrixView<T>& d, const E& e, T s) { eval_elementwise(d, e, s, true); }
+};
+
+template <typename E>
+struct ExprEval<E, false> {
+    typedef typename E::value_type T;
+    static void assign(const BasicMatrixView<T>& d, const E& e, T s) { e.assign_to(d, s); }
+    static void add(const BasicMatrixView<T>& d, const E& e, T s) { e.add_to(d, s); }
+};
+
+static inline void check_expr_shapes(size_t r1, size_t c1, size_t r2, size_t c2) {
+    if (r1 != r2 || c1 != c2) {
+        throw std::runtime_error("Invalid matrix dimensions for element-wise operation");
+    }
+}
+
+// A matrix or view operand
+template <typename T>
+class MatrixLeaf : public MatrixExpr<MatrixLeaf<T> > {
+private:
+    BasicConstMatrixView<T> m;
+
+public:
+    typedef T value_type;
+    typedef typename ExprPacket<T>::type packet_type;
+    static const bool elementwise = true;
+
+    explicit MatrixLeaf(const BasicConstMatrixView<T>& view) : m(view) {}
+
+    size_t rows() const { return m.getRows(); }
+    size_t cols() const { return m.getCols(); }
+    T at(size_t i, size_t j) const { return m(i, j); }
+    packet_type packet(size_t i, size_t j) const { return ExprPacket<T>::load(m.row(i) + j); }
+    bool references(const BasicConstMatrixView<T>& d) const { return views_overlap(m, d); }
+    // A fused pass reads each element before writing it, so only a shifted
+    // overlap with the destination is unsafe
+    bool safe_target(const BasicConstMatrixView<T>& d) const {
+        return !references(d) || (m.row(0) == d.row(0) && m.getStride() == d.getStride());
+    }
+};
+
+struct ExprAdd {
+    static const int sign = 1;
+    template <typename T>
+    static T apply(T a, T b) { return a + b; }
+    template <typename T>
+    static typename ExprPacket<T>::type apply_packet(typename ExprPacket<T>::type a,
+                                                     typename ExprPacket<T>::type b) {
+        return ExprPacket<T>::add(a, b);
+    }
+};
+
+struct ExprSub {
+    static const int sign = -1;
+    template <typename T>
+    static T apply(T a, T b) { return a - b; }
+    template <typename T>
+    static typename ExprPacket<T>::type apply_packet(typename ExprPacket<T>::type a,
+                                                     typename ExprPacket<T>::type b) {
+        return ExprPacket<T>::sub(a, b);
+    }
+};
+
+struct ExprMul {
+    template <typename T>
+    static T apply(T a, T b) { return a * b; }
+    template <typename T>
+    static typename ExprPacket<T>::type apply_packet(typename ExprPacket<T>::type a,
+                                                     typename ExprPacket<T>::type b) {
+        return ExprPacket<T>::mul(a, b);
+    }
+};
+
+// Element-wise combination of two element-wise operands
+template <typename L, typename R, typename Op>
+class BinaryExpr : public MatrixExpr<BinaryExpr<L, R, Op> > {
+private:
+    L l;
+    R r;
+
+public:
+    typedef typename L::value_type value_type;
+    typedef typename ExprPacket<value_type>::type packet_type;
+    static const bool elementwise = true;
+
+    BinaryExpr(const L& left, const R& right) : l(left), r(right) {
+        check_expr_shapes(l.rows(), l.cols(), r.rows(), r.cols());
+    }
+
+    size_t rows() const { return l.rows(); }
+    size_t cols() const { return l.cols(); }
+    value_type at(size_t i, size_t j) const { return Op::apply(l.at(i, j), r.at(i, j)); }
+    packet_type packet(size_t i, size_t j) const {
+        return Op::template apply_packet<value_type>(l.packet(i, j), r.packet(i, j));
+    }
+    bool references(const BasicConstMatrixView<value_type>& d) const {
+        return l.references(d) || r.references(d);
+    }
+    bool safe_target(const BasicConstMatrixView<value_type>& d) const {
+        return l.safe_target(d) && r.safe_target(d);
+    }
+};
+
+// alpha * e; element-wise exactly when e is
+template <typename E>
+class ScaledExpr : public MatrixExpr<ScaledExpr<E> > {
+private:
+    typename E::value_type alpha;
+    E e;
+
+public:
+    typedef typename E::value_type value_type;
+    typedef typename ExprPacket<value_type>::type packet_type;
+    static const bool elementwise = E::elementwise;
+
+    ScaledExpr(value_type scale, const E& expr) : alpha(scale), e(expr) {}
+
+    size_t rows() const { return e.rows(); }
+    size_t cols() const { return e.cols(); }
+    value_type at(size_t i, size_t j) const { return alpha * e.at(i, j); }
+    packet_type packet(size_t i, size_t j) const {
+        return ExprPacket<value_type>::mul(ExprPacket<value_type>::set1(alpha), e.packet(i, j));
+    }
+    void assign_to(const BasicMatrixView<value_type>& d, value_type s) const {
+        ExprEval<E>::assign(d, e, s * alpha);
+    }
+    void add_to(const BasicMatrixView<value_type>& d, value_type s) const {
+        ExprEval<E>::add(d, e, s * alpha);
+    }
+    bool references(const BasicConstMatrixView<value_type>& d) const { return e.references(d); }
+    bool safe_target(const BasicConstMatrixView<value_type>& d) const { return e.safe_target(d); }
+};
+
+// alpha * A * B, evaluated by gemm straight into the destination
+template <typename T>
+class ProductExpr : public MatrixExpr<ProductExpr<T> > {
+private:
+    T alpha;
+    BasicConstMatrixView<T> a;
+    BasicConstMatrixView<T> b;
+
+public:
+    typedef T value_type;
+    static const bool elementwise = false;
+
+    ProductExpr(const BasicConstMatrixView<T>& left, const BasicConstMatrixView<T>& right)
+        : alpha(1), a(left), b(right) {
+        if (a.getCols() != b.getRows()) {
+            throw std::runtime_error("Invalid matrix dimensions for multiplication");
+        }
+    }
+
+    size_t rows() const { return a.getRows(); }
+    size_t cols() const { return b.getCols(); }
+    void assign_to(const BasicMatrixView<T>& d, T s) const { gemm<T>(s * alpha, a, b, T(0), d); }
+    void add_to(const BasicMatrixView<T>& d, T s) const { gemm<T>(s * alpha, a, b, T(1), d); }
+    bool references(const BasicConstMatrixView<T>& d) const {
+        return views_overlap(a, d) || views_overlap(b, d);
+    }
+    bool safe_target(const BasicConstMatrixView<T>& d) const { return !references(d); }
+};
+
+// l +- r where at least one side is a product: the element-wise side (if
+// any) is written first, then the products accumulate into it
+template <typename L, typename R>
+class SumExpr : public MatrixExpr<SumExpr<L, R> > {
+private:
+    L l;
+    R r;
+    typename L::value_type sign;
+
+    // Right operand first when only it can be written by a fused pass
+    static const bool right_first = !L::elementwise && R::elementwise;
+
+public:
+    typedef typename L::value_type value_type;
+    static const bool elementwise = false;
+
+    SumExpr(const L& left, const R& right, int op_sign) : l(left), r(right), sign(value_type(op_sign)) {
+        check_expr_shapes(l.rows(), l.cols(), r.rows(), r.cols());
+    }
+
+    size_t rows() const { return l.rows(); }
+    size_t cols() const { return l.cols(); }
+    void assign_to(const BasicMatrixView<value_type>& d, value_type s) const {
+        if (right_first) {
+            ExprEval<R>::assign(d, r, s * sign);
+            ExprEval<L>::add(d, l, s);
+        } else {
+            ExprEval<L>::assign(d, l, s);
+            ExprEval<R>::add(d, r, s * sign);
+        }
+    }
+    void add_to(const BasicMatrixView<value_type>& d, value_type s) const {
+        ExprEval<L>::add(d, l, s);
+        ExprEval<R>::add(d, r, s * sign);
+    }
+    bool references(const BasicConstMatrixView<value_type>& d) const {
+        return l.references(d) || r.references(d);
+    }
+    // Whatever is evaluated second reads the destination after it was written
+    bool safe_target(const BasicConstMatrixView<value_type>& d) const {
+        return right_first ? (r.safe_target(d) && !l.references(d))
+                           : (l.safe_target(d) && !r.references(d));
+    }
+};
+
+// Operand wrapping: matrices and views become leaves, expressions pass
+// through. ExprType has no member for other types, which keeps the generic
+// operators below out of overload resolution for them.
+template <typename X, typename Enable = void>
+struct ExprType {};
+
+template <typename E>
+struct ExprType<E, typename std::enable_if<std::is_base_of<MatrixExpr<E>, E>::value>::type> {
+    typedef E type;
+};
+
+template <typename T>
+struct ExprType<BasicMatrix<T> > {
+    typedef MatrixLeaf<T> type;
+};
+
+template <typename T>
+struct ExprType<BasicMatrixView<T> > {
+    typedef MatrixLeaf<T> type;
+};
+
+template <typename T>
+struct ExprType<BasicConstMatrixView<T> > {
+    typedef MatrixLeaf<T> type;
+};
+
+template <typename T>
+inline MatrixLeaf<T> as_expr(const BasicConstMatrixView<T>& v) { return MatrixLeaf<T>(v); }
+
+template <typename T>
+inline MatrixLeaf<T> as_expr(const BasicMatrixView<T>& v) { return MatrixLeaf<T>(v); }
+
+template <typename T>
+inline MatrixLeaf<T> as_expr(const BasicMatrix<T>& m) { return MatrixLeaf<T>(m.view()); }
+
+template <typename E>
+inline const E& as_expr(const MatrixExpr<E>& e) { return e.derived(); }
+
+// Product operands: matrices and views, not expressions
+template <typename X>
+struct ProductOperand {};
+
+template <typename T>
+struct ProductOperand<BasicMatrix<T> > {
+    typedef T value_type;
+};
+
+template <typename T>
+struct ProductOperand<BasicMatrixView<T> > {
+    typedef T value_type;
+};
+
+template <typename T>
+struct ProductOperand<BasicConstMatrixView<T> > {
+    typedef T value_type;
+};
+
+// + and -: fused when both sides are element-wise, sequenced otherwise
+template <typename L, typename R, typename Op, bool Fused = L::elementwise && R::elementwise>
+struct SumBuilder {
+    typedef BinaryExpr<L, R, Op> type;
+    static type make(const L& l, const R& r) { return type(l, r); }
+};
+
+template <typename L, typename R, typename Op>
+struct SumBuilder<L, R, Op, false> {
+    typedef SumExpr<L, R> type;
+    static type make(const L& l, const R& r) { return type(l, r, Op::sign); }
+};
+
+template <typename L, typename R>
+inline typename SumBuilder<typename ExprType<L>::type, typename ExprType<R>::type, ExprAdd>::type
+operator+(const L& l, const R& r) {
+    typedef SumBuilder<typename ExprType<L>::type, typename ExprType<R>::type, ExprAdd> Builder;
+    return Builder::make(as_expr(l), as_expr(r));
+}
+
+template <typename L, typename R>
+inline typename SumBuilder<typename ExprType<L>::type, typename ExprType<R>::type, ExprSub>::type
+operator-(const L& l, const R& r) {
+    typedef SumBuilder<typename ExprType<L>::type, typename ExprType<R>::type, ExprSub> Builder;
+    return Builder::make(as_expr(l), as_expr(r));
+}
+
+// Scalar multiples
+template <typename E>
+inline ScaledExpr<typename ExprType<E>::type>
+operator*(typename ExprType<E>::type::value_type s, const E& e) {
+    return ScaledExpr<typename ExprType<E>::type>(s, as_expr(e));
+}
+
+template <typename E>
+inline ScaledExpr<typename ExprType<E>::type>
+operator*(const E& e, typename ExprType<E>::type::value_type s) {
+    return ScaledExpr<typename ExprType<E>::type>(s, as_expr(e));
+}
+
+template <typename E>
+inline ScaledExpr<typename ExprType<E>::type> operator-(const E& e) {
+    typedef typename ExprType<E>::type::value_type T;
+    return ScaledExpr<typename ExprType<E>::type>(T(-1), as_expr(e));
+}
+
+// Matrix product; the result type must equal the element type (double, float)
+template <typename L, typename R>
+inline typename std::enable_if<
+    std::is_same<typename ProductOperand<L>::value_type, typename ProductOperand<R>::value_type>::value &&
+        (std::is_same<typename ProductOperand<L>::value_type, double>::value ||
+         std::is_same<typename ProductOperand<L>::value_type, float>::value),
+    ProductExpr<typename ProductOperand<L>::value_type> >::type
+operator*(const L& a, const R& b) {
+    typedef typename ProductOperand<L>::value_type T;
+    return ProductExpr<T>(BasicConstMatrixView<T>(a), BasicConstMatrixView<T>(b));
+}
+
+// Element-wise product of two element-wise operands
+template <typename L, typename R>
+inline BinaryExpr<typename ExprType<L>::type, typename ExprType<R>::type, ExprMul>
+hadamard(const L& l, const R& r) {
+    typedef typename ExprType<L>::type LE;
+    typedef typename ExprType<R>::type RE;
+    static_assert(LE::elementwise && RE::elementwise, "hadamard operands must be element-wise");
+    return BinaryExpr<LE, RE, ExprMul>(as_expr(l), as_expr(r));
+}
+
+// d = e, through a temporary when d is still read after being written
+template <typename T, typename E>
+void expr_assign(const BasicMatrixView<T>& d, const E& e) {
+    check_expr_shapes(d.getRows(), d.getCols(), e.rows(), e.cols());
+    if (!e.safe_target(d)) {
+        BasicMatrix<T> result(e);
+        ExprEval<MatrixLeaf<T> >::assign(d, MatrixLeaf<T>(result.view()), T(1));
+        return;
+    }
+    ExprEval<E>::assign(d, e, T(1));
+}
+
+// d += sign * e. A fused pass may read the destination where it writes it;
+// sequenced terms may not read it at all.
+template <typename T, typename E>
+void expr_add(const BasicMatrixView<T>& d, const E& e, T sign) {
+    check_expr_shapes(d.getRows(), d.getCols(), e.rows(), e.cols());
+    if (E::elementwise ? !e.safe_target(d) : e.references(d)) {
+        BasicMatrix<T> result(e);
+        ExprEval<MatrixLeaf<T> >::add(d, MatrixLeaf<T>(result.view()), sign);
+        return;
+    }
+    ExprEval<E>::add(d, e, sign);
+}
+
+// BasicMatrix and BasicMatrixView members declared in matrix_operations.h
+
+template <typename T>
+template <typename E>
+BasicMatrix<T>::BasicMatrix(const MatrixExpr<E>& expr)
+    : BasicMatrix(expr.derived().rows(), expr.derived().cols()) {
+    ExprEval<E>::assign(view(), expr.derived(), T(1));
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const MatrixExpr<E>& expr) {
+    const E& e = expr.derived();
+    if (!e.safe_target(view())) {
+        // The destination is still an input when it would be overwritten
+        *this = BasicMatrix(expr);
+        return *this;
+    }
+    if (rows != e.rows() || cols != e.cols()) {
+        *this = BasicMatrix(e.rows(), e.cols());
+    }
+    ExprEval<E>::assign(view(), e, T(1));
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const MatrixExpr<E>& expr) {
+    expr_add(view(), expr.derived(), T(1));
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const MatrixExpr<E>& expr) {
+    expr_add(view(), expr.derived(), T(-1));
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicMatrixView<T>& BasicMatrixView<T>::operator=(const MatrixExpr<E>& expr) {
+    expr_assign(*this, expr.derived());
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicMatrixView<T>& BasicMatrixView<T>::operator+=(const MatrixExpr<E>& expr) {
+    expr_add(*this, expr.derived(), T(1));
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicMatrixView<T>& BasicMatrixView<T>::operator-=(const MatrixExpr<E>& expr) {
+    expr_add(*this, expr.derived(), T(-1));
+    return *this;
+}
+
+// Benchmark function: fused expressions against step-by-step temporaries
+void benchmark_matrix_expr();
+
+#endif // MATRIX_EXPR_H
@@ -1,109 +1,455 @@
 #include "matrix_operations.h"
+#include "memory_operations.h"
+#include "gemm.h"
+#include "numa.h"
+#include "random_fill.h"
+#include "reductions.h"
+#include "strassen.h"
+#include "thread_pool.h"
+#include "transpose.h"
+#include <algorithm>
 #include <iostream>
-#include <random>
+#include <cstring>
+#include <utility>
+#include <vector>
 #include <chrono>
 #include <stdexcept>
 
-#ifdef __x86_64__
-#include <immintrin.h>
-#define USE_X86_SIMD 1
-#else
-#define USE_X86_SIMD 0
-#endif
-
-Matrix::Matrix(size_t r, size_t c) : rows(r), cols(c) {
-    data.resize(rows, std::vector<double>(cols, 0.0));
+// Rows are padded to a whole 64-byte cache line
+template <typename T>
+static size_t padded_stride(size_t cols) {
+    const size_t row_align = 64 / sizeof(T);
+    return (cols + row_align - 1) / row_align * row_align;
 }
 
-void Matrix::randomize() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 10.0);
+template <typename T>
+BasicMatrix<T>::BasicMatrix(size_t r, size_t c)
+    : data(nullptr), rows(r), cols(c), stride(padded_stride<T>(c)) {
+    size_t bytes = rows * stride * sizeof(T);
+    data = static_cast<T*>(numa_alloc(bytes));
+    numa_fill(data, nullptr, bytes);
+}
 
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicConstMatrixView<T>& view)
+    : BasicMatrix(view.getRows(), view.getCols()) {
     for (size_t i = 0; i < rows; i++) {
-        for (size_t j = 0; j < cols; j++) {
-            data[i][j] = dis(gen);
+        std::memcpy(row(i), view.row(i), cols * sizeof(T));
+    }
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& other)
+    : data(nullptr), rows(other.rows), cols(other.cols), stride(other.stride) {
+    size_t bytes = rows * stride * sizeof(T);
+    data = static_cast<T*>(numa_alloc(bytes));
+    numa_fill(data, other.data, bytes);
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& other) noexcept
+    : data(other.data), rows(other.rows), cols(other.cols), stride(other.stride) {
+    other.data = nullptr;
+    other.rows = 0;
+    other.cols = 0;
+    other.stride = 0;
+}
+
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& other) {
+    if (this == &other) {
+        return *this;
+    }
+    if (rows == other.rows && stride == other.stride) {
+        // Same shape: reuse the buffer instead of reallocating
+        rows = other.rows;
+        cols = other.cols;
+        if (rows * stride > 0) {
+            std::memcpy(data, other.data, rows * stride * sizeof(T));
         }
+    } else {
+        BasicMatrix copy(other);
+        std::swap(data, copy.data);
+        std::swap(rows, copy.rows);
+        std::swap(cols, copy.cols);
+        std::swap(stride, copy.stride);
+    }
+    return *this;
+}
+
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& other) noexcept {
+    if (this != &other) {
+        aligned_free(data);
+        data = other.data;
+        rows = other.rows;
+        cols = other.cols;
+        stride = other.stride;
+        other.data = nullptr;
+        other.rows = 0;
+        other.cols = 0;
+        other.stride = 0;
     }
+    return *this;
 }
 
-Matrix Matrix::multiply(const Matrix& other) const {
+template <typename T>
+BasicMatrix<T>::~BasicMatrix() {
+    aligned_free(data);
+}
+
+template <typename T>
+void BasicMatrix<T>::randomize() {
+    random_uniform(view(), 0.0, 10.0, get_random_seed(), next_random_stream());
+}
+
+template <typename T>
+void BasicMatrix<T>::randomize(uint64_t seed, uint64_t stream) {
+    random_uniform(view(), 0.0, 10.0, seed, stream);
+}
+
+template <typename T>
+typename BasicMatrix<T>::product_type
+BasicMatrix<T>::multiply(const BasicMatrix& other, size_t num_threads) const {
     if (cols != other.rows) {
         throw std::runtime_error("Invalid matrix dimensions for multiplication");
     }
 
-    Matrix result(rows, other.cols);
+    product_type result(rows, other.cols);
+    gemm(1, *this, other, 0, result, num_threads);
+    return result;
+}
+
+template <typename T>
+void BasicMatrix<T>::multiply_into(const BasicMatrix& other, product_type& result,
+                                   size_t num_threads) const {
+    gemm(1, *this, other, 0, result, num_threads);
+}
 
-#if USE_X86_SIMD
-    // x86-64 optimized path using SSE2
-    for (size_t i = 0; i < rows; i++) {
-        for (size_t j = 0; j < other.cols; j++) {
-            __m128d sum_vec = _mm_setzero_pd();
-            size_t k = 0;
-
-            // Process 2 elements at a time with SSE2
-            for (; k + 1 < cols; k += 2) {
-                __m128d a_vec = _mm_loadu_pd(&data[i][k]);
-                __m128d b_vec = _mm_set_pd(other.data[k+1][j], other.data[k][j]);
-                sum_vec = _mm_add_pd(sum_vec, _mm_mul_pd(a_vec, b_vec));
-            }
-
-            // Horizontal add
-            double sum_arr[2];
-            _mm_storeu_pd(sum_arr, sum_vec);
-            double sum = sum_arr[0] + sum_arr[1];
-
-            // Handle remaining element
-            if (k < cols) {
-                sum += data[i][k] * other.data[k][j];
-            }
-
-            result.data[i][j] = sum;
-        }
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::transpose(size_t num_threads) const {
+    BasicMatrix result(cols, rows);
+    ::transpose(rows, cols, row(0), stride, result.row(0), result.stride, num_threads);
+    return result;
+}
+
+template <typename T>
+void BasicMatrix<T>::transpose_in_place(size_t num_threads) {
+    if (rows != cols) {
+        throw std::runtime_error("In-place transpose requires a square matrix");
     }
-#else
-    // Fallback scalar implementation
-    for (size_t i = 0; i < rows; i++) {
-        for (size_t j = 0; j < other.cols; j++) {
-            double sum = 0.0;
-            for (size_t k = 0; k < cols; k++) {
-                sum += data[i][k] * other.data[k][j];
-            }
-            result.data[i][j] = sum;
-        }
+    ::transpose_in_place(rows, row(0), stride, num_threads);
+}
+
+// Route each element type to its GEMM entry point
+static void run_gemm(size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda,
+                     const double* b, size_t ldb, double beta, double* c, size_t ldc,
+                     size_t num_threads) {
+    size_t crossover = strassen_get_crossover();
+    if (crossover != 0 && std::min(m, std::min(n, k)) >= crossover) {
+        dgemm_strassen(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, crossover, nullptr, num_threads);
+        return;
     }
-#endif
+    dgemm(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
+
+static void run_gemm(size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda,
+                     const float* b, size_t ldb, float beta, float* c, size_t ldc,
+                     size_t num_threads) {
+    sgemm(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
+
+static void run_gemm(size_t m, size_t n, size_t k, float alpha, const bfloat16* a, size_t lda,
+                     const bfloat16* b, size_t ldb, float beta, float* c, size_t ldc,
+                     size_t num_threads) {
+    gemm_bf16(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
 
+static void run_gemm(size_t m, size_t n, size_t k, float alpha, const float16* a, size_t lda,
+                     const float16* b, size_t ldb, float beta, float* c, size_t ldc,
+                     size_t num_threads) {
+    gemm_f16(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+}
+
+template <typename T>
+void gemm(typename MatrixProductType<T>::type alpha, const BasicConstMatrixView<T>& a,
+          const BasicConstMatrixView<T>& b, typename MatrixProductType<T>::type beta,
+          const BasicMatrixView<typename MatrixProductType<T>::type>& c, size_t num_threads) {
+    if (a.getCols() != b.getRows() || c.getRows() != a.getRows() || c.getCols() != b.getCols()) {
+        throw std::runtime_error("Invalid matrix dimensions for multiplication");
+    }
+    BasicConstMatrixView<typename MatrixProductType<T>::type> out(c);
+    if (views_overlap(out, a) || views_overlap(out, b)) {
+        throw std::runtime_error("gemm output must not alias an input");
+    }
+
+    run_gemm(a.getRows(), b.getCols(), a.getCols(),
+             alpha, a.row(0), a.getStride(),
+             b.row(0), b.getStride(),
+             beta, c.row(0), c.getStride(),
+             num_threads);
+}
+
+template <typename T>
+void gemm(typename MatrixProductType<T>::type alpha, const BasicMatrix<T>& a,
+          const BasicMatrix<T>& b, typename MatrixProductType<T>::type beta,
+          typename BasicMatrix<T>::product_type& c, size_t num_threads) {
+    gemm<T>(alpha, a.view(), b.view(), beta, c.view(), num_threads);
+}
+
+void gemm(double alpha, const ConstMatrixView& a, const ConstMatrixView& b, double beta,
+          const MatrixView& c, size_t num_threads) {
+    gemm<double>(alpha, a, b, beta, c, num_threads);
+}
+
+void gemm(float alpha, const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, float beta,
+          const MatrixViewF32& c, size_t num_threads) {
+    gemm<float>(alpha, a, b, beta, c, num_threads);
+}
+
+template <typename T>
+double BasicMatrix<T>::sum() const {
+    return view().sum();
+}
+
+template <typename T>
+typename BasicConstMatrixView<T>::product_type
+BasicConstMatrixView<T>::multiply(const BasicConstMatrixView& other, size_t num_threads) const {
+    if (cols != other.rows) {
+        throw std::runtime_error("Invalid matrix dimensions for multiplication");
+    }
+
+    product_type result(rows, other.cols);
+    gemm<T>(1, *this, other, 0, result.view(), num_threads);
     return result;
 }
 
-double Matrix::sum() const {
+template <typename T>
+void BasicConstMatrixView<T>::multiply_into(
+    const BasicConstMatrixView& other,
+    const BasicMatrixView<typename MatrixProductType<T>::type>& result,
+    size_t num_threads) const {
+    gemm<T>(1, *this, other, 0, result, num_threads);
+}
+
+template <typename T>
+double BasicConstMatrixView<T>::sum() const {
     double total = 0.0;
     for (size_t i = 0; i < rows; i++) {
+        const T* r = row(i);
         for (size_t j = 0; j < cols; j++) {
-            total += data[i][j];
+            total += static_cast<double>(r[j]);
         }
     }
     return total;
 }
 
+template <>
+double BasicConstMatrixView<double>::sum() const {
+    return matrix_sum(*this);
+}
+
+template <>
+double BasicConstMatrixView<float>::sum() const {
+    return matrix_sum(*this);
+}
+
+template <typename T>
+void BasicMatrixView<T>::accumulate(const BasicConstMatrixView<T>& other, T sign) const {
+    if (other.getRows() != rows || other.getCols() != cols) {
+        throw std::runtime_error("Invalid matrix dimensions for element-wise operation");
+    }
+    BasicConstMatrixView<T> self(*this);
+    if (views_overlap(self, other) && (other.row(0) != data || other.getStride() != stride)) {
+        accumulate(BasicMatrix<T>(other).view(), sign);
+        return;
+    }
+    // 16-bit storage types compute in fp32
+    typedef typename MatrixProductType<T>::type Acc;
+    const Acc s = static_cast<Acc>(sign);
+    for (size_t i = 0; i < rows; i++) {
+        T* out = row(i);
+        const T* in = other.row(i);
+        for (size_t j = 0; j < cols; j++) {
+            out[j] = static_cast<T>(static_cast<Acc>(out[j]) + s * static_cast<Acc>(in[j]));
+        }
+    }
+}
+
+template <typename T>
+void BasicMatrixView<T>::assign(const BasicConstMatrixView<T>& other) const {
+    if (other.getRows() != rows || other.getCols() != cols) {
+        throw std::runtime_error("Invalid matrix dimensions for view assignment");
+    }
+    BasicConstMatrixView<T> self(*this);
+    if (views_overlap(self, other)) {
+        if (other.row(0) == data && other.getStride() == stride) {
+            return;
+        }
+        // Shifted windows of one buffer: go through a copy
+        assign(BasicMatrix<T>(other).view());
+        return;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        std::memcpy(row(i), other.row(i), cols * sizeof(T));
+    }
+}
+
+template class BasicMatrix<double>;
+template class BasicMatrix<float>;
+template class BasicMatrix<bfloat16>;
+template class BasicMatrix<float16>;
+template class BasicConstMatrixView<double>;
+template class BasicConstMatrixView<float>;
+template class BasicConstMatrixView<bfloat16>;
+template class BasicConstMatrixView<float16>;
+template class BasicMatrixView<double>;
+template class BasicMatrixView<float>;
+template class BasicMatrixView<bfloat16>;
+template class BasicMatrixView<float16>;
+
+template void gemm<double>(double, const Matrix&, const Matrix&, double, Matrix&, size_t);
+template void gemm<float>(float, const MatrixF32&, const MatrixF32&, float, MatrixF32&, size_t);
+template void gemm<bfloat16>(float, const MatrixBF16&, const MatrixBF16&, float, MatrixF32&, size_t);
+template void gemm<float16>(float, const MatrixF16&, const MatrixF16&, float, MatrixF32&, size_t);
+template void gemm<double>(double, const ConstMatrixView&, const ConstMatrixView&, double,
+                           const MatrixView&, size_t);
+template void gemm<float>(float, const ConstMatrixViewF32&, const ConstMatrixViewF32&, float,
+                          const MatrixViewF32&, size_t);
+template void gemm<bfloat16>(float, const BasicConstMatrixView<bfloat16>&,
+                             const BasicConstMatrixView<bfloat16>&, float, const MatrixViewF32&, size_t);
+template void gemm<float16>(float, const BasicConstMatrixView<float16>&,
+                            const BasicConstMatrixView<float16>&, float, const MatrixViewF32&, size_t);
+
+template <typename T>
+static void run_precision_benchmark(const char* name, size_t size) {
+    BasicMatrix<T> a(size, size);
+    BasicMatrix<T> b(size, size);
+    a.randomize();
+    b.randomize();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    typename BasicMatrix<T>::product_type c = a.multiply(b);
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << name << " " << size << "x" << size << ": "
+              << 2.0 * size * size * size / seconds / 1e9 << " GFLOP/s, "
+              << "result sum " << c.sum() << std::endl;
+}
+
 void benchmark_matrix_ops() {
     std::cout << "\n=== Matrix Multiplication Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+    std::cout << "Kernel: " << gemm_kernel_name() << std::endl;
+    GemmBlocking blocking = gemm_get_blocking();
+    std::cout << "Blocking: mc " << blocking.mc << ", kc " << blocking.kc << ", nc " << blocking.nc
+              << std::endl;
+
+    const size_t sizes[] = { 200, 1000 };
+    for (size_t size : sizes) {
+        Matrix a(size, size);
+        Matrix b(size, size);
+
+        a.randomize();
+        b.randomize();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Matrix c = a.multiply(b);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout << "Matrix size: " << size << "x" << size << std::endl;
+        std::cout << "Time: " << duration.count() << " ms" << std::endl;
+        std::cout << "GFLOP/s: " << 2.0 * size * size * size / seconds / 1e9 << std::endl;
+        std::cout << "Result sum: " << c.sum() << std::endl;
+    }
+
+    // Narrower element types (bf16/fp16 accumulate in fp32)
+    run_precision_benchmark<float>("fp32", 1000);
+    run_precision_benchmark<bfloat16>("bf16", 1000);
+    run_precision_benchmark<float16>("fp16", 1000);
 
-    const size_t size = 200;
+    // Block product C11 = A11 * B11 + A12 * B21 on 1000x1000 matrices, with
+    // the blocks copied out into matrices or used in place through views
+    const size_t size = 1000, half = size / 2;
     Matrix a(size, size);
     Matrix b(size, size);
-
+    Matrix c(size, size);
     a.randomize();
     b.randomize();
 
     auto start = std::chrono::high_resolution_clock::now();
-    Matrix c = a.multiply(b);
+    Matrix a11(a.submatrix(0, 0, half, half)), a12(a.submatrix(0, half, half, half));
+    Matrix b11(b.submatrix(0, 0, half, half)), b21(b.submatrix(half, 0, half, half));
+    Matrix c11 = a11.multiply(b11);
+    gemm(1.0, a12, b21, 1.0, c11);
+    c.submatrix(0, 0, half, half) = c11;
     auto end = std::chrono::high_resolution_clock::now();
+    double copy_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    double copy_sum = c.sum();
+
+    start = std::chrono::high_resolution_clock::now();
+    MatrixView c11_view = c.submatrix(0, 0, half, half);
+    gemm(1.0, a.submatrix(0, 0, half, half), b.submatrix(0, 0, half, half), 0.0, c11_view);
+    gemm(1.0, a.submatrix(0, half, half, half), b.submatrix(half, 0, half, half), 1.0, c11_view);
+    end = std::chrono::high_resolution_clock::now();
+    double view_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::cout << "Block product " << half << "x" << half << " of " << size << "x" << size
+              << ": copied blocks " << copy_ms << " ms, views " << view_ms << " ms" << std::endl;
+    std::cout << "Result sum: " << copy_sum << ", " << c.sum() << std::endl;
+}
+
+void benchmark_batched_matrix_ops() {
+    std::cout << "\n=== Batched Matrix Multiplication Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    const size_t sizes[] = { 4, 8, 16, 64 };
+    for (size_t size : sizes) {
+        const size_t batch = (size <= 16) ? 100000 : 2000;
+        const size_t elems = size * size;
+        std::vector<double> a(batch * elems);
+        std::vector<double> b(batch * elems);
+        std::vector<double> c(batch * elems);
+        Matrix seed(1, a.size());
+        seed.randomize();
+        for (size_t i = 0; i < a.size(); i++) {
+            a[i] = seed(0, i);
+            b[i] = seed(0, a.size() - 1 - i);
+        }
 
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        // Untimed pass first so neither variant pays for cold pages
+        dgemm_batch_strided(size, size, size, 1.0, a.data(), size, elems,
+                            b.data(), size, elems, 0.0, c.data(), size, elems, batch);
 
-    std::cout << "Matrix size: " << size << "x" << size << std::endl;
-    std::cout << "Time: " << duration.count() << " ms" << std::endl;
-    std::cout << "Result sum: " << c.sum() << std::endl;
+        auto start = std::chrono::high_resolution_clock::now();
+        dgemm_batch_strided(size, size, size, 1.0, a.data(), size, elems,
+                            b.data(), size, elems, 0.0, c.data(), size, elems, batch);
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        // Baseline: one single-threaded dgemm per problem over the same data
+        auto loop_start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < batch; i++) {
+            dgemm(size, size, size, 1.0, &a[i * elems], size, &b[i * elems], size,
+                  0.0, &c[i * elems], size, 1);
+        }
+        auto loop_end = std::chrono::high_resolution_clock::now();
+        double loop_seconds = std::chrono::duration<double>(loop_end - loop_start).count();
+
+        double checksum = 0.0;
+        for (size_t i = 0; i < c.size(); i += elems) {
+            checksum += c[i];
+        }
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        std::cout << "Matrix size: " << size << "x" << size << ", batch " << batch << std::endl;
+        std::cout << "Time: " << duration.count() << " ms" << std::endl;
+        std::cout << "Batched: " << batch / seconds << " matrices/s" << std::endl;
+        std::cout << "Loop of dgemm: " << batch / loop_seconds << " matrices/s" << std::endl;
+        std::cout << "Checksum: " << checksum << std::endl;
+    }
 }
@@ -1,27 +1,340 @@
 #ifndef MATRIX_OPERATIONS_H
 #define MATRIX_OPERATIONS_H
 
-#include <vector>
+#include <algorithm>
 #include <cstddef>
+#include <stdexcept>
+#include "half_precision.h"
+
+// Element type of a product: 16-bit storage types accumulate into fp32
+template <typename T>
+struct MatrixProductType {
+    typedef T type;
+};
+
+template <>
+struct MatrixProductType<bfloat16> {
+    typedef float type;
+};
+
+template <>
+struct MatrixProductType<float16> {
+    typedef float type;
+};
+
+// Lazy expression node (matrix_expr.h)
+template <typename E>
+struct MatrixExpr;
+
+template <typename T>
+class BasicMatrix;
+template <typename T>
+class BasicMatrixView;
+
+static inline void check_view_shape(size_t rows, size_t cols, size_t stride) {
+    if (rows > 1 && stride < cols) {
+        throw std::runtime_error("Matrix view stride is smaller than its row length");
+    }
+}
+
+static inline void check_submatrix(size_t rows, size_t cols, size_t r0, size_t c0,
+                                   size_t r, size_t c) {
+    if (r0 > rows || c0 > cols || r > rows - r0 || c > cols - c0) {
+        throw std::runtime_error("Submatrix out of range");
+    }
+}
+
+// Non-owning read-only window onto row-major elements: rows x cols with
+// getStride() elements between row starts. Any buffer can be wrapped, so
+// blocks of a Matrix and foreign arrays are used in place without copying.
+// The viewed memory must outlive the view.
+template <typename T>
+class BasicConstMatrixView {
+private:
+    const T* data;
+    size_t rows;
+    size_t cols;
+    size_t stride;
+
+public:
+    typedef T value_type;
+    typedef BasicMatrix<typename MatrixProductType<T>::type> product_type;
+
+    BasicConstMatrixView() : data(nullptr), rows(0), cols(0), stride(0) {}
+    BasicConstMatrixView(const T* d, size_t r, size_t c, size_t s)
+        : data(d), rows(r), cols(c), stride(s) {
+        check_view_shape(rows, cols, stride);
+    }
+    BasicConstMatrixView(const BasicMatrixView<T>& view);
+
+    // r x c block whose top-left element is (r0, c0)
+    BasicConstMatrixView submatrix(size_t r0, size_t c0, size_t r, size_t c) const {
+        check_submatrix(rows, cols, r0, c0, r, c);
+        return BasicConstMatrixView(data + r0 * stride + c0, r, c, stride);
+    }
+
+    // num_threads caps the threads used (0 = global pool, see thread_pool.h)
+    product_type multiply(const BasicConstMatrixView& other, size_t num_threads = 0) const;
+    // Same product written into a caller-owned view of shape rows x other.cols
+    void multiply_into(const BasicConstMatrixView& other,
+                       const BasicMatrixView<typename MatrixProductType<T>::type>& result,
+                       size_t num_threads = 0) const;
+    double sum() const;
+
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t getStride() const { return stride; }
+    bool empty() const { return rows == 0 || cols == 0; }
+
+    const T* row(size_t i) const { return data + i * stride; }
+    T operator()(size_t i, size_t j) const { return data[i * stride + j]; }
+
+    // Bytes from the first element to one past the last, for overlap tests
+    const char* span_begin() const { return reinterpret_cast<const char*>(data); }
+    const char* span_end() const {
+        return empty() ? span_begin()
+                       : reinterpret_cast<const char*>(data + (rows - 1) * stride + cols);
+    }
+};
+
+// Writable view. Views are never rebound: assigning a view, matrix or
+// expression to one writes the elements it covers, and the shapes must match.
+template <typename T>
+class BasicMatrixView {
+private:
+    T* data;
+    size_t rows;
+    size_t cols;
+    size_t stride;
+
+public:
+    typedef T value_type;
+
+    BasicMatrixView() : data(nullptr), rows(0), cols(0), stride(0) {}
+    BasicMatrixView(T* d, size_t r, size_t c, size_t s) : data(d), rows(r), cols(c), stride(s) {
+        check_view_shape(rows, cols, stride);
+    }
+    BasicMatrixView(const BasicMatrixView& other) = default;
+
+    BasicMatrixView& operator=(const BasicMatrixView& other) {
+        assign(BasicConstMatrixView<T>(other));
+        return *this;
+    }
+    BasicMatrixView& operator=(const BasicConstMatrixView<T>& other) {
+        assign(other);
+        return *this;
+    }
+    BasicMatrixView& operator=(const BasicMatrix<T>& other) {
+        assign(other.view());
+        return *this;
+    }
+    // Element-wise copy; handles sources overlapping this view
+    void assign(const BasicConstMatrixView<T>& other) const;
+
+    // Evaluate a lazy expression into the viewed elements (matrix_expr.h)
+    template <typename E>
+    BasicMatrixView& operator=(const MatrixExpr<E>& expr);
+    template <typename E>
+    BasicMatrixView& operator+=(const MatrixExpr<E>& expr);
+    template <typename E>
+    BasicMatrixView& operator-=(const MatrixExpr<E>& expr);
+    BasicMatrixView& operator+=(const BasicConstMatrixView<T>& other) {
+        accumulate(other, T(1));
+        return *this;
+    }
+    BasicMatrixView& operator-=(const BasicConstMatrixView<T>& other) {
+        accumulate(other, T(-1));
+        return *this;
+    }
+    // this += sign * other, element by element
+    void accumulate(const BasicConstMatrixView<T>& other, T sign) const;
+
+    BasicMatrixView submatrix(size_t r0, size_t c0, size_t r, size_t c) const {
+        check_submatrix(rows, cols, r0, c0, r, c);
+        return BasicMatrixView(data + r0 * stride + c0, r, c, stride);
+    }
+
+    double sum() const { return BasicConstMatrixView<T>(*this).sum(); }
+
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t getStride() const { return stride; }
+    bool empty() const { return rows == 0 || cols == 0; }
+
+    T* row(size_t i) const { return data + i * stride; }
+    T& operator()(size_t i, size_t j) const { return data[i * stride + j]; }
+};
+
+template <typename T>
+inline BasicConstMatrixView<T>::BasicConstMatrixView(const BasicMatrixView<T>& view)
+    : data(view.row(0)), rows(view.getRows()), cols(view.getCols()), stride(view.getStride()) {}
+
+// double and float sums use the vectorized, threaded reductions (reductions.h)
+template <>
+double BasicConstMatrixView<double>::sum() const;
+template <>
+double BasicConstMatrixView<float>::sum() const;
+
+// True when two views share any byte; empty views overlap nothing. Exact
+// for views with the same stride, such as side-by-side blocks of one matrix;
+// otherwise any intersection of their address spans counts as overlap.
+template <typename A, typename B>
+inline bool views_overlap(const A& a, const B& b) {
+    if (a.empty() || b.empty() || !(a.span_begin() < b.span_end() && b.span_begin() < a.span_end())) {
+        return false;
+    }
+    const ptrdiff_t stride = a.getStride() * sizeof(typename A::value_type);
+    const ptrdiff_t a_width = a.getCols() * sizeof(typename A::value_type);
+    const ptrdiff_t b_width = b.getCols() * sizeof(typename B::value_type);
+    if (b.getStride() * sizeof(typename B::value_type) != static_cast<size_t>(stride) ||
+        a_width > stride || b_width > stride) {
+        return true;
+    }
+    // Row i of b starts r bytes into row q + i of a's row grid and may run on
+    // into the start of row q + i + 1
+    ptrdiff_t offset = b.span_begin() - a.span_begin();
+    ptrdiff_t q = offset / stride, r = offset % stride;
+    if (r < 0) {
+        r += stride;
+        q--;
+    }
+    const ptrdiff_t a_rows = a.getRows(), b_rows = b.getRows();
+    bool same_row = r < a_width && q < a_rows && q + b_rows > 0;
+    bool next_row = r + b_width > stride && q + 1 < a_rows && q + 1 + b_rows > 0;
+    return same_row || next_row;
+}
+
+// Calls fn(i, j, n) for the row pieces covering elements [begin, end) of a
+// view with cols columns, counted in row-major order
+template <typename F>
+inline void for_each_row_piece(size_t cols, size_t begin, size_t end, const F& fn) {
+    size_t i = begin / cols, j = begin % cols;
+    while (begin < end) {
+        size_t n = std::min(cols - j, end - begin);
+        fn(i, j, n);
+        begin += n;
+        i++;
+        j = 0;
+    }
+}
 
 // Matrix class with x86 SSE2 optimizations
-class Matrix {
+//
+// Elements live in one 64-byte aligned, row-major buffer. Each row is padded
+// to a whole number of cache lines, so row(i) is always 64-byte aligned and
+// consecutive rows are getStride() elements apart.
+//
+// Instantiated for double (Matrix), float, bfloat16 and float16.
+template <typename T>
+class BasicMatrix {
 private:
-    std::vector<std::vector<double>> data;
+    T* data;
     size_t rows;
     size_t cols;
+    size_t stride;
 
 public:
-    Matrix(size_t r, size_t c);
+    typedef T value_type;
+    typedef BasicMatrix<typename MatrixProductType<T>::type> product_type;
+
+    BasicMatrix(size_t r, size_t c);
+    // Copy of the viewed elements into a new, padded buffer
+    explicit BasicMatrix(const BasicConstMatrixView<T>& view);
+    BasicMatrix(const BasicMatrix& other);
+    BasicMatrix(BasicMatrix&& other) noexcept;
+    BasicMatrix& operator=(const BasicMatrix& other);
+    BasicMatrix& operator=(BasicMatrix&& other) noexcept;
+    ~BasicMatrix();
+
+    // Evaluate a lazy expression such as A*B + C in fused passes; defined in
+    // matrix_expr.h, which builds the expressions
+    template <typename E>
+    BasicMatrix(const MatrixExpr<E>& expr);
+    template <typename E>
+    BasicMatrix& operator=(const MatrixExpr<E>& expr);
+    template <typename E>
+    BasicMatrix& operator+=(const MatrixExpr<E>& expr);
+    template <typename E>
+    BasicMatrix& operator-=(const MatrixExpr<E>& expr);
+    BasicMatrix& operator+=(const BasicConstMatrixView<T>& other) {
+        view().accumulate(other, T(1));
+        return *this;
+    }
+    BasicMatrix& operator-=(const BasicConstMatrixView<T>& other) {
+        view().accumulate(other, T(-1));
+        return *this;
+    }
+
+    // Uniform values in [0, 10) from the process seed and a fresh stream
+    // (random_fill.h), or from an explicit seed and stream
     void randomize();
-    Matrix multiply(const Matrix& other) const;
+    void randomize(uint64_t seed, uint64_t stream = 0);
+    // num_threads caps the threads used (0 = global pool, see thread_pool.h)
+    product_type multiply(const BasicMatrix& other, size_t num_threads = 0) const;
+    // Same product written into a caller-owned result of shape rows x other.cols
+    void multiply_into(const BasicMatrix& other, product_type& result, size_t num_threads = 0) const;
+    // Cache-oblivious SIMD transposes (transpose.h); the in-place form
+    // requires a square matrix
+    BasicMatrix transpose(size_t num_threads = 0) const;
+    void transpose_in_place(size_t num_threads = 0);
     double sum() const;
 
     size_t getRows() const { return rows; }
     size_t getCols() const { return cols; }
+    size_t getStride() const { return stride; }
+
+    T* row(size_t i) { return data + i * stride; }
+    const T* row(size_t i) const { return data + i * stride; }
+
+    T& operator()(size_t i, size_t j) { return data[i * stride + j]; }
+    T operator()(size_t i, size_t j) const { return data[i * stride + j]; }
+
+    // Views of the whole matrix or of a block; a matrix converts to a view
+    // wherever one is expected
+    BasicMatrixView<T> view() { return BasicMatrixView<T>(data, rows, cols, stride); }
+    BasicConstMatrixView<T> view() const { return BasicConstMatrixView<T>(data, rows, cols, stride); }
+    BasicMatrixView<T> submatrix(size_t r0, size_t c0, size_t r, size_t c) {
+        return view().submatrix(r0, c0, r, c);
+    }
+    BasicConstMatrixView<T> submatrix(size_t r0, size_t c0, size_t r, size_t c) const {
+        return view().submatrix(r0, c0, r, c);
+    }
+    operator BasicMatrixView<T>() { return view(); }
+    operator BasicConstMatrixView<T>() const { return view(); }
 };
 
-// Benchmark function
+typedef BasicMatrix<double> Matrix;
+typedef BasicMatrix<float> MatrixF32;
+typedef BasicMatrix<bfloat16> MatrixBF16;
+typedef BasicMatrix<float16> MatrixF16;
+
+// C = alpha * A * B + beta * C without allocating. C must already have the
+// result shape and must not alias A or B; C is not read when beta == 0.
+template <typename T>
+void gemm(typename MatrixProductType<T>::type alpha, const BasicMatrix<T>& a,
+          const BasicMatrix<T>& b, typename MatrixProductType<T>::type beta,
+          typename BasicMatrix<T>::product_type& c, size_t num_threads = 0);
+
+// The same on views, so blocks and foreign buffers multiply in place. C must
+// not overlap A or B. Use view() to pass a Matrix alongside views.
+template <typename T>
+void gemm(typename MatrixProductType<T>::type alpha, const BasicConstMatrixView<T>& a,
+          const BasicConstMatrixView<T>& b, typename MatrixProductType<T>::type beta,
+          const BasicMatrixView<typename MatrixProductType<T>::type>& c, size_t num_threads = 0);
+// Non-template forms, so double and float calls can mix mutable and const
+// views without naming T; 16-bit inputs still call gemm<T>
+void gemm(double alpha, const BasicConstMatrixView<double>& a, const BasicConstMatrixView<double>& b,
+          double beta, const BasicMatrixView<double>& c, size_t num_threads = 0);
+void gemm(float alpha, const BasicConstMatrixView<float>& a, const BasicConstMatrixView<float>& b,
+          float beta, const BasicMatrixView<float>& c, size_t num_threads = 0);
+
+typedef BasicMatrixView<double> MatrixView;
+typedef BasicConstMatrixView<double> ConstMatrixView;
+typedef BasicMatrixView<float> MatrixViewF32;
+typedef BasicConstMatrixView<float> ConstMatrixViewF32;
+
+// Benchmark functions
 void benchmark_matrix_ops();
+void benchmark_batched_matrix_ops();
 
 #endif // MATRIX_OPERATIONS_H
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <cstdlib>
+#include <new>
 
 #ifdef __x86_64__
 #include <immintrin.h>
@@ -29,6 +31,21 @@ void fast_memcpy(void* dest, const void* src, size_t n) {
     }
 }
 
+void* aligned_malloc(size_t size, size_t alignment) {
+    if (size == 0) {
+        return nullptr;
+    }
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void aligned_free(void* ptr) {
+    free(ptr);
+}
+
 void benchmark_memory_ops() {
     std::cout << "\n=== Memory Operations Benchmark ===" << std::endl;
 
@@ -6,6 +6,35 @@
 // Fast memory copy using x86 SSE2
 void fast_memcpy(void* dest, const void* src, size_t n);
 
+// Cache-line (64-byte) aligned allocation, released with aligned_free
+void* aligned_malloc(size_t size, size_t alignment = 64);
+void aligned_free(void* ptr);
+
+// Grow-only, 64-byte aligned scratch buffer (packed panels, workspaces).
+// Typically thread_local so hot loops reuse it without allocating.
+struct ScratchBuffer {
+    void* ptr;
+    size_t capacity;
+
+    ScratchBuffer() : ptr(nullptr), capacity(0) {}
+    ~ScratchBuffer() { aligned_free(ptr); }
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    template <typename T>
+    T* reserve(size_t n) {
+        if (n * sizeof(T) > capacity) {
+            // Emptied first, so a throwing allocation leaves nothing to free twice
+            aligned_free(ptr);
+            ptr = nullptr;
+            capacity = 0;
+            ptr = aligned_malloc(n * sizeof(T));
+            capacity = n * sizeof(T);
+        }
+        return static_cast<T*>(ptr);
+    }
+};
+
 // Benchmark function
 void benchmark_memory_ops();
 
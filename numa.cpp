@@ -0,0 +1,432 @@
+#include "numa.h"
+#include "bench_util.h"
+#include "matrix_operations.h"
+#include "memory_operations.h"
+#include "reductions.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define USE_LINUX_NUMA 1
+#else
+#define USE_LINUX_NUMA 0
+#endif
+
+// Buffers below this skip the policy: a syscall would cost more than any
+// placement gain
+static const size_t kNumaMinBytes = 1 << 20;
+// Node ids an mbind mask can hold
+static const size_t kMaxNodes = 1024;
+static const size_t kMaskWords = kMaxNodes / (8 * sizeof(unsigned long));
+
+struct NumaTopology {
+    std::vector<int> node_ids;
+    std::vector<std::vector<int> > cpus;
+    std::vector<int> allowed;
+};
+
+// "0-3,8,10-11" -> 0 1 2 3 8 10 11
+static std::vector<int> parse_list(const std::string& text) {
+    std::vector<int> values;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string item = text.substr(pos, end - pos);
+        size_t dash = item.find('-');
+        char* tail = nullptr;
+        long lo = std::strtol(item.c_str(), &tail, 10);
+        long hi = (dash == std::string::npos) ? lo : std::strtol(item.c_str() + dash + 1, nullptr, 10);
+        if (tail != item.c_str()) {
+            for (long v = lo; v <= hi; v++) {
+                values.push_back(static_cast<int>(v));
+            }
+        }
+        pos = end + 1;
+    }
+    return values;
+}
+
+static std::string read_first_line(const std::string& path) {
+    std::ifstream in(path.c_str());
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+static const NumaTopology& topology() {
+    static NumaTopology topo;
+    static std::once_flag once;
+    std::call_once(once, [] {
+#if USE_LINUX_NUMA
+        // The main thread's mask: it is never pinned, unlike pool workers
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(getpid(), sizeof(set), &set) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; c++) {
+                if (CPU_ISSET(c, &set)) {
+                    topo.allowed.push_back(c);
+                }
+            }
+        }
+        for (int id : parse_list(read_first_line("/sys/devices/system/node/online"))) {
+            if (id < 0 || static_cast<size_t>(id) >= kMaxNodes) {
+                continue;
+            }
+            std::string path = "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist";
+            std::vector<int> usable;
+            for (int c : parse_list(read_first_line(path))) {
+                if (std::binary_search(topo.allowed.begin(), topo.allowed.end(), c)) {
+                    usable.push_back(c);
+                }
+            }
+            topo.node_ids.push_back(id);
+            topo.cpus.push_back(usable);
+        }
+#endif
+        if (topo.node_ids.empty()) {
+            topo.node_ids.push_back(0);
+            topo.cpus.push_back(topo.allowed);
+        }
+    });
+    return topo;
+}
+
+size_t numa_node_count() {
+    return topology().node_ids.size();
+}
+
+const std::vector<int>& numa_node_cpus(size_t node) {
+    const NumaTopology& topo = topology();
+    if (node >= topo.cpus.size()) {
+        throw std::runtime_error("NUMA node out of range");
+    }
+    return topo.cpus[node];
+}
+
+static std::mutex g_policy_mutex;
+static bool g_policy_loaded = false;
+static NumaPolicy g_policy = NumaPolicy::Default;
+static size_t g_bind_node = 0;
+
+// Reads NUMA_POLICY once; unknown values and out-of-range nodes mean Default
+static void load_policy_locked() {
+    if (g_policy_loaded) {
+        return;
+    }
+    g_policy_loaded = true;
+    const char* env = std::getenv("NUMA_POLICY");
+    if (env == nullptr) {
+        return;
+    }
+    std::string value(env);
+    if (value == "first-touch") {
+        g_policy = NumaPolicy::FirstTouch;
+    } else if (value == "interleave") {
+        g_policy = NumaPolicy::Interleave;
+    } else if (value.compare(0, 5, "bind:") == 0) {
+        char* end = nullptr;
+        long node = std::strtol(value.c_str() + 5, &end, 10);
+        if (end != value.c_str() + 5 && *end == '\0' && node >= 0 &&
+            static_cast<size_t>(node) < numa_node_count()) {
+            g_policy = NumaPolicy::Bind;
+            g_bind_node = static_cast<size_t>(node);
+        }
+    }
+}
+
+void set_numa_policy(NumaPolicy policy, size_t node) {
+    if (policy == NumaPolicy::Bind && node >= numa_node_count()) {
+        throw std::runtime_error("NUMA node out of range");
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_policy_mutex);
+        g_policy_loaded = true;
+        g_policy = policy;
+        g_bind_node = (policy == NumaPolicy::Bind) ? node : 0;
+    }
+    global_thread_pool().pin_workers();
+}
+
+NumaPolicy get_numa_policy() {
+    std::lock_guard<std::mutex> lock(g_policy_mutex);
+    load_policy_locked();
+    return g_policy;
+}
+
+size_t get_numa_bind_node() {
+    std::lock_guard<std::mutex> lock(g_policy_mutex);
+    load_policy_locked();
+    return g_bind_node;
+}
+
+const char* numa_policy_name(NumaPolicy policy) {
+    switch (policy) {
+    case NumaPolicy::FirstTouch: return "first-touch";
+    case NumaPolicy::Interleave: return "interleave";
+    case NumaPolicy::Bind: return "bind";
+    default: return "default";
+    }
+}
+
+static size_t page_size() {
+#if USE_LINUX_NUMA
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? static_cast<size_t>(page) : 4096;
+#else
+    return 4096;
+#endif
+}
+
+// mbind over the whole pages inside [p, p + bytes), moving any already present
+static bool mbind_pages(void* p, size_t bytes, int mode, const unsigned long* mask) {
+#if USE_LINUX_NUMA
+    const uintptr_t page = page_size();
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(p) + page - 1) / page * page;
+    uintptr_t end = (reinterpret_cast<uintptr_t>(p) + bytes) / page * page;
+    if (end <= begin) {
+        return false;
+    }
+    // MPOL_MF_MOVE from <linux/mempolicy.h>; maxnode counts one past the mask
+    const unsigned long move = 1 << 1;
+    return syscall(SYS_mbind, begin, end - begin, mode, mask, kMaxNodes + 1, move) == 0;
+#else
+    (void)p;
+    (void)bytes;
+    (void)mode;
+    (void)mask;
+    return false;
+#endif
+}
+
+bool numa_bind_memory(void* p, size_t bytes, size_t node) {
+    const NumaTopology& topo = topology();
+    if (topo.node_ids.size() < 2 || node >= topo.node_ids.size()) {
+        return false;
+    }
+    unsigned long mask[kMaskWords] = {};
+    const size_t id = topo.node_ids[node], bits = 8 * sizeof(unsigned long);
+    mask[id / bits] |= 1UL << (id % bits);
+    return mbind_pages(p, bytes, 2 /* MPOL_BIND */, mask);
+}
+
+bool numa_interleave_memory(void* p, size_t bytes) {
+    const NumaTopology& topo = topology();
+    if (topo.node_ids.size() < 2) {
+        return false;
+    }
+    unsigned long mask[kMaskWords] = {};
+    const size_t bits = 8 * sizeof(unsigned long);
+    for (int id : topo.node_ids) {
+        mask[id / bits] |= 1UL << (id % bits);
+    }
+    return mbind_pages(p, bytes, 3 /* MPOL_INTERLEAVE */, mask);
+}
+
+void* numa_alloc(size_t bytes) {
+    const NumaPolicy policy = get_numa_policy();
+    if (bytes < kNumaMinBytes || policy == NumaPolicy::Default || numa_node_count() < 2) {
+        return aligned_malloc(bytes);
+    }
+    // Whole pages, so the policy never reaches a neighbouring allocation
+    const size_t page = page_size();
+    const size_t rounded = (bytes + page - 1) / page * page;
+    void* p = aligned_malloc(rounded, page);
+    if (policy == NumaPolicy::Interleave) {
+        numa_interleave_memory(p, rounded);
+    } else if (policy == NumaPolicy::Bind) {
+        numa_bind_memory(p, rounded, get_numa_bind_node());
+    } else {
+#if USE_LINUX_NUMA
+        // Recycled heap pages keep their old node; drop them so the fill
+        // faults in fresh ones where it runs
+        madvise(p, rounded, MADV_DONTNEED);
+#endif
+    }
+    return p;
+}
+
+void numa_fill(void* dst, const void* src, size_t bytes) {
+    char* d = static_cast<char*>(dst);
+    const char* s = static_cast<const char*>(src);
+    if (bytes == 0) {
+        return;
+    }
+    if (bytes < kNumaMinBytes || get_numa_policy() != NumaPolicy::FirstTouch) {
+        if (s != nullptr) {
+            std::memcpy(d, s, bytes);
+        } else {
+            std::memset(d, 0, bytes);
+        }
+        return;
+    }
+    // One contiguous run of pages per pool thread
+    ThreadPool& pool = global_thread_pool();
+    const size_t threads = pool.size(), page = page_size();
+    const size_t pages = (bytes + page - 1) / page;
+    pool.parallel_for(threads, [&](size_t t) {
+        size_t begin = pages * t / threads * page;
+        size_t end = std::min(bytes, pages * (t + 1) / threads * page);
+        if (begin >= end) {
+            return;
+        }
+        if (s != nullptr) {
+            std::memcpy(d + begin, s + begin, end - begin);
+        } else {
+            std::memset(d + begin, 0, end - begin);
+        }
+    });
+}
+
+std::vector<int> numa_thread_cpus(size_t num_threads) {
+    std::vector<int> cpus(num_threads, -1);
+    const NumaTopology& topo = topology();
+    const NumaPolicy policy = get_numa_policy();
+    if (policy == NumaPolicy::Default || topo.node_ids.size() < 2 || num_threads < 2) {
+        return cpus;
+    }
+    if (policy == NumaPolicy::Bind) {
+        const std::vector<int>& list = topo.cpus[get_numa_bind_node()];
+        for (size_t t = 1; t < num_threads && !list.empty(); t++) {
+            cpus[t] = list[t % list.size()];
+        }
+        return cpus;
+    }
+    // Consecutive threads share a node, and every node with CPUs gets an
+    // equal share of the pool
+    std::vector<size_t> nodes;
+    for (size_t n = 0; n < topo.cpus.size(); n++) {
+        if (!topo.cpus[n].empty()) {
+            nodes.push_back(n);
+        }
+    }
+    if (nodes.empty()) {
+        return cpus;
+    }
+    std::vector<size_t> used(topo.cpus.size(), 0);
+    for (size_t t = 0; t < num_threads; t++) {
+        const size_t node = nodes[t * nodes.size() / num_threads];
+        const size_t slot = used[node]++;
+        if (t > 0) {
+            cpus[t] = topo.cpus[node][slot % topo.cpus[node].size()];
+        }
+    }
+    return cpus;
+}
+
+bool pin_thread(std::thread::native_handle_type thread, int cpu) {
+#if USE_LINUX_NUMA
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= 0) {
+        CPU_SET(cpu, &set);
+    } else {
+        for (int c : topology().allowed) {
+            CPU_SET(c, &set);
+        }
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Read bandwidth of one thread on cpu over a buffer bound to memory_node
+static double pinned_read_bandwidth(int cpu, size_t memory_node, size_t rows, size_t cols) {
+    const size_t bytes = rows * cols * sizeof(double);
+    double* buffer = static_cast<double*>(aligned_malloc(bytes, page_size()));
+    numa_bind_memory(buffer, bytes, memory_node);
+    double seconds = 0.0;
+    std::atomic<bool> go(false);
+    std::thread reader([&] {
+        while (!go.load()) {
+            std::this_thread::yield();
+        }
+        std::memset(buffer, 0, bytes);
+        ConstMatrixView view(buffer, rows, cols, cols);
+        seconds = best_seconds([&] { matrix_sum(view, SumMode::Fast, 1); });
+    });
+    pin_thread(reader.native_handle(), cpu);
+    go.store(true);
+    reader.join();
+    aligned_free(buffer);
+    return bytes / seconds / 1e9;
+}
+
+void benchmark_numa() {
+    std::cout << "\n=== NUMA Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+    const size_t nodes = numa_node_count();
+    std::cout << "NUMA nodes: " << nodes << std::endl;
+    for (size_t n = 0; n < nodes; n++) {
+        std::cout << "node " << n << ": " << numa_node_cpus(n).size() << " CPUs" << std::endl;
+    }
+
+    // 64 MB, well beyond the last-level cache
+    const size_t rows = 2048, cols = 4096;
+    const double bytes = static_cast<double>(rows) * cols * sizeof(double);
+
+    // One pinned thread reading memory bound to each node in turn
+    double local = 0.0, remote = 0.0;
+    size_t local_count = 0, remote_count = 0;
+    for (size_t cpu_node = 0; cpu_node < nodes; cpu_node++) {
+        if (numa_node_cpus(cpu_node).empty()) {
+            continue;
+        }
+        for (size_t mem_node = 0; mem_node < nodes; mem_node++) {
+            double gbs = pinned_read_bandwidth(numa_node_cpus(cpu_node)[0], mem_node, rows, cols);
+            std::cout << "CPU node " << cpu_node << ", memory node " << mem_node << ": " << gbs << " GB/s"
+                      << (cpu_node == mem_node ? " (local)" : " (remote)") << std::endl;
+            if (cpu_node == mem_node) {
+                local += gbs;
+                local_count++;
+            } else {
+                remote += gbs;
+                remote_count++;
+            }
+        }
+    }
+    if (remote_count == 0) {
+        std::cout << "Single node: all memory is local, policies only change who zeroes new matrices"
+                  << std::endl;
+    } else {
+        std::cout << "Remote reads: " << 100.0 * (remote / remote_count) / (local / local_count)
+                  << "% of local bandwidth" << std::endl;
+    }
+
+    // A new matrix under each policy, summed by the whole pool
+    const NumaPolicy saved = get_numa_policy();
+    const size_t saved_node = get_numa_bind_node();
+    const NumaPolicy policies[] = { NumaPolicy::Default, NumaPolicy::FirstTouch, NumaPolicy::Interleave,
+                                    NumaPolicy::Bind };
+    for (NumaPolicy policy : policies) {
+        set_numa_policy(policy, 0);
+        auto start = std::chrono::high_resolution_clock::now();
+        Matrix m(rows, cols);
+        auto end = std::chrono::high_resolution_clock::now();
+        double alloc_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        double seconds = best_seconds([&] { matrix_sum(m); });
+        std::cout << "policy " << numa_policy_name(policy) << (policy == NumaPolicy::Bind ? " 0" : "")
+                  << ": allocate " << alloc_ms << " ms, sum " << bytes / seconds / 1e9 << " GB/s" << std::endl;
+    }
+    set_numa_policy(saved, saved_node);
+}
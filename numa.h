@@ -0,0 +1,62 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// NUMA placement of matrix memory and pool threads, through the raw mbind
+// syscall and thread affinity rather than libnuma. Nodes are numbered
+// 0..numa_node_count()-1 in the order Linux lists them online. With a
+// single node, or off Linux, memory policies are no-ops and threads are
+// never pinned.
+
+enum class NumaPolicy {
+    // Pages land on the node of whichever thread first writes them; for a
+    // new matrix that is the constructing thread
+    Default,
+    // New matrices are zeroed by the whole pool, so their pages spread over
+    // the nodes the workers run on
+    FirstTouch,
+    // Pages are interleaved over all nodes
+    Interleave,
+    // Pages are bound to one node, and pool workers run on its CPUs
+    Bind
+};
+
+// Nodes with memory or CPUs, read once from /sys
+size_t numa_node_count();
+// CPUs of a node that this process may run on (empty for memory-only nodes)
+const std::vector<int>& numa_node_cpus(size_t node);
+
+// Policy for matrices allocated from now on; it also re-pins the global
+// pool's workers to match (spread over the nodes, or on the bound node).
+// The initial policy comes from the NUMA_POLICY environment variable
+// ("default", "first-touch", "interleave" or "bind:N"), else Default.
+// Throws std::runtime_error if node is out of range for Bind.
+void set_numa_policy(NumaPolicy policy, size_t node = 0);
+NumaPolicy get_numa_policy();
+size_t get_numa_bind_node();
+const char* numa_policy_name(NumaPolicy policy);
+
+// Matrix buffers: numa_alloc applies the current policy to a new buffer
+// (released with aligned_free), and numa_fill then writes it from src,
+// or zeros when src is null, on the pool under FirstTouch
+void* numa_alloc(size_t bytes);
+void numa_fill(void* dst, const void* src, size_t bytes);
+
+// Places whole pages of [p, p + bytes) on one node, or interleaves them
+// over all nodes, moving pages already present; false if not applied
+bool numa_bind_memory(void* p, size_t bytes, size_t node);
+bool numa_interleave_memory(void* p, size_t bytes);
+
+// CPU for each of num_threads pool threads under the current policy, or -1
+// for "any allowed CPU". Thread 0 is the calling thread and is never pinned.
+std::vector<int> numa_thread_cpus(size_t num_threads);
+// Restricts a thread to one CPU, or to every allowed CPU when cpu is -1
+bool pin_thread(std::thread::native_handle_type thread, int cpu);
+
+// Benchmark function: local and remote read bandwidth, and each policy
+void benchmark_numa();
+
+#endif // NUMA_H
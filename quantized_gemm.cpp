@@ -0,0 +1,616 @@
+#include "quantized_gemm.h"
+#include "cpu_features.h"
+#include "gemm.h"
+#include "memory_operations.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Same GotoBLAS structure and fixed tile grid as gemm.cpp, on integers.
+//
+// The depth is packed in groups so one 32-bit lane holds several k steps:
+//  - AVX-512 VNNI packs groups of 4 bytes and vpdpbusd multiplies u8 x s8
+//    and sums the four products straight into int32.
+//  - AVX2, SSE2 and the scalar kernel widen both operands to int16 in pairs
+//    and use pmaddwd. pmaddubsw would do u8 x s8 directly, but it sums pairs
+//    into a saturating int16, which is not exact for 255 * 127 * 2.
+// The zero point of A is applied afterwards from column sums of B, so the
+// kernels see the raw unsigned bytes.
+
+// C[mr x nr] = A_sliver * B_sliver (+ C if accumulate) over kq depth groups
+typedef void (*QMicroKernel)(size_t kq, const void* a, const void* b,
+                             int32_t* c, size_t ldc, bool accumulate);
+
+typedef void (*QPackA)(size_t mr, size_t group, size_t mc, size_t kc,
+                       const uint8_t* a, size_t lda, void* dst);
+typedef void (*QPackB)(size_t nr, size_t group, size_t kc, size_t nc,
+                       const int8_t* b, size_t ldb, void* dst);
+
+struct QGemmKernel {
+    size_t mr;
+    size_t nr;
+    size_t group;       // k steps per 32-bit lane
+    size_t elem_size;   // bytes per packed element
+    QPackA pack_a;
+    QPackB pack_b;
+    QMicroKernel fn;
+};
+
+// Largest micro-tile of any kernel, for the edge scratch tile
+static const size_t kQMaxTile = 8 * 32;
+
+// mc x kc block of A and kc x nc panel of B; kc is a multiple of every group
+static const size_t kQGemmMc = 128;
+static const size_t kQGemmKc = 512;
+static const size_t kQGemmNc = 512;
+
+static thread_local ScratchBuffer t_qpacked_a;
+static thread_local ScratchBuffer t_qpacked_b;
+
+// Pack an mc x kc block of A into mr-row slivers of depth groups: for each
+// group, mr runs of `group` consecutive k values. Rows and depth past the
+// edge are zero-filled.
+template <typename E>
+static void qpack_a(size_t mr, size_t group, size_t mc, size_t kc,
+                    const uint8_t* a, size_t lda, void* out) {
+    E* dst = static_cast<E*>(out);
+    for (size_t i = 0; i < mc; i += mr) {
+        size_t rows = std::min(mr, mc - i);
+        for (size_t p = 0; p < kc; p += group) {
+            size_t depth = std::min(group, kc - p);
+            for (size_t r = 0; r < mr; r++) {
+                for (size_t q = 0; q < group; q++) {
+                    dst[q] = (r < rows && q < depth) ? static_cast<E>(a[(i + r) * lda + p + q]) : E(0);
+                }
+                dst += group;
+            }
+        }
+    }
+}
+
+// Pack a kc x nc panel of B into nr-column slivers of depth groups: for each
+// group, nr runs of `group` consecutive k values (one 32-bit lane per column)
+template <typename E>
+static void qpack_b(size_t nr, size_t group, size_t kc, size_t nc,
+                    const int8_t* b, size_t ldb, void* out) {
+    E* dst = static_cast<E*>(out);
+    for (size_t j = 0; j < nc; j += nr) {
+        size_t cols = std::min(nr, nc - j);
+        for (size_t p = 0; p < kc; p += group) {
+            size_t depth = std::min(group, kc - p);
+            for (size_t q = 0; q < group; q++) {
+                if (q >= depth) {
+                    for (size_t s = 0; s < nr; s++) {
+                        dst[s * group + q] = E(0);
+                    }
+                    continue;
+                }
+                const int8_t* src = b + (p + q) * ldb + j;
+                for (size_t s = 0; s < cols; s++) {
+                    dst[s * group + q] = static_cast<E>(src[s]);
+                }
+                for (size_t s = cols; s < nr; s++) {
+                    dst[s * group + q] = E(0);
+                }
+            }
+            dst += nr * group;
+        }
+    }
+}
+
+// One 32-bit lane of packed A, broadcast by the kernels
+static inline int32_t load_lane(const void* p) {
+    int32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Reference scalar implementation, 4x4 tile on int16 pairs
+static void qgemm_kernel_scalar(size_t kq, const void* pa, const void* pb,
+                                int32_t* c, size_t ldc, bool accumulate) {
+    const int16_t* a = static_cast<const int16_t*>(pa);
+    const int16_t* b = static_cast<const int16_t*>(pb);
+    int32_t acc[4][4] = {};
+    for (size_t p = 0; p < kq; p++) {
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t j = 0; j < 4; j++) {
+                acc[i][j] += a[2 * i] * b[2 * j] + a[2 * i + 1] * b[2 * j + 1];
+            }
+        }
+        a += 8;
+        b += 8;
+    }
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i][j] : acc[i][j];
+        }
+    }
+}
+
+#if USE_X86_SIMD
+// SSE2 pmaddwd, 4x8 tile in 8 accumulators
+static void qgemm_kernel_sse2(size_t kq, const void* pa, const void* pb,
+                              int32_t* c, size_t ldc, bool accumulate) {
+    const int16_t* a = static_cast<const int16_t*>(pa);
+    const __m128i* b = static_cast<const __m128i*>(pb);
+    __m128i c00 = _mm_setzero_si128(), c01 = _mm_setzero_si128();
+    __m128i c10 = _mm_setzero_si128(), c11 = _mm_setzero_si128();
+    __m128i c20 = _mm_setzero_si128(), c21 = _mm_setzero_si128();
+    __m128i c30 = _mm_setzero_si128(), c31 = _mm_setzero_si128();
+
+    for (size_t p = 0; p < kq; p++) {
+        const __m128i b0 = _mm_load_si128(b);
+        const __m128i b1 = _mm_load_si128(b + 1);
+#define QGEMM_SSE2_ROW(r)                                                      \
+        {                                                                      \
+            const __m128i ar = _mm_set1_epi32(load_lane(a + 2 * r));           \
+            c##r##0 = _mm_add_epi32(c##r##0, _mm_madd_epi16(ar, b0));          \
+            c##r##1 = _mm_add_epi32(c##r##1, _mm_madd_epi16(ar, b1));          \
+        }
+        QGEMM_SSE2_ROW(0) QGEMM_SSE2_ROW(1) QGEMM_SSE2_ROW(2) QGEMM_SSE2_ROW(3)
+#undef QGEMM_SSE2_ROW
+        a += 8;
+        b += 2;
+    }
+
+    __m128i acc[8] = { c00, c01, c10, c11, c20, c21, c30, c31 };
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t h = 0; h < 2; h++) {
+            __m128i* dst = reinterpret_cast<__m128i*>(c + i * ldc + 4 * h);
+            __m128i v = acc[2 * i + h];
+            if (accumulate) {
+                v = _mm_add_epi32(v, _mm_loadu_si128(dst));
+            }
+            _mm_storeu_si128(dst, v);
+        }
+    }
+}
+
+// AVX2 vpmaddwd, 4x16 tile in 8 accumulators
+TARGET_AVX2
+static void qgemm_kernel_avx2(size_t kq, const void* pa, const void* pb,
+                              int32_t* c, size_t ldc, bool accumulate) {
+    const int16_t* a = static_cast<const int16_t*>(pa);
+    const __m256i* b = static_cast<const __m256i*>(pb);
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+
+    for (size_t p = 0; p < kq; p++) {
+        const __m256i b0 = _mm256_load_si256(b);
+        const __m256i b1 = _mm256_load_si256(b + 1);
+#define QGEMM_AVX2_ROW(r)                                                      \
+        {                                                                      \
+            const __m256i ar = _mm256_set1_epi32(load_lane(a + 2 * r));        \
+            c##r##0 = _mm256_add_epi32(c##r##0, _mm256_madd_epi16(ar, b0));    \
+            c##r##1 = _mm256_add_epi32(c##r##1, _mm256_madd_epi16(ar, b1));    \
+        }
+        QGEMM_AVX2_ROW(0) QGEMM_AVX2_ROW(1) QGEMM_AVX2_ROW(2) QGEMM_AVX2_ROW(3)
+#undef QGEMM_AVX2_ROW
+        a += 8;
+        b += 2;
+    }
+
+    __m256i acc[8] = { c00, c01, c10, c11, c20, c21, c30, c31 };
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t h = 0; h < 2; h++) {
+            __m256i* dst = reinterpret_cast<__m256i*>(c + i * ldc + 8 * h);
+            __m256i v = acc[2 * i + h];
+            if (accumulate) {
+                v = _mm256_add_epi32(v, _mm256_loadu_si256(dst));
+            }
+            _mm256_storeu_si256(dst, v);
+        }
+    }
+}
+
+// AVX-512 VNNI vpdpbusd, 8x32 tile in 16 accumulators
+TARGET_AVX512_VNNI
+static void qgemm_kernel_avx512vnni(size_t kq, const void* pa, const void* pb,
+                                    int32_t* c, size_t ldc, bool accumulate) {
+    const uint8_t* a = static_cast<const uint8_t*>(pa);
+    const __m512i* b = static_cast<const __m512i*>(pb);
+    __m512i c00 = _mm512_setzero_si512(), c01 = _mm512_setzero_si512();
+    __m512i c10 = _mm512_setzero_si512(), c11 = _mm512_setzero_si512();
+    __m512i c20 = _mm512_setzero_si512(), c21 = _mm512_setzero_si512();
+    __m512i c30 = _mm512_setzero_si512(), c31 = _mm512_setzero_si512();
+    __m512i c40 = _mm512_setzero_si512(), c41 = _mm512_setzero_si512();
+    __m512i c50 = _mm512_setzero_si512(), c51 = _mm512_setzero_si512();
+    __m512i c60 = _mm512_setzero_si512(), c61 = _mm512_setzero_si512();
+    __m512i c70 = _mm512_setzero_si512(), c71 = _mm512_setzero_si512();
+
+    for (size_t p = 0; p < kq; p++) {
+        const __m512i b0 = _mm512_load_si512(b);
+        const __m512i b1 = _mm512_load_si512(b + 1);
+#define QGEMM_VNNI_ROW(r)                                                      \
+        {                                                                      \
+            const __m512i ar = _mm512_set1_epi32(load_lane(a + 4 * r));        \
+            c##r##0 = _mm512_dpbusd_epi32(c##r##0, ar, b0);                    \
+            c##r##1 = _mm512_dpbusd_epi32(c##r##1, ar, b1);                    \
+        }
+        QGEMM_VNNI_ROW(0) QGEMM_VNNI_ROW(1) QGEMM_VNNI_ROW(2) QGEMM_VNNI_ROW(3)
+        QGEMM_VNNI_ROW(4) QGEMM_VNNI_ROW(5) QGEMM_VNNI_ROW(6) QGEMM_VNNI_ROW(7)
+#undef QGEMM_VNNI_ROW
+        a += 32;
+        b += 2;
+    }
+
+    __m512i acc[16] = { c00, c01, c10, c11, c20, c21, c30, c31,
+                        c40, c41, c50, c51, c60, c61, c70, c71 };
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t h = 0; h < 2; h++) {
+            int32_t* dst = c + i * ldc + 16 * h;
+            __m512i v = acc[2 * i + h];
+            if (accumulate) {
+                v = _mm512_add_epi32(v, _mm512_loadu_si512(dst));
+            }
+            _mm512_storeu_si512(dst, v);
+        }
+    }
+}
+#endif
+
+static const char* const kQKernelLevels[] = {
+#if USE_X86_SIMD
+    "avx512vnni", "avx2", "sse2",
+#endif
+    "scalar",
+};
+static const size_t kNumQKernelLevels = sizeof(kQKernelLevels) / sizeof(kQKernelLevels[0]);
+
+static const QGemmKernel kQKernels[kNumQKernelLevels] = {
+#if USE_X86_SIMD
+    { 8, 32, 4, 1, qpack_a<uint8_t>, qpack_b<int8_t>, qgemm_kernel_avx512vnni },
+    { 4, 16, 2, 2, qpack_a<int16_t>, qpack_b<int16_t>, qgemm_kernel_avx2 },
+    { 4, 8, 2, 2, qpack_a<int16_t>, qpack_b<int16_t>, qgemm_kernel_sse2 },
+#endif
+    { 4, 4, 2, 2, qpack_a<int16_t>, qpack_b<int16_t>, qgemm_kernel_scalar },
+};
+
+static bool qlevel_supported(size_t level) {
+    const CpuFeatures& cpu = cpu_features();
+    const char* name = kQKernelLevels[level];
+    if (std::strcmp(name, "avx512vnni") == 0) {
+        return cpu.avx512f && cpu.avx512bw && cpu.avx512vnni;
+    }
+    if (std::strcmp(name, "avx2") == 0) {
+        return cpu.avx2;
+    }
+    if (std::strcmp(name, "sse2") == 0) {
+        return cpu.sse2;
+    }
+    return true;
+}
+
+static int find_qlevel(const char* name) {
+    for (size_t i = 0; i < kNumQKernelLevels; i++) {
+        if (std::strcmp(kQKernelLevels[i], name) == 0 && qlevel_supported(i)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Picked once: the QGEMM_KERNEL override if set and usable, else the best supported
+static int select_startup_qlevel() {
+    const char* forced = std::getenv("QGEMM_KERNEL");
+    if (forced != nullptr && *forced != '\0') {
+        int level = find_qlevel(forced);
+        if (level >= 0) {
+            return level;
+        }
+        std::cerr << "QGEMM_KERNEL=" << forced
+                  << " is unknown or unsupported on this CPU, ignoring" << std::endl;
+    }
+    for (size_t i = 0; i < kNumQKernelLevels; i++) {
+        if (qlevel_supported(i)) {
+            return static_cast<int>(i);
+        }
+    }
+    return static_cast<int>(kNumQKernelLevels - 1);
+}
+
+static std::atomic<int> g_qkernel_level(-1);
+
+static size_t active_qlevel() {
+    int level = g_qkernel_level.load();
+    if (level < 0) {
+        static const int startup = select_startup_qlevel();
+        int expected = -1;
+        g_qkernel_level.compare_exchange_strong(expected, startup);
+        level = g_qkernel_level.load();
+    }
+    return static_cast<size_t>(level);
+}
+
+const char* qgemm_kernel_name() {
+    return kQKernelLevels[active_qlevel()];
+}
+
+bool qgemm_set_kernel(const char* name) {
+    int level = find_qlevel(name);
+    if (level < 0) {
+        return false;
+    }
+    g_qkernel_level.store(level);
+    return true;
+}
+
+// Multiply a packed mc x kc block of A by a packed kc x nc panel of B into C.
+// kc_padded is kc rounded up to the kernel's depth group.
+static void qmacro_kernel(const QGemmKernel& kernel, size_t mc, size_t nc, size_t kc_padded,
+                          const uint8_t* packed_a, const uint8_t* packed_b,
+                          bool accumulate, int32_t* c, size_t ldc) {
+    const size_t mr = kernel.mr;
+    const size_t nr = kernel.nr;
+    const size_t kq = kc_padded / kernel.group;
+    int32_t edge[kQMaxTile];
+
+    for (size_t j = 0; j < nc; j += nr) {
+        size_t cols = std::min(nr, nc - j);
+        const uint8_t* b = packed_b + j * kc_padded * kernel.elem_size;
+
+        for (size_t i = 0; i < mc; i += mr) {
+            size_t rows = std::min(mr, mc - i);
+            const uint8_t* a = packed_a + i * kc_padded * kernel.elem_size;
+            int32_t* ct = c + i * ldc + j;
+
+            if (rows == mr && cols == nr) {
+                kernel.fn(kq, a, b, ct, ldc, accumulate);
+                continue;
+            }
+
+            // Partial tile: compute the full tile aside, then merge the valid part
+            kernel.fn(kq, a, b, edge, nr, false);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t s = 0; s < cols; s++) {
+                    int32_t v = edge[r * nr + s];
+                    ct[r * ldc + s] = accumulate ? ct[r * ldc + s] + v : v;
+                }
+            }
+        }
+    }
+}
+
+// Compute one mc x nc tile of C over the full depth k
+static void qgemm_tile(const QGemmKernel& kernel, size_t mc, size_t nc, size_t k,
+                       const uint8_t* a, size_t lda, const int8_t* b, size_t ldb,
+                       int32_t* c, size_t ldc) {
+    const size_t mr = kernel.mr;
+    const size_t nr = kernel.nr;
+    size_t kc_max = std::min(kQGemmKc, (k + kernel.group - 1) / kernel.group * kernel.group);
+    uint8_t* packed_a = t_qpacked_a.reserve<uint8_t>(
+        ((mc + mr - 1) / mr * mr) * kc_max * kernel.elem_size);
+    uint8_t* packed_b = t_qpacked_b.reserve<uint8_t>(
+        kc_max * ((nc + nr - 1) / nr * nr) * kernel.elem_size);
+
+    for (size_t pc = 0; pc < k; pc += kQGemmKc) {
+        size_t kc = std::min(kQGemmKc, k - pc);
+        size_t kc_padded = (kc + kernel.group - 1) / kernel.group * kernel.group;
+        kernel.pack_b(nr, kernel.group, kc, nc, b + pc * ldb, ldb, packed_b);
+        kernel.pack_a(mr, kernel.group, mc, kc, a + pc, lda, packed_a);
+        qmacro_kernel(kernel, mc, nc, kc_padded, packed_a, packed_b, pc != 0, c, ldc);
+    }
+}
+
+// Below this many multiply-adds a parallel launch costs more than it saves
+static const double kQParallelMinOps = 64.0 * 64.0 * 64.0;
+
+void gemm_u8s8s32(size_t m, size_t n, size_t k,
+                  const uint8_t* a, size_t lda, uint8_t a_zero_point,
+                  const int8_t* b, size_t ldb,
+                  int32_t* c, size_t ldc,
+                  size_t num_threads) {
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0) {
+        for (size_t i = 0; i < m; i++) {
+            std::fill(c + i * ldc, c + i * ldc + n, 0);
+        }
+        return;
+    }
+
+    // (A - z) * B = A * B - z * colsum(B)
+    std::vector<int32_t> offset;
+    if (a_zero_point != 0) {
+        offset.assign(n, 0);
+        for (size_t p = 0; p < k; p++) {
+            const int8_t* row = b + p * ldb;
+            for (size_t j = 0; j < n; j++) {
+                offset[j] += row[j];
+            }
+        }
+        for (size_t j = 0; j < n; j++) {
+            offset[j] *= a_zero_point;
+        }
+    }
+
+    const QGemmKernel& kernel = kQKernels[active_qlevel()];
+    const size_t mc_block = std::max(kernel.mr, kQGemmMc / kernel.mr * kernel.mr);
+    const size_t nc_block = std::max(kernel.nr, kQGemmNc / kernel.nr * kernel.nr);
+    const size_t row_tiles = (m + mc_block - 1) / mc_block;
+    const size_t col_tiles = (n + nc_block - 1) / nc_block;
+    const size_t tiles = row_tiles * col_tiles;
+
+    auto run_tile = [&](size_t t) {
+        size_t ic = (t / col_tiles) * mc_block;
+        size_t jc = (t % col_tiles) * nc_block;
+        size_t mc = std::min(mc_block, m - ic);
+        size_t nc = std::min(nc_block, n - jc);
+        int32_t* ct = c + ic * ldc + jc;
+        qgemm_tile(kernel, mc, nc, k, a + ic * lda, lda, b + jc, ldb, ct, ldc);
+        if (!offset.empty()) {
+            for (size_t i = 0; i < mc; i++) {
+                for (size_t j = 0; j < nc; j++) {
+                    ct[i * ldc + j] -= offset[jc + j];
+                }
+            }
+        }
+    };
+
+    size_t threads = 1;
+    if (tiles > 1 && 1.0 * m * n * k >= kQParallelMinOps) {
+        threads = std::min(resolve_threads(num_threads), tiles);
+    }
+
+    if (threads <= 1) {
+        for (size_t t = 0; t < tiles; t++) {
+            run_tile(t);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_tile(0);
+    global_thread_pool().parallel_for(threads, [&](size_t) {
+        for (size_t t = next_tile.fetch_add(1); t < tiles; t = next_tile.fetch_add(1)) {
+            run_tile(t);
+        }
+    });
+}
+
+void dequantize_s32(size_t m, size_t n, const int32_t* c, size_t ldc,
+                    const float* row_scale, const float* col_scale,
+                    float* out, size_t ldo) {
+    for (size_t i = 0; i < m; i++) {
+        const int32_t* src = c + i * ldc;
+        float* dst = out + i * ldo;
+        const float rs = row_scale ? row_scale[i] : 1.0f;
+        size_t j = 0;
+#if USE_X86_SIMD
+        const __m128 rs_vec = _mm_set1_ps(rs);
+        for (; j + 4 <= n; j += 4) {
+            __m128 v = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j)));
+            v = _mm_mul_ps(v, rs_vec);
+            if (col_scale) {
+                v = _mm_mul_ps(v, _mm_loadu_ps(col_scale + j));
+            }
+            _mm_storeu_ps(dst + j, v);
+        }
+#endif
+        for (; j < n; j++) {
+            float v = static_cast<float>(src[j]) * rs;
+            dst[j] = col_scale ? v * col_scale[j] : v;
+        }
+    }
+}
+
+void requantize_s32_u8(size_t m, size_t n, const int32_t* c, size_t ldc,
+                       const float* row_scale, const float* col_scale,
+                       uint8_t zero_point, uint8_t* out, size_t ldo) {
+    // Scaled values are clamped to +-65535 before rounding, far outside the
+    // output range but inside int32 (and int16 after packing saturates)
+    const float limit = 65535.0f;
+    for (size_t i = 0; i < m; i++) {
+        const int32_t* src = c + i * ldc;
+        uint8_t* dst = out + i * ldo;
+        const float rs = row_scale ? row_scale[i] : 1.0f;
+        size_t j = 0;
+#if USE_X86_SIMD
+        const __m128 rs_vec = _mm_set1_ps(rs);
+        const __m128 hi = _mm_set1_ps(limit);
+        const __m128 lo = _mm_set1_ps(-limit);
+        const __m128i zp = _mm_set1_epi16(zero_point);
+        for (; j + 8 <= n; j += 8) {
+            __m128 v0 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j)));
+            __m128 v1 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j + 4)));
+            v0 = _mm_mul_ps(v0, rs_vec);
+            v1 = _mm_mul_ps(v1, rs_vec);
+            if (col_scale) {
+                v0 = _mm_mul_ps(v0, _mm_loadu_ps(col_scale + j));
+                v1 = _mm_mul_ps(v1, _mm_loadu_ps(col_scale + j + 4));
+            }
+            v0 = _mm_max_ps(_mm_min_ps(v0, hi), lo);
+            v1 = _mm_max_ps(_mm_min_ps(v1, hi), lo);
+            // cvtps rounds half to even under the default MXCSR mode
+            __m128i q = _mm_packs_epi32(_mm_cvtps_epi32(v0), _mm_cvtps_epi32(v1));
+            q = _mm_adds_epi16(q, zp);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + j), _mm_packus_epi16(q, q));
+        }
+#endif
+        for (; j < n; j++) {
+            float v = static_cast<float>(src[j]) * rs;
+            if (col_scale) {
+                v *= col_scale[j];
+            }
+            v = std::max(std::min(v, limit), -limit);
+            long q = std::lrint(v) + zero_point;
+            dst[j] = static_cast<uint8_t>(std::max(0L, std::min(255L, q)));
+        }
+    }
+}
+
+void benchmark_quantized_matrix_ops() {
+    std::cout << "\n=== Quantized Matrix Multiplication Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+    std::cout << "Kernel: " << qgemm_kernel_name() << std::endl;
+
+    const size_t size = 1000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dis_a(0, 255);
+    std::uniform_int_distribution<int> dis_b(-128, 127);
+    std::vector<uint8_t> a(size * size);
+    std::vector<int8_t> b(size * size);
+    std::vector<float> af(size * size);
+    std::vector<float> bf(size * size);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = static_cast<uint8_t>(dis_a(gen));
+        b[i] = static_cast<int8_t>(dis_b(gen));
+        af[i] = a[i];
+        bf[i] = b[i];
+    }
+    std::vector<int32_t> c(size * size);
+    std::vector<float> cf(size * size);
+    std::vector<float> row_scale(size, 1.0f / 128);
+    std::vector<float> col_scale(size, 1.0f / 1024);
+    std::vector<uint8_t> q(size * size);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    gemm_u8s8s32(size, size, size, a.data(), size, 128, b.data(), size, c.data(), size);
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    auto rq_start = std::chrono::high_resolution_clock::now();
+    requantize_s32_u8(size, size, c.data(), size, row_scale.data(), col_scale.data(),
+                      128, q.data(), size);
+    auto rq_end = std::chrono::high_resolution_clock::now();
+    double rq_seconds = std::chrono::duration<double>(rq_end - rq_start).count();
+
+    // The same product in fp32 for comparison
+    auto f_start = std::chrono::high_resolution_clock::now();
+    sgemm(size, size, size, 1.0f, af.data(), size, bf.data(), size, 0.0f, cf.data(), size);
+    auto f_end = std::chrono::high_resolution_clock::now();
+    double f_seconds = std::chrono::duration<double>(f_end - f_start).count();
+
+    long long checksum = 0;
+    for (size_t i = 0; i < c.size(); i++) {
+        checksum += c[i];
+    }
+    long long q_checksum = 0;
+    for (size_t i = 0; i < q.size(); i++) {
+        q_checksum += q[i];
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << "Matrix size: " << size << "x" << size << " (u8 x s8 -> s32)" << std::endl;
+    std::cout << "Time: " << duration.count() << " ms" << std::endl;
+    std::cout << "int8 GOP/s: " << 2.0 * size * size * size / seconds / 1e9 << std::endl;
+    std::cout << "fp32 GFLOP/s: " << 2.0 * size * size * size / f_seconds / 1e9 << std::endl;
+    std::cout << "Requantize: " << size * size / rq_seconds / 1e6 << " Melem/s" << std::endl;
+    std::cout << "Result sum: " << checksum << ", requantized sum: " << q_checksum << std::endl;
+}
@@ -0,0 +1,43 @@
+#ifndef QUANTIZED_GEMM_H
+#define QUANTIZED_GEMM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Integer GEMM for quantized operands.
+//
+// C = (A - a_zero_point) * B for row-major uint8 A (m x k), int8 B (k x n)
+// and int32 C (m x n), with leading dimensions lda, ldb, ldc. Every product
+// is accumulated exactly in int32 (there is no 16-bit intermediate that
+// could saturate), which holds for any k up to 65536. num_threads caps the
+// worker count (0 = the whole global thread pool).
+void gemm_u8s8s32(size_t m, size_t n, size_t k,
+                  const uint8_t* a, size_t lda, uint8_t a_zero_point,
+                  const int8_t* b, size_t ldb,
+                  int32_t* c, size_t ldc,
+                  size_t num_threads = 0);
+
+// Micro-kernel selection, as for gemm_kernel_name(): "avx512vnni", "avx2",
+// "sse2" or "scalar", overridable with the QGEMM_KERNEL environment variable
+const char* qgemm_kernel_name();
+bool qgemm_set_kernel(const char* name);
+
+// Requantization of an int32 accumulator tile. row_scale has one factor per
+// row of A (per-tensor or per-token activation scale), col_scale one per
+// column of B (per-channel weight scale); either may be null for 1.0.
+
+// out[i][j] = c[i][j] * row_scale[i] * col_scale[j]
+void dequantize_s32(size_t m, size_t n, const int32_t* c, size_t ldc,
+                    const float* row_scale, const float* col_scale,
+                    float* out, size_t ldo);
+
+// out[i][j] = clamp(round(c[i][j] * row_scale[i] * col_scale[j]) + zero_point, 0, 255),
+// rounding half to even, so the result can feed the next gemm_u8s8s32 as A
+void requantize_s32_u8(size_t m, size_t n, const int32_t* c, size_t ldc,
+                       const float* row_scale, const float* col_scale,
+                       uint8_t zero_point, uint8_t* out, size_t ldo);
+
+// Benchmark function: int8 GEMM throughput against fp32 sgemm
+void benchmark_quantized_matrix_ops();
+
+#endif // QUANTIZED_GEMM_H
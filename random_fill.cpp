@@ -0,0 +1,473 @@
+#include "random_fill.h"
+#include "bench_util.h"
+#include "cpu_features.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Philox4x32 round multipliers and Weyl key increments
+static const uint32_t kPhiloxM0 = 0xD2511F53u;
+static const uint32_t kPhiloxM1 = 0xCD9E8D57u;
+static const uint32_t kPhiloxW0 = 0x9E3779B9u;
+static const uint32_t kPhiloxW1 = 0xBB67AE85u;
+static const int kPhiloxRounds = 10;
+
+// Eight consecutive Philox blocks form a group of 32 words: word w of block
+// group * 8 + lane is word w * 8 + lane of the group. A group fills 32
+// floats, or 16 doubles from word pairs (2w, 2w + 1).
+static const size_t kGroupBlocks = 8;
+// Elements per block of work and below which the fill stays on the calling
+// thread
+static const size_t kRandomBlock = 1 << 16;
+static const size_t kRandomParallelMin = 1 << 16;
+
+// Parameters shared by every group of one fill
+struct RandomParams {
+    uint64_t seed;
+    uint64_t stream;
+    double lo;
+    double scale;
+};
+
+template <typename T>
+struct RandomGroups {
+    // One group: 32 words of random bits
+    static const size_t elements = 128 / sizeof(T);
+    typedef void (*Fn)(uint64_t group, size_t groups, const RandomParams& p, T* out);
+};
+
+#if !USE_X86_SIMD
+static void philox_block(uint64_t block, uint64_t stream, uint64_t seed, uint32_t x[4]) {
+    x[0] = static_cast<uint32_t>(block);
+    x[1] = static_cast<uint32_t>(block >> 32);
+    x[2] = static_cast<uint32_t>(stream);
+    x[3] = static_cast<uint32_t>(stream >> 32);
+    uint32_t k0 = static_cast<uint32_t>(seed), k1 = static_cast<uint32_t>(seed >> 32);
+    for (int r = 0; r < kPhiloxRounds; r++) {
+        if (r > 0) {
+            k0 += kPhiloxW0;
+            k1 += kPhiloxW1;
+        }
+        uint64_t p0 = static_cast<uint64_t>(kPhiloxM0) * x[0];
+        uint64_t p1 = static_cast<uint64_t>(kPhiloxM1) * x[2];
+        uint32_t y0 = static_cast<uint32_t>(p1 >> 32) ^ x[1] ^ k0;
+        uint32_t y2 = static_cast<uint32_t>(p0 >> 32) ^ x[3] ^ k1;
+        x[0] = y0;
+        x[1] = static_cast<uint32_t>(p1);
+        x[2] = y2;
+        x[3] = static_cast<uint32_t>(p0);
+    }
+}
+
+// Uniform [0, 1) from the top mantissa bits: [1, 2) by exponent, minus one
+static inline double unit_double(uint64_t u) {
+    uint64_t bits = (u >> 12) | 0x3FF0000000000000ull;
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d - 1.0;
+}
+
+static inline float unit_float(uint32_t u) {
+    uint32_t bits = (u >> 9) | 0x3F800000u;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f - 1.0f;
+}
+
+static void group_words(uint64_t group, const RandomParams& p, uint32_t words[32]) {
+    for (size_t lane = 0; lane < kGroupBlocks; lane++) {
+        uint32_t x[4];
+        philox_block(group * kGroupBlocks + lane, p.stream, p.seed, x);
+        for (size_t w = 0; w < 4; w++) {
+            words[w * kGroupBlocks + lane] = x[w];
+        }
+    }
+}
+
+static void groups_f64_scalar(uint64_t group, size_t groups, const RandomParams& p, double* out) {
+    for (size_t g = 0; g < groups; g++, out += 16) {
+        uint32_t words[32];
+        group_words(group + g, p, words);
+        for (size_t d = 0; d < 16; d++) {
+            size_t w = (d / 8) * 2, lane = d % 8;
+            uint64_t u = (static_cast<uint64_t>(words[(w + 1) * 8 + lane]) << 32) | words[w * 8 + lane];
+            out[d] = p.lo + unit_double(u) * p.scale;
+        }
+    }
+}
+
+static void groups_f32_scalar(uint64_t group, size_t groups, const RandomParams& p, float* out) {
+    const float lo = static_cast<float>(p.lo), scale = static_cast<float>(p.scale);
+    for (size_t g = 0; g < groups; g++, out += 32) {
+        uint32_t words[32];
+        group_words(group + g, p, words);
+        for (size_t i = 0; i < 32; i++) {
+            out[i] = lo + unit_float(words[i]) * scale;
+        }
+    }
+}
+#endif
+
+#if USE_X86_SIMD
+// 32 x 32 -> 64-bit products of every lane, split into high and low words
+static inline void philox_mul_sse2(__m128i x, __m128i m, __m128i& hi, __m128i& lo) {
+    const __m128i low_mask = _mm_set1_epi64x(0xFFFFFFFFll);
+    __m128i even = _mm_mul_epu32(x, m);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), m);
+    hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low_mask, odd));
+    lo = _mm_or_si128(_mm_and_si128(even, low_mask), _mm_slli_epi64(odd, 32));
+}
+
+// Blocks first_block .. first_block + 3, one per lane
+static inline void philox_sse2(uint64_t first_block, const RandomParams& p, __m128i& x0, __m128i& x1,
+                               __m128i& x2, __m128i& x3) {
+    const __m128i m0 = _mm_set1_epi32(static_cast<int>(kPhiloxM0));
+    const __m128i m1 = _mm_set1_epi32(static_cast<int>(kPhiloxM1));
+    x0 = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(first_block)), _mm_setr_epi32(0, 1, 2, 3));
+    x1 = _mm_set1_epi32(static_cast<int>(first_block >> 32));
+    x2 = _mm_set1_epi32(static_cast<int>(p.stream));
+    x3 = _mm_set1_epi32(static_cast<int>(p.stream >> 32));
+    __m128i k0 = _mm_set1_epi32(static_cast<int>(p.seed));
+    __m128i k1 = _mm_set1_epi32(static_cast<int>(p.seed >> 32));
+    for (int r = 0; r < kPhiloxRounds; r++) {
+        if (r > 0) {
+            k0 = _mm_add_epi32(k0, _mm_set1_epi32(static_cast<int>(kPhiloxW0)));
+            k1 = _mm_add_epi32(k1, _mm_set1_epi32(static_cast<int>(kPhiloxW1)));
+        }
+        __m128i hi0, lo0, hi1, lo1;
+        philox_mul_sse2(x0, m0, hi0, lo0);
+        philox_mul_sse2(x2, m1, hi1, lo1);
+        x0 = _mm_xor_si128(_mm_xor_si128(hi1, x1), k0);
+        x1 = lo1;
+        x2 = _mm_xor_si128(_mm_xor_si128(hi0, x3), k1);
+        x3 = lo0;
+    }
+}
+
+static inline __m128d scale_pd2(__m128i u, __m128d lo, __m128d scale) {
+    __m128d d = _mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(u, 12), _mm_set1_epi64x(0x3FF0000000000000ll)));
+    return _mm_add_pd(lo, _mm_mul_pd(_mm_sub_pd(d, _mm_set1_pd(1.0)), scale));
+}
+
+static inline __m128 scale_ps4(__m128i u, __m128 lo, __m128 scale) {
+    __m128 f = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(u, 9), _mm_set1_epi32(0x3F800000)));
+    return _mm_add_ps(lo, _mm_mul_ps(_mm_sub_ps(f, _mm_set1_ps(1.0f)), scale));
+}
+
+// A group is two halves of four blocks; half h covers lanes 4h .. 4h + 3
+static void groups_f64_sse2(uint64_t group, size_t groups, const RandomParams& p, double* out) {
+    const __m128d lo = _mm_set1_pd(p.lo), scale = _mm_set1_pd(p.scale);
+    for (size_t g = 0; g < groups; g++, out += 16) {
+        for (size_t h = 0; h < 2; h++) {
+            __m128i x0, x1, x2, x3;
+            philox_sse2((group + g) * kGroupBlocks + 4 * h, p, x0, x1, x2, x3);
+            double* o = out + 4 * h;
+            _mm_storeu_pd(o, scale_pd2(_mm_unpacklo_epi32(x0, x1), lo, scale));
+            _mm_storeu_pd(o + 2, scale_pd2(_mm_unpackhi_epi32(x0, x1), lo, scale));
+            _mm_storeu_pd(o + 8, scale_pd2(_mm_unpacklo_epi32(x2, x3), lo, scale));
+            _mm_storeu_pd(o + 10, scale_pd2(_mm_unpackhi_epi32(x2, x3), lo, scale));
+        }
+    }
+}
+
+static void groups_f32_sse2(uint64_t group, size_t groups, const RandomParams& p, float* out) {
+    const __m128 lo = _mm_set1_ps(static_cast<float>(p.lo));
+    const __m128 scale = _mm_set1_ps(static_cast<float>(p.scale));
+    for (size_t g = 0; g < groups; g++, out += 32) {
+        for (size_t h = 0; h < 2; h++) {
+            __m128i x0, x1, x2, x3;
+            philox_sse2((group + g) * kGroupBlocks + 4 * h, p, x0, x1, x2, x3);
+            float* o = out + 4 * h;
+            _mm_storeu_ps(o, scale_ps4(x0, lo, scale));
+            _mm_storeu_ps(o + 8, scale_ps4(x1, lo, scale));
+            _mm_storeu_ps(o + 16, scale_ps4(x2, lo, scale));
+            _mm_storeu_ps(o + 24, scale_ps4(x3, lo, scale));
+        }
+    }
+}
+
+TARGET_AVX2 static inline void philox_mul_avx2(__m256i x, __m256i m, __m256i& hi, __m256i& lo) {
+    const __m256i low_mask = _mm256_set1_epi64x(0xFFFFFFFFll);
+    __m256i even = _mm256_mul_epu32(x, m);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+    hi = _mm256_or_si256(_mm256_srli_epi64(even, 32), _mm256_andnot_si256(low_mask, odd));
+    lo = _mm256_or_si256(_mm256_and_si256(even, low_mask), _mm256_slli_epi64(odd, 32));
+}
+
+// All eight blocks of a group, one per lane
+TARGET_AVX2 static inline void philox_avx2(uint64_t group, const RandomParams& p, __m256i& x0, __m256i& x1,
+                                           __m256i& x2, __m256i& x3) {
+    const __m256i m0 = _mm256_set1_epi32(static_cast<int>(kPhiloxM0));
+    const __m256i m1 = _mm256_set1_epi32(static_cast<int>(kPhiloxM1));
+    const uint64_t first_block = group * kGroupBlocks;
+    x0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(first_block)),
+                          _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    x1 = _mm256_set1_epi32(static_cast<int>(first_block >> 32));
+    x2 = _mm256_set1_epi32(static_cast<int>(p.stream));
+    x3 = _mm256_set1_epi32(static_cast<int>(p.stream >> 32));
+    __m256i k0 = _mm256_set1_epi32(static_cast<int>(p.seed));
+    __m256i k1 = _mm256_set1_epi32(static_cast<int>(p.seed >> 32));
+    for (int r = 0; r < kPhiloxRounds; r++) {
+        if (r > 0) {
+            k0 = _mm256_add_epi32(k0, _mm256_set1_epi32(static_cast<int>(kPhiloxW0)));
+            k1 = _mm256_add_epi32(k1, _mm256_set1_epi32(static_cast<int>(kPhiloxW1)));
+        }
+        __m256i hi0, lo0, hi1, lo1;
+        philox_mul_avx2(x0, m0, hi0, lo0);
+        philox_mul_avx2(x2, m1, hi1, lo1);
+        x0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), k0);
+        x1 = lo1;
+        x2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), k1);
+        x3 = lo0;
+    }
+}
+
+TARGET_AVX2 static inline __m256d scale_pd4(__m256i u, __m256d lo, __m256d scale) {
+    __m256d d = _mm256_castsi256_pd(
+        _mm256_or_si256(_mm256_srli_epi64(u, 12), _mm256_set1_epi64x(0x3FF0000000000000ll)));
+    return _mm256_add_pd(lo, _mm256_mul_pd(_mm256_sub_pd(d, _mm256_set1_pd(1.0)), scale));
+}
+
+TARGET_AVX2 static inline __m256 scale_ps8(__m256i u, __m256 lo, __m256 scale) {
+    __m256 f = _mm256_castsi256_ps(_mm256_or_si256(_mm256_srli_epi32(u, 9), _mm256_set1_epi32(0x3F800000)));
+    return _mm256_add_ps(lo, _mm256_mul_ps(_mm256_sub_ps(f, _mm256_set1_ps(1.0f)), scale));
+}
+
+// unpack works within 128-bit halves, so the 64-bit words come out as lanes
+// 0,1,4,5 and 2,3,6,7 and are put back in order across halves
+TARGET_AVX2 static void groups_f64_avx2(uint64_t group, size_t groups, const RandomParams& p, double* out) {
+    const __m256d lo = _mm256_set1_pd(p.lo), scale = _mm256_set1_pd(p.scale);
+    for (size_t g = 0; g < groups; g++, out += 16) {
+        __m256i x0, x1, x2, x3;
+        philox_avx2(group + g, p, x0, x1, x2, x3);
+        __m256i a = _mm256_unpacklo_epi32(x0, x1), b = _mm256_unpackhi_epi32(x0, x1);
+        __m256i c = _mm256_unpacklo_epi32(x2, x3), d = _mm256_unpackhi_epi32(x2, x3);
+        _mm256_storeu_pd(out, scale_pd4(_mm256_permute2x128_si256(a, b, 0x20), lo, scale));
+        _mm256_storeu_pd(out + 4, scale_pd4(_mm256_permute2x128_si256(a, b, 0x31), lo, scale));
+        _mm256_storeu_pd(out + 8, scale_pd4(_mm256_permute2x128_si256(c, d, 0x20), lo, scale));
+        _mm256_storeu_pd(out + 12, scale_pd4(_mm256_permute2x128_si256(c, d, 0x31), lo, scale));
+    }
+}
+
+TARGET_AVX2 static void groups_f32_avx2(uint64_t group, size_t groups, const RandomParams& p, float* out) {
+    const __m256 lo = _mm256_set1_ps(static_cast<float>(p.lo));
+    const __m256 scale = _mm256_set1_ps(static_cast<float>(p.scale));
+    for (size_t g = 0; g < groups; g++, out += 32) {
+        __m256i x0, x1, x2, x3;
+        philox_avx2(group + g, p, x0, x1, x2, x3);
+        _mm256_storeu_ps(out, scale_ps8(x0, lo, scale));
+        _mm256_storeu_ps(out + 8, scale_ps8(x1, lo, scale));
+        _mm256_storeu_ps(out + 16, scale_ps8(x2, lo, scale));
+        _mm256_storeu_ps(out + 24, scale_ps8(x3, lo, scale));
+    }
+}
+#endif
+
+static RandomGroups<double>::Fn groups_kernel(double*) {
+#if USE_X86_SIMD
+    return cpu_features().avx2 ? groups_f64_avx2 : groups_f64_sse2;
+#else
+    return groups_f64_scalar;
+#endif
+}
+
+static RandomGroups<float>::Fn groups_kernel(float*) {
+#if USE_X86_SIMD
+    return cpu_features().avx2 ? groups_f32_avx2 : groups_f32_sse2;
+#else
+    return groups_f32_scalar;
+#endif
+}
+
+// Elements [first, first + n) of the fill's sequence into out
+template <typename T>
+static void fill_run(T* out, uint64_t first, size_t n, const RandomParams& p,
+                     typename RandomGroups<T>::Fn kernel) {
+    const size_t G = RandomGroups<T>::elements;
+    T buffer[RandomGroups<T>::elements];
+    size_t offset = first % G;
+    if (offset != 0) {
+        size_t take = std::min(n, G - offset);
+        kernel(first / G, 1, p, buffer);
+        std::memcpy(out, buffer + offset, take * sizeof(T));
+        out += take;
+        first += take;
+        n -= take;
+    }
+    size_t full = n / G;
+    kernel(first / G, full, p, out);
+    out += full * G;
+    first += full * G;
+    n -= full * G;
+    if (n > 0) {
+        kernel(first / G, 1, p, buffer);
+        std::memcpy(out, buffer, n * sizeof(T));
+    }
+}
+
+// 16-bit types round a float fill, a buffer at a time
+template <typename T>
+static void fill_run_half(T* out, uint64_t first, size_t n, const RandomParams& p,
+                          RandomGroups<float>::Fn kernel) {
+    float buffer[1024];
+    while (n > 0) {
+        size_t take = std::min<size_t>(n, 1024);
+        fill_run(buffer, first, take, p, kernel);
+        for (size_t i = 0; i < take; i++) {
+            out[i] = T(buffer[i]);
+        }
+        out += take;
+        first += take;
+        n -= take;
+    }
+}
+
+// Calls fn(row_ptr, element_index, n) for the row pieces of each block of
+// kRandomBlock elements, spreading the blocks over the pool
+template <typename T, typename F>
+static void for_each_fill_run(const BasicMatrixView<T>& m, size_t num_threads, const F& fn) {
+    const size_t cols = m.getCols();
+    const size_t count = m.getRows() * cols;
+    if (count == 0) {
+        return;
+    }
+    const size_t blocks = (count + kRandomBlock - 1) / kRandomBlock;
+    parallel_blocks(blocks, count, kRandomParallelMin, num_threads, [&](size_t block) {
+        size_t begin = block * kRandomBlock, end = std::min(count, begin + kRandomBlock);
+        for_each_row_piece(cols, begin, end, [&](size_t i, size_t j, size_t n) {
+            fn(m.row(i) + j, static_cast<uint64_t>(i * cols + j), n);
+        });
+    });
+}
+
+template <typename T>
+static void random_uniform_impl(const BasicMatrixView<T>& m, const RandomParams& p, size_t num_threads) {
+    typename RandomGroups<T>::Fn kernel = groups_kernel(static_cast<T*>(nullptr));
+    for_each_fill_run(m, num_threads, [&](T* out, uint64_t first, size_t n) {
+        fill_run(out, first, n, p, kernel);
+    });
+}
+
+template <typename T>
+static void random_uniform_half(const BasicMatrixView<T>& m, const RandomParams& p, size_t num_threads) {
+    RandomGroups<float>::Fn kernel = groups_kernel(static_cast<float*>(nullptr));
+    for_each_fill_run(m, num_threads, [&](T* out, uint64_t first, size_t n) {
+        fill_run_half(out, first, n, p, kernel);
+    });
+}
+
+static RandomParams make_params(double lo, double hi, uint64_t seed, uint64_t stream) {
+    RandomParams p;
+    p.seed = seed;
+    p.stream = stream;
+    p.lo = lo;
+    p.scale = hi - lo;
+    return p;
+}
+
+void random_uniform(const MatrixView& m, double lo, double hi, uint64_t seed, uint64_t stream,
+                    size_t num_threads) {
+    random_uniform_impl(m, make_params(lo, hi, seed, stream), num_threads);
+}
+
+void random_uniform(const MatrixViewF32& m, double lo, double hi, uint64_t seed, uint64_t stream,
+                    size_t num_threads) {
+    random_uniform_impl(m, make_params(lo, hi, seed, stream), num_threads);
+}
+
+void random_uniform(const BasicMatrixView<bfloat16>& m, double lo, double hi, uint64_t seed,
+                    uint64_t stream, size_t num_threads) {
+    random_uniform_half(m, make_params(lo, hi, seed, stream), num_threads);
+}
+
+void random_uniform(const BasicMatrixView<float16>& m, double lo, double hi, uint64_t seed,
+                    uint64_t stream, size_t num_threads) {
+    random_uniform_half(m, make_params(lo, hi, seed, stream), num_threads);
+}
+
+static std::mutex g_seed_mutex;
+static bool g_seed_set = false;
+static uint64_t g_seed = 0;
+static std::atomic<uint64_t> g_next_stream(0);
+
+static uint64_t default_random_seed() {
+    const char* env = std::getenv("RANDOM_SEED");
+    if (env != nullptr && *env != '\0') {
+        return std::strtoull(env, nullptr, 0);
+    }
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
+uint64_t get_random_seed() {
+    std::lock_guard<std::mutex> lock(g_seed_mutex);
+    if (!g_seed_set) {
+        g_seed = default_random_seed();
+        g_seed_set = true;
+    }
+    return g_seed;
+}
+
+void set_random_seed(uint64_t seed) {
+    std::lock_guard<std::mutex> lock(g_seed_mutex);
+    g_seed = seed;
+    g_seed_set = true;
+    g_next_stream = 0;
+}
+
+uint64_t next_random_stream() {
+    return g_next_stream++;
+}
+
+template <typename T>
+static void benchmark_random_size(const char* label, size_t size) {
+    BasicMatrix<T> a(size, size);
+    BasicMatrix<T> b(size, size);
+    const double elements = static_cast<double>(size) * size;
+    const uint64_t seed = get_random_seed();
+
+    double old_seconds = best_seconds([&] {
+        std::mt19937 gen(static_cast<std::mt19937::result_type>(seed));
+        std::uniform_real_distribution<> dis(0.0, 10.0);
+        for (size_t i = 0; i < size; i++) {
+            T* r = a.row(i);
+            for (size_t j = 0; j < size; j++) {
+                r[j] = static_cast<T>(dis(gen));
+            }
+        }
+    }, 3);
+    double seconds = best_seconds([&] { random_uniform(a.view(), 0.0, 10.0, seed, 0); }, 3);
+    random_uniform(b.view(), 0.0, 10.0, seed, 0, 1);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < size; i++) {
+        mismatches += std::memcmp(a.row(i), b.row(i), size * sizeof(T)) != 0;
+    }
+
+    std::cout << label << " " << size << "x" << size << ": mt19937 "
+              << elements / old_seconds / 1e6 << " M/s, philox "
+              << elements / seconds / 1e6 << " M/s ("
+              << elements * sizeof(T) / seconds / 1e9 << " GB/s), mean " << a.sum() / elements
+              << ", rows differing from 1 thread " << mismatches << std::endl;
+}
+
+void benchmark_random() {
+    std::cout << "\n=== Random Fill Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << ", seed " << get_random_seed() << std::endl;
+
+    benchmark_random_size<double>("fp64", 4096);
+    benchmark_random_size<float>("fp32", 4096);
+    benchmark_random_size<bfloat16>("bf16", 2048);
+}
@@ -0,0 +1,38 @@
+#ifndef RANDOM_FILL_H
+#define RANDOM_FILL_H
+
+#include <cstddef>
+#include <cstdint>
+#include "matrix_operations.h"
+
+// Counter-based random fills (Philox4x32-10).
+//
+// Element (i, j) of a fill gets a value computed from (seed, stream,
+// i * cols + j) alone, so the output does not depend on the thread count or
+// the view's stride, and a run is reproduced by its seed. The random bits
+// are the same on every SIMD level; scaling to [lo, hi) may round in the
+// last place differently where it fuses into an FMA. Values carry 52 random
+// mantissa bits for double and 23 for float; bf16 and fp16 round a float
+// draw.
+
+// Process-wide seed: set_random_seed(), else the RANDOM_SEED environment
+// variable, else std::random_device
+uint64_t get_random_seed();
+// Also restarts the stream sequence, so the same seed repeats a run
+void set_random_seed(uint64_t seed);
+// Distinct stream per call, for fills that should differ from each other
+uint64_t next_random_stream();
+
+void random_uniform(const MatrixView& m, double lo, double hi, uint64_t seed, uint64_t stream,
+                    size_t num_threads = 0);
+void random_uniform(const MatrixViewF32& m, double lo, double hi, uint64_t seed, uint64_t stream,
+                    size_t num_threads = 0);
+void random_uniform(const BasicMatrixView<bfloat16>& m, double lo, double hi, uint64_t seed,
+                    uint64_t stream, size_t num_threads = 0);
+void random_uniform(const BasicMatrixView<float16>& m, double lo, double hi, uint64_t seed,
+                    uint64_t stream, size_t num_threads = 0);
+
+// Benchmark function: fill rate against mt19937 + uniform_real_distribution
+void benchmark_random();
+
+#endif // RANDOM_FILL_H
@@ -0,0 +1,557 @@
+#include "reductions.h"
+#include "bench_util.h"
+#include "cpu_features.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Elements per block of work. Blocks are cut by position rather than by
+// thread, so results do not depend on the thread count.
+static const size_t kReduceBlock = 1 << 15;
+// Elements below which the work stays on the calling thread
+static const size_t kReduceParallelMin = 1 << 17;
+// Longest run summed directly by the vector kernel in pairwise mode
+static const size_t kPairwiseLeaf = 256;
+
+// Value summed for each element (b is only read by kMapProduct)
+enum ReduceMap { kMapIdentity, kMapAbs, kMapSquare, kMapProduct };
+
+// Running sums and Kahan compensations, one per lane: four accumulators of
+// up to four doubles each
+struct ReduceLanes {
+    double sum[16];
+    double comp[16];
+};
+
+// Smallest and largest element per lane, and whether a NaN was seen
+struct MinMaxLanes {
+    double lo[8];
+    double hi[8];
+    bool nan;
+};
+
+// Neumaier's variant of Kahan summation; also adds values larger than the
+// running total without losing the total's low bits
+struct CompensatedSum {
+    double hi;
+    double lo;
+
+    CompensatedSum() : hi(0.0), lo(0.0) {}
+
+    void add(double x) {
+        double t = hi + x;
+        lo += (std::fabs(hi) >= std::fabs(x)) ? (hi - t) + x : (x - t) + hi;
+        hi = t;
+    }
+    double value() const { return hi + lo; }
+};
+
+template <typename T>
+struct ReduceKernel {
+    typedef void (*Fn)(const T* a, const T* b, size_t n, ReduceLanes& lanes);
+};
+
+template <typename T>
+struct MinMaxKernel {
+    typedef void (*Fn)(const T* a, size_t n, MinMaxLanes& lanes);
+};
+
+template <int M>
+static inline double map_scalar(double x, double y) {
+    if (M == kMapAbs) return std::fabs(x);
+    if (M == kMapSquare) return x * x;
+    if (M == kMapProduct) return x * y;
+    return x;
+}
+
+template <bool Kahan>
+static inline void add_lane(ReduceLanes& lanes, size_t l, double x) {
+    if (Kahan) {
+        double y = x - lanes.comp[l];
+        double t = lanes.sum[l] + y;
+        lanes.comp[l] = (t - lanes.sum[l]) - y;
+        lanes.sum[l] = t;
+    } else {
+        lanes.sum[l] += x;
+    }
+}
+
+template <int M, bool Kahan, typename T>
+static void sum_scalar(const T* a, const T* b, size_t n, ReduceLanes& lanes) {
+    for (size_t i = 0; i < n; i++) {
+        add_lane<Kahan>(lanes, i & 3, map_scalar<M>(a[i], b[i]));
+    }
+}
+
+template <bool Abs, typename T>
+static void minmax_scalar(const T* a, size_t n, MinMaxLanes& lanes) {
+    for (size_t i = 0; i < n; i++) {
+        double x = Abs ? std::fabs(static_cast<double>(a[i])) : static_cast<double>(a[i]);
+        if (x != x) {
+            lanes.nan = true;
+            continue;
+        }
+        lanes.lo[0] = std::min(lanes.lo[0], x);
+        lanes.hi[0] = std::max(lanes.hi[0], x);
+    }
+}
+
+#if USE_X86_SIMD
+static inline __m128d load_pd2(const double* p) {
+    return _mm_loadu_pd(p);
+}
+
+static inline __m128d load_pd2(const float* p) {
+    return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+
+template <int M>
+static inline __m128d map_pd2(__m128d x, __m128d y) {
+    if (M == kMapAbs) return _mm_andnot_pd(_mm_set1_pd(-0.0), x);
+    if (M == kMapSquare) return _mm_mul_pd(x, x);
+    if (M == kMapProduct) return _mm_mul_pd(x, y);
+    return x;
+}
+
+template <bool Kahan>
+static inline void add_pd2(__m128d& s, __m128d& c, __m128d x) {
+    if (Kahan) {
+        __m128d y = _mm_sub_pd(x, c);
+        __m128d t = _mm_add_pd(s, y);
+        c = _mm_sub_pd(_mm_sub_pd(t, s), y);
+        s = t;
+    } else {
+        s = _mm_add_pd(s, x);
+    }
+}
+
+template <int M, bool Kahan, typename T>
+static void sum_sse2(const T* a, const T* b, size_t n, ReduceLanes& lanes) {
+    __m128d s0 = _mm_loadu_pd(lanes.sum), s1 = _mm_loadu_pd(lanes.sum + 2);
+    __m128d s2 = _mm_loadu_pd(lanes.sum + 4), s3 = _mm_loadu_pd(lanes.sum + 6);
+    __m128d c0 = _mm_loadu_pd(lanes.comp), c1 = _mm_loadu_pd(lanes.comp + 2);
+    __m128d c2 = _mm_loadu_pd(lanes.comp + 4), c3 = _mm_loadu_pd(lanes.comp + 6);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        add_pd2<Kahan>(s0, c0, map_pd2<M>(load_pd2(a + i), load_pd2(b + i)));
+        add_pd2<Kahan>(s1, c1, map_pd2<M>(load_pd2(a + i + 2), load_pd2(b + i + 2)));
+        add_pd2<Kahan>(s2, c2, map_pd2<M>(load_pd2(a + i + 4), load_pd2(b + i + 4)));
+        add_pd2<Kahan>(s3, c3, map_pd2<M>(load_pd2(a + i + 6), load_pd2(b + i + 6)));
+    }
+    _mm_storeu_pd(lanes.sum, s0);
+    _mm_storeu_pd(lanes.sum + 2, s1);
+    _mm_storeu_pd(lanes.sum + 4, s2);
+    _mm_storeu_pd(lanes.sum + 6, s3);
+    _mm_storeu_pd(lanes.comp, c0);
+    _mm_storeu_pd(lanes.comp + 2, c1);
+    _mm_storeu_pd(lanes.comp + 4, c2);
+    _mm_storeu_pd(lanes.comp + 6, c3);
+    sum_scalar<M, Kahan>(a + i, b + i, n - i, lanes);
+}
+
+// NaNs are flagged separately since minpd/maxpd drop them depending on
+// operand order
+template <bool Abs, typename T>
+static void minmax_sse2(const T* a, size_t n, MinMaxLanes& lanes) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d lo0 = _mm_loadu_pd(lanes.lo), lo1 = _mm_loadu_pd(lanes.lo + 2);
+    __m128d hi0 = _mm_loadu_pd(lanes.hi), hi1 = _mm_loadu_pd(lanes.hi + 2);
+    __m128d nan = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128d x0 = load_pd2(a + i), x1 = load_pd2(a + i + 2);
+        if (Abs) {
+            x0 = _mm_andnot_pd(sign, x0);
+            x1 = _mm_andnot_pd(sign, x1);
+        }
+        nan = _mm_or_pd(nan, _mm_or_pd(_mm_cmpunord_pd(x0, x0), _mm_cmpunord_pd(x1, x1)));
+        lo0 = _mm_min_pd(x0, lo0);
+        lo1 = _mm_min_pd(x1, lo1);
+        hi0 = _mm_max_pd(x0, hi0);
+        hi1 = _mm_max_pd(x1, hi1);
+    }
+    _mm_storeu_pd(lanes.lo, lo0);
+    _mm_storeu_pd(lanes.lo + 2, lo1);
+    _mm_storeu_pd(lanes.hi, hi0);
+    _mm_storeu_pd(lanes.hi + 2, hi1);
+    lanes.nan = lanes.nan || _mm_movemask_pd(nan) != 0;
+    minmax_scalar<Abs>(a + i, n - i, lanes);
+}
+
+TARGET_AVX2 static inline __m256d load_pd4(const double* p) {
+    return _mm256_loadu_pd(p);
+}
+
+TARGET_AVX2 static inline __m256d load_pd4(const float* p) {
+    return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+// Squares and products fold into FMAs unless compensating
+template <int M, bool Kahan>
+TARGET_AVX2 static inline void add_pd4(__m256d& s, __m256d& c, __m256d x, __m256d y) {
+    if (!Kahan && (M == kMapSquare || M == kMapProduct)) {
+        s = _mm256_fmadd_pd(x, M == kMapSquare ? x : y, s);
+        return;
+    }
+    if (M == kMapAbs) x = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+    if (M == kMapSquare) x = _mm256_mul_pd(x, x);
+    if (M == kMapProduct) x = _mm256_mul_pd(x, y);
+    if (Kahan) {
+        __m256d v = _mm256_sub_pd(x, c);
+        __m256d t = _mm256_add_pd(s, v);
+        c = _mm256_sub_pd(_mm256_sub_pd(t, s), v);
+        s = t;
+    } else {
+        s = _mm256_add_pd(s, x);
+    }
+}
+
+template <int M, bool Kahan, typename T>
+TARGET_AVX2 static void sum_avx2(const T* a, const T* b, size_t n, ReduceLanes& lanes) {
+    __m256d s0 = _mm256_loadu_pd(lanes.sum), s1 = _mm256_loadu_pd(lanes.sum + 4);
+    __m256d s2 = _mm256_loadu_pd(lanes.sum + 8), s3 = _mm256_loadu_pd(lanes.sum + 12);
+    __m256d c0 = _mm256_loadu_pd(lanes.comp), c1 = _mm256_loadu_pd(lanes.comp + 4);
+    __m256d c2 = _mm256_loadu_pd(lanes.comp + 8), c3 = _mm256_loadu_pd(lanes.comp + 12);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        add_pd4<M, Kahan>(s0, c0, load_pd4(a + i), load_pd4(b + i));
+        add_pd4<M, Kahan>(s1, c1, load_pd4(a + i + 4), load_pd4(b + i + 4));
+        add_pd4<M, Kahan>(s2, c2, load_pd4(a + i + 8), load_pd4(b + i + 8));
+        add_pd4<M, Kahan>(s3, c3, load_pd4(a + i + 12), load_pd4(b + i + 12));
+    }
+    _mm256_storeu_pd(lanes.sum, s0);
+    _mm256_storeu_pd(lanes.sum + 4, s1);
+    _mm256_storeu_pd(lanes.sum + 8, s2);
+    _mm256_storeu_pd(lanes.sum + 12, s3);
+    _mm256_storeu_pd(lanes.comp, c0);
+    _mm256_storeu_pd(lanes.comp + 4, c1);
+    _mm256_storeu_pd(lanes.comp + 8, c2);
+    _mm256_storeu_pd(lanes.comp + 12, c3);
+    sum_scalar<M, Kahan>(a + i, b + i, n - i, lanes);
+}
+
+template <bool Abs, typename T>
+TARGET_AVX2 static void minmax_avx2(const T* a, size_t n, MinMaxLanes& lanes) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d lo0 = _mm256_loadu_pd(lanes.lo), lo1 = _mm256_loadu_pd(lanes.lo + 4);
+    __m256d hi0 = _mm256_loadu_pd(lanes.hi), hi1 = _mm256_loadu_pd(lanes.hi + 4);
+    __m256d nan = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d x0 = load_pd4(a + i), x1 = load_pd4(a + i + 4);
+        if (Abs) {
+            x0 = _mm256_andnot_pd(sign, x0);
+            x1 = _mm256_andnot_pd(sign, x1);
+        }
+        nan = _mm256_or_pd(nan, _mm256_or_pd(_mm256_cmp_pd(x0, x0, _CMP_UNORD_Q),
+                                             _mm256_cmp_pd(x1, x1, _CMP_UNORD_Q)));
+        lo0 = _mm256_min_pd(x0, lo0);
+        lo1 = _mm256_min_pd(x1, lo1);
+        hi0 = _mm256_max_pd(x0, hi0);
+        hi1 = _mm256_max_pd(x1, hi1);
+    }
+    _mm256_storeu_pd(lanes.lo, lo0);
+    _mm256_storeu_pd(lanes.lo + 4, lo1);
+    _mm256_storeu_pd(lanes.hi, hi0);
+    _mm256_storeu_pd(lanes.hi + 4, hi1);
+    lanes.nan = lanes.nan || _mm256_movemask_pd(nan) != 0;
+    minmax_scalar<Abs>(a + i, n - i, lanes);
+}
+#endif
+
+template <int M, bool Kahan, typename T>
+static typename ReduceKernel<T>::Fn sum_kernel() {
+#if USE_X86_SIMD
+    return (cpu_features().avx2 && cpu_features().fma) ? sum_avx2<M, Kahan, T> : sum_sse2<M, Kahan, T>;
+#else
+    return sum_scalar<M, Kahan, T>;
+#endif
+}
+
+template <bool Abs, typename T>
+static typename MinMaxKernel<T>::Fn minmax_kernel() {
+#if USE_X86_SIMD
+    return cpu_features().avx2 ? minmax_avx2<Abs, T> : minmax_sse2<Abs, T>;
+#else
+    return minmax_scalar<Abs, T>;
+#endif
+}
+
+// Lanes added as a fixed pairwise tree
+static double lanes_total(ReduceLanes& lanes) {
+    for (size_t width = 8; width >= 1; width /= 2) {
+        for (size_t l = 0; l < width; l++) {
+            lanes.sum[l] += lanes.sum[l + width];
+        }
+    }
+    return lanes.sum[0];
+}
+
+static CompensatedSum lanes_compensated(const ReduceLanes& lanes) {
+    CompensatedSum total;
+    for (size_t l = 0; l < 16; l++) {
+        total.add(lanes.sum[l]);
+        total.add(-lanes.comp[l]);
+    }
+    return total;
+}
+
+template <typename T>
+static double pairwise_sum(const BasicConstMatrixView<T>& a, const BasicConstMatrixView<T>& b,
+                           size_t begin, size_t end, typename ReduceKernel<T>::Fn kernel) {
+    if (end - begin <= kPairwiseLeaf) {
+        ReduceLanes lanes = {};
+        for_each_row_piece(a.getCols(), begin, end, [&](size_t i, size_t j, size_t n) {
+            kernel(a.row(i) + j, b.row(i) + j, n, lanes);
+        });
+        return lanes_total(lanes);
+    }
+    // Split on a multiple of 16 so the vector loops see whole iterations
+    size_t mid = begin + (((end - begin) / 2 + 15) & ~size_t(15));
+    return pairwise_sum(a, b, begin, mid, kernel) + pairwise_sum(a, b, mid, end, kernel);
+}
+
+static double pairwise_total(const std::vector<CompensatedSum>& partial, size_t begin, size_t end) {
+    if (end - begin == 1) {
+        return partial[begin].hi;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    return pairwise_total(partial, begin, mid) + pairwise_total(partial, mid, end);
+}
+
+template <int M, typename T>
+static double reduce_sum(const BasicConstMatrixView<T>& a, const BasicConstMatrixView<T>& b,
+                         SumMode mode, size_t num_threads) {
+    const size_t count = a.getRows() * a.getCols();
+    if (count == 0) {
+        return 0.0;
+    }
+    typename ReduceKernel<T>::Fn kernel =
+        (mode == SumMode::Kahan) ? sum_kernel<M, true, T>() : sum_kernel<M, false, T>();
+
+    std::vector<CompensatedSum> partial((count + kReduceBlock - 1) / kReduceBlock);
+    parallel_blocks(partial.size(), count, kReduceParallelMin, num_threads, [&](size_t block) {
+        size_t begin = block * kReduceBlock, end = std::min(count, begin + kReduceBlock);
+        if (mode == SumMode::Pairwise) {
+            partial[block].hi = pairwise_sum(a, b, begin, end, kernel);
+            return;
+        }
+        ReduceLanes lanes = {};
+        for_each_row_piece(a.getCols(), begin, end, [&](size_t i, size_t j, size_t n) {
+            kernel(a.row(i) + j, b.row(i) + j, n, lanes);
+        });
+        if (mode == SumMode::Kahan) {
+            partial[block] = lanes_compensated(lanes);
+        } else {
+            partial[block].hi = lanes_total(lanes);
+        }
+    });
+
+    if (mode == SumMode::Pairwise) {
+        return pairwise_total(partial, 0, partial.size());
+    }
+    if (mode == SumMode::Kahan) {
+        CompensatedSum total;
+        for (const CompensatedSum& p : partial) {
+            total.add(p.hi);
+            total.add(p.lo);
+        }
+        return total.value();
+    }
+    double total = 0.0;
+    for (const CompensatedSum& p : partial) {
+        total += p.hi;
+    }
+    return total;
+}
+
+template <bool Abs, typename T>
+static MinMaxLanes reduce_minmax(const BasicConstMatrixView<T>& m, size_t num_threads) {
+    MinMaxLanes init;
+    std::fill(init.lo, init.lo + 8, std::numeric_limits<double>::infinity());
+    std::fill(init.hi, init.hi + 8, -std::numeric_limits<double>::infinity());
+    init.nan = false;
+
+    const size_t count = m.getRows() * m.getCols();
+    if (count == 0) {
+        return init;
+    }
+    typename MinMaxKernel<T>::Fn kernel = minmax_kernel<Abs, T>();
+    std::vector<MinMaxLanes> partial((count + kReduceBlock - 1) / kReduceBlock, init);
+    parallel_blocks(partial.size(), count, kReduceParallelMin, num_threads, [&](size_t block) {
+        size_t begin = block * kReduceBlock, end = std::min(count, begin + kReduceBlock);
+        for_each_row_piece(m.getCols(), begin, end, [&](size_t i, size_t j, size_t n) {
+            kernel(m.row(i) + j, n, partial[block]);
+        });
+    });
+
+    MinMaxLanes result = init;
+    for (const MinMaxLanes& p : partial) {
+        result.nan = result.nan || p.nan;
+        for (size_t l = 0; l < 8; l++) {
+            result.lo[0] = std::min(result.lo[0], p.lo[l]);
+            result.hi[0] = std::max(result.hi[0], p.hi[l]);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+static double min_impl(const BasicConstMatrixView<T>& m, size_t num_threads) {
+    MinMaxLanes r = reduce_minmax<false>(m, num_threads);
+    return r.nan ? std::numeric_limits<double>::quiet_NaN() : r.lo[0];
+}
+
+template <typename T>
+static double max_impl(const BasicConstMatrixView<T>& m, size_t num_threads) {
+    MinMaxLanes r = reduce_minmax<false>(m, num_threads);
+    return r.nan ? std::numeric_limits<double>::quiet_NaN() : r.hi[0];
+}
+
+template <typename T>
+static double norm_max_impl(const BasicConstMatrixView<T>& m, size_t num_threads) {
+    if (m.empty()) {
+        return 0.0;
+    }
+    MinMaxLanes r = reduce_minmax<true>(m, num_threads);
+    return r.nan ? std::numeric_limits<double>::quiet_NaN() : r.hi[0];
+}
+
+template <typename T>
+static double dot_impl(const BasicConstMatrixView<T>& a, const BasicConstMatrixView<T>& b,
+                       SumMode mode, size_t num_threads) {
+    if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+        throw std::runtime_error("Matrix dimensions must match for dot product");
+    }
+    return reduce_sum<kMapProduct>(a, b, mode, num_threads);
+}
+
+double matrix_sum(const ConstMatrixView& m, SumMode mode, size_t num_threads) {
+    return reduce_sum<kMapIdentity>(m, m, mode, num_threads);
+}
+
+double matrix_sum(const ConstMatrixViewF32& m, SumMode mode, size_t num_threads) {
+    return reduce_sum<kMapIdentity>(m, m, mode, num_threads);
+}
+
+double matrix_dot(const ConstMatrixView& a, const ConstMatrixView& b, SumMode mode, size_t num_threads) {
+    return dot_impl(a, b, mode, num_threads);
+}
+
+double matrix_dot(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b, SumMode mode,
+                  size_t num_threads) {
+    return dot_impl(a, b, mode, num_threads);
+}
+
+double norm_l1(const ConstMatrixView& m, SumMode mode, size_t num_threads) {
+    return reduce_sum<kMapAbs>(m, m, mode, num_threads);
+}
+
+double norm_l1(const ConstMatrixViewF32& m, SumMode mode, size_t num_threads) {
+    return reduce_sum<kMapAbs>(m, m, mode, num_threads);
+}
+
+double norm_frobenius(const ConstMatrixView& m, SumMode mode, size_t num_threads) {
+    return std::sqrt(reduce_sum<kMapSquare>(m, m, mode, num_threads));
+}
+
+double norm_frobenius(const ConstMatrixViewF32& m, SumMode mode, size_t num_threads) {
+    return std::sqrt(reduce_sum<kMapSquare>(m, m, mode, num_threads));
+}
+
+double norm_max(const ConstMatrixView& m, size_t num_threads) {
+    return norm_max_impl(m, num_threads);
+}
+
+double norm_max(const ConstMatrixViewF32& m, size_t num_threads) {
+    return norm_max_impl(m, num_threads);
+}
+
+double matrix_min(const ConstMatrixView& m, size_t num_threads) {
+    return min_impl(m, num_threads);
+}
+
+double matrix_min(const ConstMatrixViewF32& m, size_t num_threads) {
+    return min_impl(m, num_threads);
+}
+
+double matrix_max(const ConstMatrixView& m, size_t num_threads) {
+    return max_impl(m, num_threads);
+}
+
+double matrix_max(const ConstMatrixViewF32& m, size_t num_threads) {
+    return max_impl(m, num_threads);
+}
+
+void benchmark_reductions() {
+    std::cout << "\n=== Reductions Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    // 64 MB, well beyond the last-level cache. A large offset on every
+    // element makes the uncompensated error visible.
+    const size_t rows = 2048, cols = 4096;
+    Matrix a(rows, cols);
+    Matrix b(rows, cols);
+    a.randomize();
+    b.randomize();
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            a(i, j) += 1e6;
+        }
+    }
+    const double bytes = static_cast<double>(rows) * cols * sizeof(double);
+
+    long double exact = 0.0L;
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            exact += a(i, j);
+        }
+    }
+
+    double scalar = 0.0;
+    double seconds = best_seconds([&] {
+        scalar = 0.0;
+        for (size_t i = 0; i < rows; i++) {
+            const double* r = a.row(i);
+            for (size_t j = 0; j < cols; j++) {
+                scalar += r[j];
+            }
+        }
+    });
+    std::cout << "sum " << rows << "x" << cols << " scalar loop: " << bytes / seconds / 1e9
+              << " GB/s, relative error " << std::fabs((scalar - exact) / exact) << std::endl;
+
+    const SumMode modes[] = { SumMode::Fast, SumMode::Pairwise, SumMode::Kahan };
+    const char* names[] = { "fast", "pairwise", "kahan" };
+    for (size_t k = 0; k < 3; k++) {
+        double total = 0.0;
+        seconds = best_seconds([&] { total = matrix_sum(a, modes[k]); });
+        bool reproducible = matrix_sum(a, modes[k], 1) == total;
+        std::cout << "sum " << names[k] << ": " << bytes / seconds / 1e9
+                  << " GB/s, relative error " << std::fabs((total - exact) / exact)
+                  << (reproducible ? ", same on 1 thread" : ", DIFFERS on 1 thread") << std::endl;
+    }
+
+    double result = 0.0;
+    seconds = best_seconds([&] { result = matrix_dot(a, b); });
+    std::cout << "dot: " << 2 * bytes / seconds / 1e9 << " GB/s, value " << result << std::endl;
+    seconds = best_seconds([&] { result = norm_frobenius(b); });
+    std::cout << "frobenius norm: " << bytes / seconds / 1e9 << " GB/s, value " << result << std::endl;
+    seconds = best_seconds([&] { result = matrix_max(b); });
+    std::cout << "max: " << bytes / seconds / 1e9 << " GB/s, value " << result << std::endl;
+
+    MatrixF32 f(rows, cols);
+    f.randomize();
+    seconds = best_seconds([&] { result = matrix_sum(f); });
+    std::cout << "fp32 sum: " << bytes / 2 / seconds / 1e9 << " GB/s, value " << result << std::endl;
+}
@@ -0,0 +1,49 @@
+#ifndef REDUCTIONS_H
+#define REDUCTIONS_H
+
+#include <cstddef>
+#include "matrix_operations.h"
+
+// Vectorized, parallel reductions over double and float matrices and views.
+//
+// Work is cut into fixed blocks of elements in row-major order whatever the
+// thread count, and block results are combined in block order, so every
+// reduction returns bit-identical results for any num_threads (0 = global
+// pool). float inputs are widened and accumulated in double. Results can
+// differ in the last bits between SIMD levels (SSE2, AVX2+FMA).
+
+// Accuracy of the summing reductions
+enum class SumMode {
+    Fast,      // several SIMD accumulators; error grows with n in the worst case
+    Pairwise,  // pairwise (cascade) summation; error grows with log n
+    Kahan      // compensated summation; error independent of n
+};
+
+double matrix_sum(const ConstMatrixView& m, SumMode mode = SumMode::Fast, size_t num_threads = 0);
+double matrix_sum(const ConstMatrixViewF32& m, SumMode mode = SumMode::Fast, size_t num_threads = 0);
+
+// Frobenius inner product: sum of a(i, j) * b(i, j); shapes must match
+double matrix_dot(const ConstMatrixView& a, const ConstMatrixView& b,
+                  SumMode mode = SumMode::Fast, size_t num_threads = 0);
+double matrix_dot(const ConstMatrixViewF32& a, const ConstMatrixViewF32& b,
+                  SumMode mode = SumMode::Fast, size_t num_threads = 0);
+
+// Entry-wise norms: sum |x|, sqrt(sum x^2) and max |x|
+double norm_l1(const ConstMatrixView& m, SumMode mode = SumMode::Fast, size_t num_threads = 0);
+double norm_l1(const ConstMatrixViewF32& m, SumMode mode = SumMode::Fast, size_t num_threads = 0);
+double norm_frobenius(const ConstMatrixView& m, SumMode mode = SumMode::Fast, size_t num_threads = 0);
+double norm_frobenius(const ConstMatrixViewF32& m, SumMode mode = SumMode::Fast, size_t num_threads = 0);
+double norm_max(const ConstMatrixView& m, size_t num_threads = 0);
+double norm_max(const ConstMatrixViewF32& m, size_t num_threads = 0);
+
+// Smallest and largest element. Any NaN makes the result NaN; an empty
+// matrix gives +inf and -inf respectively.
+double matrix_min(const ConstMatrixView& m, size_t num_threads = 0);
+double matrix_min(const ConstMatrixViewF32& m, size_t num_threads = 0);
+double matrix_max(const ConstMatrixView& m, size_t num_threads = 0);
+double matrix_max(const ConstMatrixViewF32& m, size_t num_threads = 0);
+
+// Benchmark function: reduction GB/s and accuracy by mode against a scalar loop
+void benchmark_reductions();
+
+#endif // REDUCTIONS_H
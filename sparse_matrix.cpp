@@ -0,0 +1,649 @@
+#include "sparse_matrix.h"
+#include "cpu_features.h"
+#include "memory_operations.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Row (or column) ranges are split so every thread gets about the same
+// number of nonzeros, not the same number of rows; with skewed row lengths
+// an even row split leaves most threads idle behind the one holding the
+// long rows. Each output element is still computed by exactly one thread in
+// a fixed order, so results do not depend on the thread count.
+
+// Below this much work (nonzeros times dense columns) a parallel launch
+// costs more than it saves
+static const size_t kSparseParallelMinWork = 32768;
+// SpMM walks the dense columns in stripes that keep a row of C in L1
+static const size_t kSpmmStripe = 256;
+// CSC SpMV scatters fixed column blocks into private partial vectors
+static const size_t kCscBlockNnz = 65536;
+static const size_t kMaxCscBlocks = 16;
+
+static thread_local ScratchBuffer t_csc_partial;
+
+// sum_p values[p] * x[idx[p]]
+typedef double (*SparseDot)(size_t nnz, const double* values, const int32_t* idx, const double* x);
+// y[0..n) += a * x[0..n)
+typedef void (*RowAxpy)(size_t n, double a, const double* x, double* y);
+// y[idx[p]] += a * values[p]; indices within one call are distinct
+typedef void (*SparseScatter)(size_t nnz, double a, const double* values, const int32_t* idx, double* y);
+
+static double sparse_dot_scalar(size_t nnz, const double* values, const int32_t* idx, const double* x) {
+    double sum = 0.0;
+    for (size_t p = 0; p < nnz; p++) {
+        sum += values[p] * x[idx[p]];
+    }
+    return sum;
+}
+
+static void row_axpy_scalar(size_t n, double a, const double* x, double* y) {
+    for (size_t j = 0; j < n; j++) {
+        y[j] += a * x[j];
+    }
+}
+
+static void sparse_scatter_scalar(size_t nnz, double a, const double* values, const int32_t* idx, double* y) {
+    for (size_t p = 0; p < nnz; p++) {
+        y[idx[p]] += a * values[p];
+    }
+}
+
+#if USE_X86_SIMD
+// SSE2 has no gather: pairs are assembled from scalar loads into 2 accumulators
+static double sparse_dot_sse2(size_t nnz, const double* values, const int32_t* idx, const double* x) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t p = 0;
+    for (; p + 4 <= nnz; p += 4) {
+        __m128d x0 = _mm_set_pd(x[idx[p + 1]], x[idx[p]]);
+        __m128d x1 = _mm_set_pd(x[idx[p + 3]], x[idx[p + 2]]);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(values + p), x0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(values + p + 2), x1));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    double sum = _mm_cvtsd_f64(_mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0)));
+    for (; p < nnz; p++) {
+        sum += values[p] * x[idx[p]];
+    }
+    return sum;
+}
+
+static void row_axpy_sse2(size_t n, double a, const double* x, double* y) {
+    const __m128d av = _mm_set1_pd(a);
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128d y0 = _mm_add_pd(_mm_loadu_pd(y + j), _mm_mul_pd(av, _mm_loadu_pd(x + j)));
+        __m128d y1 = _mm_add_pd(_mm_loadu_pd(y + j + 2), _mm_mul_pd(av, _mm_loadu_pd(x + j + 2)));
+        _mm_storeu_pd(y + j, y0);
+        _mm_storeu_pd(y + j + 2, y1);
+    }
+    for (; j < n; j++) {
+        y[j] += a * x[j];
+    }
+}
+
+// AVX2 gathers 4 x values per instruction, 2 accumulators
+TARGET_AVX2
+static double sparse_dot_avx2(size_t nnz, const double* values, const int32_t* idx, const double* x) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    // Masked gathers with an explicit source, as the unmasked form leaves it undefined
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    size_t p = 0;
+    for (; p + 8 <= nnz; p += 8) {
+        __m128i i0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx + p));
+        __m128i i1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx + p + 4));
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(values + p), _mm256_mask_i32gather_pd(zero, x, i0, all, 8), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(values + p + 4), _mm256_mask_i32gather_pd(zero, x, i1, all, 8), acc1);
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    for (; p < nnz; p++) {
+        sum += values[p] * x[idx[p]];
+    }
+    return sum;
+}
+
+TARGET_AVX2
+static void row_axpy_avx2(size_t n, double a, const double* x, double* y) {
+    const __m256d av = _mm256_set1_pd(a);
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256d y0 = _mm256_fmadd_pd(av, _mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j));
+        __m256d y1 = _mm256_fmadd_pd(av, _mm256_loadu_pd(x + j + 4), _mm256_loadu_pd(y + j + 4));
+        _mm256_storeu_pd(y + j, y0);
+        _mm256_storeu_pd(y + j + 4, y1);
+    }
+    for (; j < n; j++) {
+        y[j] += a * x[j];
+    }
+}
+
+// AVX-512F gathers 8 x values per instruction, 2 accumulators
+TARGET_AVX512
+static double sparse_dot_avx512(size_t nnz, const double* values, const int32_t* idx, const double* x) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    const __m512d zero = _mm512_setzero_pd();
+    size_t p = 0;
+    for (; p + 16 <= nnz; p += 16) {
+        __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + p));
+        __m256i i1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + p + 8));
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(values + p), _mm512_mask_i32gather_pd(zero, 0xFF, i0, x, 8), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(values + p + 8), _mm512_mask_i32gather_pd(zero, 0xFF, i1, x, 8), acc1);
+    }
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, _mm512_add_pd(acc0, acc1));
+    double sum = ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+    for (; p < nnz; p++) {
+        sum += values[p] * x[idx[p]];
+    }
+    return sum;
+}
+
+// Row indices within a CSC column are distinct, so gather/add/scatter is safe
+TARGET_AVX512
+static void sparse_scatter_avx512(size_t nnz, double a, const double* values, const int32_t* idx, double* y) {
+    const __m512d av = _mm512_set1_pd(a);
+    const __m512d zero = _mm512_setzero_pd();
+    size_t p = 0;
+    for (; p + 8 <= nnz; p += 8) {
+        __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + p));
+        __m512d v = _mm512_fmadd_pd(av, _mm512_loadu_pd(values + p), _mm512_mask_i32gather_pd(zero, 0xFF, i0, y, 8));
+        _mm512_i32scatter_pd(y, i0, v, 8);
+    }
+    for (; p < nnz; p++) {
+        y[idx[p]] += a * values[p];
+    }
+}
+#endif
+
+struct SparseKernels {
+    SparseDot dot;
+    RowAxpy axpy;
+    SparseScatter scatter;
+};
+
+static SparseKernels select_sparse_kernels() {
+    SparseKernels k = { sparse_dot_scalar, row_axpy_scalar, sparse_scatter_scalar };
+#if USE_X86_SIMD
+    const CpuFeatures& cpu = cpu_features();
+    if (cpu.avx512f) {
+        k.dot = sparse_dot_avx512;
+        k.axpy = row_axpy_avx2;
+        k.scatter = sparse_scatter_avx512;
+    } else if (cpu.avx2 && cpu.fma) {
+        k.dot = sparse_dot_avx2;
+        k.axpy = row_axpy_avx2;
+    } else if (cpu.sse2) {
+        k.dot = sparse_dot_sse2;
+        k.axpy = row_axpy_sse2;
+    }
+#endif
+    return k;
+}
+
+static const SparseKernels& sparse_kernels() {
+    static const SparseKernels kernels = select_sparse_kernels();
+    return kernels;
+}
+
+static void check_sparse_dimensions(size_t rows, size_t cols) {
+    if (rows > static_cast<size_t>(INT32_MAX) || cols > static_cast<size_t>(INT32_MAX)) {
+        throw std::runtime_error("Sparse matrix dimensions exceed 32-bit indices");
+    }
+}
+
+// Build compressed arrays from coordinates, by row (major = row) or by
+// column. Entries are bucketed by major index, then stably sorted by minor
+// index so duplicates are summed in input order.
+static void compress_entries(size_t rows, size_t cols, const std::vector<SparseEntry>& entries,
+                             bool by_column, std::vector<size_t>& ptr,
+                             std::vector<int32_t>& idx, std::vector<double>& values) {
+    check_sparse_dimensions(rows, cols);
+    const size_t major_count = by_column ? cols : rows;
+
+    std::vector<size_t> start(major_count + 1, 0);
+    for (size_t e = 0; e < entries.size(); e++) {
+        if (entries[e].row >= rows || entries[e].col >= cols) {
+            throw std::runtime_error("Sparse entry out of range");
+        }
+        start[(by_column ? entries[e].col : entries[e].row) + 1]++;
+    }
+    for (size_t m = 0; m < major_count; m++) {
+        start[m + 1] += start[m];
+    }
+
+    std::vector<std::pair<int32_t, double> > bucketed(entries.size());
+    std::vector<size_t> fill(start.begin(), start.end() - 1);
+    for (size_t e = 0; e < entries.size(); e++) {
+        const SparseEntry& s = entries[e];
+        size_t major = by_column ? s.col : s.row;
+        size_t minor = by_column ? s.row : s.col;
+        bucketed[fill[major]++] = std::make_pair(static_cast<int32_t>(minor), s.value);
+    }
+
+    ptr.assign(major_count + 1, 0);
+    idx.clear();
+    values.clear();
+    idx.reserve(entries.size());
+    values.reserve(entries.size());
+    for (size_t m = 0; m < major_count; m++) {
+        std::stable_sort(bucketed.begin() + start[m], bucketed.begin() + start[m + 1],
+                         [](const std::pair<int32_t, double>& x, const std::pair<int32_t, double>& y) {
+                             return x.first < y.first;
+                         });
+        for (size_t e = start[m]; e < start[m + 1]; e++) {
+            if (values.size() > ptr[m] && idx.back() == bucketed[e].first) {
+                values.back() += bucketed[e].second;
+            } else {
+                idx.push_back(bucketed[e].first);
+                values.push_back(bucketed[e].second);
+            }
+        }
+        ptr[m + 1] = values.size();
+    }
+}
+
+// Switch compressed storage between row-major and column-major order
+static void transpose_compressed(size_t major_count, size_t minor_count,
+                                 const std::vector<size_t>& ptr, const std::vector<int32_t>& idx,
+                                 const std::vector<double>& values,
+                                 std::vector<size_t>& out_ptr, std::vector<int32_t>& out_idx,
+                                 std::vector<double>& out_values) {
+    out_ptr.assign(minor_count + 1, 0);
+    out_idx.resize(values.size());
+    out_values.resize(values.size());
+    for (size_t p = 0; p < values.size(); p++) {
+        out_ptr[idx[p] + 1]++;
+    }
+    for (size_t m = 0; m < minor_count; m++) {
+        out_ptr[m + 1] += out_ptr[m];
+    }
+    std::vector<size_t> fill(out_ptr.begin(), out_ptr.end() - 1);
+    for (size_t m = 0; m < major_count; m++) {
+        for (size_t p = ptr[m]; p < ptr[m + 1]; p++) {
+            size_t q = fill[idx[p]]++;
+            out_idx[q] = static_cast<int32_t>(m);
+            out_values[q] = values[p];
+        }
+    }
+}
+
+// First major index of part `part` when [0, n) is split into `parts` ranges
+// of equal cost, counting one unit per nonzero plus one per row or column
+static size_t balanced_split(const std::vector<size_t>& ptr, size_t parts, size_t part) {
+    const size_t n = ptr.size() - 1;
+    if (part >= parts) {
+        return n;
+    }
+    const double target = static_cast<double>(ptr[n] + n) * part / parts;
+    size_t lo = 0;
+    size_t hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (static_cast<double>(ptr[mid] + mid) < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static size_t sparse_thread_count(size_t work, size_t max_parts, size_t num_threads) {
+    if (work < kSparseParallelMinWork || max_parts <= 1) {
+        return 1;
+    }
+    return std::max<size_t>(1, std::min(resolve_threads(num_threads), max_parts));
+}
+
+// fn(begin, end) over nonzero-balanced ranges of major indices
+template <typename F>
+static void run_balanced(const std::vector<size_t>& ptr, size_t work, size_t num_threads, const F& fn) {
+    const size_t major_count = ptr.size() - 1;
+    const size_t threads = sparse_thread_count(work, major_count, num_threads);
+    if (threads <= 1) {
+        fn(0, major_count);
+        return;
+    }
+    global_thread_pool().parallel_for(threads, [&](size_t t) {
+        fn(balanced_split(ptr, threads, t), balanced_split(ptr, threads, t + 1));
+    });
+}
+
+static void check_product_shapes(size_t rows, size_t cols, const Matrix& b, const Matrix& result) {
+    if (b.getRows() != cols || result.getRows() != rows || result.getCols() != b.getCols()) {
+        throw std::runtime_error("Invalid matrix dimensions for multiplication");
+    }
+    if (&b == &result) {
+        throw std::runtime_error("Sparse product output must not alias an input");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// CsrMatrix
+
+CsrMatrix::CsrMatrix() : rows(0), cols(0), row_ptr(1, 0) {}
+
+CsrMatrix::CsrMatrix(const Matrix& dense, double drop_tolerance)
+    : rows(dense.getRows()), cols(dense.getCols()), row_ptr(1, 0) {
+    check_sparse_dimensions(rows, cols);
+    row_ptr.reserve(rows + 1);
+    for (size_t i = 0; i < rows; i++) {
+        const double* r = dense.row(i);
+        for (size_t j = 0; j < cols; j++) {
+            // Written so NaNs are kept rather than silently dropped
+            if (!(std::fabs(r[j]) <= drop_tolerance)) {
+                col_idx.push_back(static_cast<int32_t>(j));
+                values.push_back(r[j]);
+            }
+        }
+        row_ptr.push_back(values.size());
+    }
+}
+
+CsrMatrix::CsrMatrix(size_t r, size_t c, const std::vector<SparseEntry>& entries)
+    : rows(r), cols(c) {
+    compress_entries(rows, cols, entries, false, row_ptr, col_idx, values);
+}
+
+CsrMatrix::CsrMatrix(const CscMatrix& other) : rows(other.rows), cols(other.cols) {
+    transpose_compressed(other.cols, other.rows, other.col_ptr, other.row_idx, other.values,
+                         row_ptr, col_idx, values);
+}
+
+void CsrMatrix::multiply(const double* x, double* y, size_t num_threads) const {
+    const SparseKernels& k = sparse_kernels();
+    run_balanced(row_ptr, values.size(), num_threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            size_t p = row_ptr[i];
+            y[i] = k.dot(row_ptr[i + 1] - p, values.data() + p, col_idx.data() + p, x);
+        }
+    });
+}
+
+Matrix CsrMatrix::multiply(const Matrix& b, size_t num_threads) const {
+    if (b.getRows() != cols) {
+        throw std::runtime_error("Invalid matrix dimensions for multiplication");
+    }
+    Matrix result(rows, b.getCols());
+    multiply_into(b, result, num_threads);
+    return result;
+}
+
+void CsrMatrix::multiply_into(const Matrix& b, Matrix& result, size_t num_threads) const {
+    check_product_shapes(rows, cols, b, result);
+    const SparseKernels& k = sparse_kernels();
+    const size_t n = b.getCols();
+    run_balanced(row_ptr, values.size() * n, num_threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            double* c = result.row(i);
+            std::fill(c, c + n, 0.0);
+            for (size_t js = 0; js < n; js += kSpmmStripe) {
+                size_t width = std::min(kSpmmStripe, n - js);
+                for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; p++) {
+                    k.axpy(width, values[p], b.row(col_idx[p]) + js, c + js);
+                }
+            }
+        }
+    });
+}
+
+Matrix CsrMatrix::to_dense() const {
+    Matrix dense(rows, cols);
+    for (size_t i = 0; i < rows; i++) {
+        double* r = dense.row(i);
+        for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; p++) {
+            r[col_idx[p]] = values[p];
+        }
+    }
+    return dense;
+}
+
+// ---------------------------------------------------------------------------
+// CscMatrix
+
+CscMatrix::CscMatrix() : rows(0), cols(0), col_ptr(1, 0) {}
+
+CscMatrix::CscMatrix(const Matrix& dense, double drop_tolerance)
+    : rows(dense.getRows()), cols(dense.getCols()), col_ptr(1, 0) {
+    check_sparse_dimensions(rows, cols);
+    col_ptr.reserve(cols + 1);
+    for (size_t j = 0; j < cols; j++) {
+        for (size_t i = 0; i < rows; i++) {
+            double v = dense(i, j);
+            if (!(std::fabs(v) <= drop_tolerance)) {
+                row_idx.push_back(static_cast<int32_t>(i));
+                values.push_back(v);
+            }
+        }
+        col_ptr.push_back(values.size());
+    }
+}
+
+CscMatrix::CscMatrix(size_t r, size_t c, const std::vector<SparseEntry>& entries)
+    : rows(r), cols(c) {
+    compress_entries(rows, cols, entries, true, col_ptr, row_idx, values);
+}
+
+CscMatrix::CscMatrix(const CsrMatrix& other) : rows(other.rows), cols(other.cols) {
+    transpose_compressed(other.rows, other.cols, other.row_ptr, other.col_idx, other.values,
+                         col_ptr, row_idx, values);
+}
+
+void CscMatrix::multiply(const double* x, double* y, size_t num_threads) const {
+    const SparseKernels& k = sparse_kernels();
+    auto scatter_columns = [&](size_t begin, size_t end, double* out) {
+        for (size_t j = begin; j < end; j++) {
+            size_t p = col_ptr[j];
+            k.scatter(col_ptr[j + 1] - p, x[j], values.data() + p, row_idx.data() + p, out);
+        }
+    };
+
+    // The block count depends only on nnz, so the summation order (and the
+    // result) is the same for every thread count
+    const size_t blocks = std::min(kMaxCscBlocks, std::max<size_t>(1, values.size() / kCscBlockNnz));
+    if (blocks == 1) {
+        std::fill(y, y + rows, 0.0);
+        scatter_columns(0, cols, y);
+        return;
+    }
+
+    double* partial = t_csc_partial.reserve<double>(blocks * rows);
+    std::fill(partial, partial + blocks * rows, 0.0);
+    const size_t threads = sparse_thread_count(values.size(), blocks, num_threads);
+    std::atomic<size_t> next_block(0);
+    auto run_blocks = [&](size_t) {
+        for (size_t b = next_block.fetch_add(1); b < blocks; b = next_block.fetch_add(1)) {
+            scatter_columns(balanced_split(col_ptr, blocks, b), balanced_split(col_ptr, blocks, b + 1),
+                            partial + b * rows);
+        }
+    };
+    if (threads <= 1) {
+        run_blocks(0);
+    } else {
+        global_thread_pool().parallel_for(threads, run_blocks);
+    }
+
+    for (size_t i = 0; i < rows; i++) {
+        double sum = partial[i];
+        for (size_t b = 1; b < blocks; b++) {
+            sum += partial[b * rows + i];
+        }
+        y[i] = sum;
+    }
+}
+
+Matrix CscMatrix::multiply(const Matrix& b, size_t num_threads) const {
+    if (b.getRows() != cols) {
+        throw std::runtime_error("Invalid matrix dimensions for multiplication");
+    }
+    Matrix result(rows, b.getCols());
+    multiply_into(b, result, num_threads);
+    return result;
+}
+
+void CscMatrix::multiply_into(const Matrix& b, Matrix& result, size_t num_threads) const {
+    check_product_shapes(rows, cols, b, result);
+    const SparseKernels& k = sparse_kernels();
+    const size_t n = b.getCols();
+
+    // Column j of A adds a multiple of row j of B to the rows of C it touches.
+    // Threads take disjoint stripes of C's columns, so no two write the same
+    // element and each element sums in column order.
+    const size_t max_stripes = (n + 7) / 8;
+    const size_t threads = sparse_thread_count(values.size() * n, max_stripes, num_threads);
+    const size_t stripe = (max_stripes + threads - 1) / threads * 8;
+    auto run_stripe = [&](size_t t) {
+        size_t js = t * stripe;
+        if (js >= n) {
+            return;
+        }
+        size_t width = std::min(stripe, n - js);
+        for (size_t i = 0; i < rows; i++) {
+            std::fill(result.row(i) + js, result.row(i) + js + width, 0.0);
+        }
+        for (size_t j = 0; j < cols; j++) {
+            const double* brow = b.row(j) + js;
+            for (size_t p = col_ptr[j]; p < col_ptr[j + 1]; p++) {
+                k.axpy(width, values[p], brow, result.row(row_idx[p]) + js);
+            }
+        }
+    };
+    if (threads <= 1) {
+        run_stripe(0);
+    } else {
+        global_thread_pool().parallel_for(threads, run_stripe);
+    }
+}
+
+Matrix CscMatrix::to_dense() const {
+    Matrix dense(rows, cols);
+    for (size_t j = 0; j < cols; j++) {
+        for (size_t p = col_ptr[j]; p < col_ptr[j + 1]; p++) {
+            dense(row_idx[p], j) = values[p];
+        }
+    }
+    return dense;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+
+// Random entries with the given average density. With skew, row lengths
+// follow a power law (a few very long rows, many short ones) in shuffled
+// row order; without it every row has about the same length.
+static std::vector<SparseEntry> synthetic_entries(size_t n, double density, bool skewed,
+                                                  std::mt19937& gen) {
+    std::vector<double> weight(n, 1.0);
+    if (skewed) {
+        for (size_t i = 0; i < n; i++) {
+            weight[i] = 1.0 / std::pow(static_cast<double>(i + 1), 0.8);
+        }
+        std::shuffle(weight.begin(), weight.end(), gen);
+    }
+    double total_weight = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        total_weight += weight[i];
+    }
+
+    const double target_nnz = density * n * n;
+    std::uniform_int_distribution<size_t> col_dis(0, n - 1);
+    std::uniform_real_distribution<> val_dis(0.0, 10.0);
+    std::vector<SparseEntry> entries;
+    entries.reserve(static_cast<size_t>(target_nnz));
+    for (size_t i = 0; i < n; i++) {
+        size_t len = std::min(n, static_cast<size_t>(target_nnz * weight[i] / total_weight + 0.5));
+        for (size_t e = 0; e < len; e++) {
+            SparseEntry s = { i, col_dis(gen), val_dis(gen) };
+            entries.push_back(s);
+        }
+    }
+    return entries;
+}
+
+void benchmark_sparse_ops() {
+    std::cout << "\n=== Sparse Matrix Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    const size_t n = 10000;
+    const size_t spmm_cols = 16;
+    const size_t repeats = 10;
+    const double densities[] = { 0.001, 0.01, 0.05 };
+    std::mt19937 gen(42);
+
+    std::vector<double> x(n);
+    std::vector<double> y(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = 1.0 + (i % 7);
+    }
+    Matrix b(n, spmm_cols);
+    b.randomize();
+
+    for (double density : densities) {
+        for (int skewed = 0; skewed <= 1; skewed++) {
+            std::vector<SparseEntry> entries = synthetic_entries(n, density, skewed != 0, gen);
+
+            auto build_start = std::chrono::high_resolution_clock::now();
+            CsrMatrix csr(n, n, entries);
+            auto build_end = std::chrono::high_resolution_clock::now();
+            CscMatrix csc(csr);
+            const double nnz = static_cast<double>(csr.nonZeros());
+
+            auto spmv_start = std::chrono::high_resolution_clock::now();
+            for (size_t r = 0; r < repeats; r++) {
+                csr.multiply(x.data(), y.data());
+            }
+            auto spmv_end = std::chrono::high_resolution_clock::now();
+            double spmv_seconds = std::chrono::duration<double>(spmv_end - spmv_start).count() / repeats;
+            double checksum = 0.0;
+            for (size_t i = 0; i < n; i++) {
+                checksum += y[i];
+            }
+
+            auto csc_start = std::chrono::high_resolution_clock::now();
+            for (size_t r = 0; r < repeats; r++) {
+                csc.multiply(x.data(), y.data());
+            }
+            auto csc_end = std::chrono::high_resolution_clock::now();
+            double csc_seconds = std::chrono::duration<double>(csc_end - csc_start).count() / repeats;
+
+            auto spmm_start = std::chrono::high_resolution_clock::now();
+            Matrix c = csr.multiply(b);
+            auto spmm_end = std::chrono::high_resolution_clock::now();
+            double spmm_seconds = std::chrono::duration<double>(spmm_end - spmm_start).count();
+
+            // Values, 32-bit indices and row pointers stream once; x and y once each
+            double spmv_bytes = nnz * (sizeof(double) + sizeof(int32_t)) + (3.0 * n + 1) * sizeof(double);
+
+            std::cout << "Density " << density * 100 << "%, "
+                      << (skewed ? "power-law" : "uniform") << " rows, nnz " << csr.nonZeros() << std::endl;
+            std::cout << "  Build from triplets: "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(build_end - build_start).count()
+                      << " ms" << std::endl;
+            std::cout << "  CSR SpMV: " << 2.0 * nnz / spmv_seconds / 1e9 << " GFLOP/s, "
+                      << spmv_bytes / spmv_seconds / 1e9 << " GB/s" << std::endl;
+            std::cout << "  CSC SpMV: " << 2.0 * nnz / csc_seconds / 1e9 << " GFLOP/s" << std::endl;
+            std::cout << "  CSR SpMM (" << spmm_cols << " columns): "
+                      << 2.0 * nnz * spmm_cols / spmm_seconds / 1e9 << " GFLOP/s" << std::endl;
+            std::cout << "  Result sum: " << checksum << ", " << c.sum() << std::endl;
+        }
+    }
+}
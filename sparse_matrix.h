@@ -0,0 +1,86 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "matrix_operations.h"
+
+// One nonzero in coordinate (COO) form
+struct SparseEntry {
+    size_t row;
+    size_t col;
+    double value;
+};
+
+class CscMatrix;
+
+// Compressed sparse row matrix of doubles.
+//
+// Row i holds values[row_ptr[i] .. row_ptr[i + 1]) at the column indices in
+// col_idx, sorted and without duplicates. Indices are 32-bit, which halves
+// the index traffic and lets the SIMD kernels gather with them directly, so
+// both dimensions must be below 2^31.
+class CsrMatrix {
+private:
+    size_t rows;
+    size_t cols;
+    std::vector<size_t> row_ptr;
+    std::vector<int32_t> col_idx;
+    std::vector<double> values;
+
+    friend class CscMatrix;
+
+public:
+    CsrMatrix();
+    // Keeps the entries whose magnitude exceeds drop_tolerance
+    explicit CsrMatrix(const Matrix& dense, double drop_tolerance = 0.0);
+    // Entries may come in any order; duplicate coordinates are summed
+    CsrMatrix(size_t rows, size_t cols, const std::vector<SparseEntry>& entries);
+    explicit CsrMatrix(const CscMatrix& other);
+
+    // y = A * x, with x of length getCols() and y of length getRows()
+    void multiply(const double* x, double* y, size_t num_threads = 0) const;
+    // A * B for a dense B of getCols() rows
+    Matrix multiply(const Matrix& b, size_t num_threads = 0) const;
+    void multiply_into(const Matrix& b, Matrix& result, size_t num_threads = 0) const;
+    Matrix to_dense() const;
+
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t nonZeros() const { return values.size(); }
+};
+
+// Compressed sparse column matrix of doubles: the same layout by columns,
+// with row indices in row_idx. Products scatter each column into the result.
+class CscMatrix {
+private:
+    size_t rows;
+    size_t cols;
+    std::vector<size_t> col_ptr;
+    std::vector<int32_t> row_idx;
+    std::vector<double> values;
+
+    friend class CsrMatrix;
+
+public:
+    CscMatrix();
+    explicit CscMatrix(const Matrix& dense, double drop_tolerance = 0.0);
+    CscMatrix(size_t rows, size_t cols, const std::vector<SparseEntry>& entries);
+    explicit CscMatrix(const CsrMatrix& other);
+
+    void multiply(const double* x, double* y, size_t num_threads = 0) const;
+    Matrix multiply(const Matrix& b, size_t num_threads = 0) const;
+    void multiply_into(const Matrix& b, Matrix& result, size_t num_threads = 0) const;
+    Matrix to_dense() const;
+
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t nonZeros() const { return values.size(); }
+};
+
+// Benchmark function: SpMV and SpMM over synthetic matrices of varying
+// density and row-length skew
+void benchmark_sparse_ops();
+
+#endif // SPARSE_MATRIX_H
@@ -0,0 +1,266 @@
+#include "strassen.h"
+#include "gemm.h"
+#include "matrix_operations.h"
+#include "memory_operations.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Below this a level saves less in multiplies than its additions cost
+static const size_t kStrassenMinCrossover = 32;
+// Rows of block additions per parallel task
+static const size_t kAddMinRowsPerThread = 64;
+
+static thread_local ScratchBuffer t_strassen_workspace;
+
+static size_t startup_crossover() {
+    const char* env = std::getenv("GEMM_STRASSEN");
+    if (env != nullptr) {
+        long n = std::strtol(env, nullptr, 10);
+        if (n > 0) {
+            return std::max(static_cast<size_t>(n), kStrassenMinCrossover);
+        }
+    }
+    return 0;
+}
+
+static std::atomic<size_t> g_crossover(startup_crossover());
+
+size_t strassen_get_crossover() {
+    return g_crossover.load();
+}
+
+void strassen_set_crossover(size_t crossover) {
+    g_crossover.store(crossover == 0 ? 0 : std::max(crossover, kStrassenMinCrossover));
+}
+
+static bool recurses(size_t m, size_t n, size_t k, size_t crossover) {
+    return std::min(m, std::min(n, k)) >= crossover;
+}
+
+static size_t level_workspace(size_t m, size_t n, size_t k, size_t crossover) {
+    if (!recurses(m, n, k, crossover)) {
+        return 0;
+    }
+    size_t m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    // X holds an m2 x k2 sum and later the m2 x n2 product P1; Y a k2 x n2 sum
+    return m2 * std::max(k2, n2) + k2 * n2 + level_workspace(m2, n2, k2, crossover);
+}
+
+size_t strassen_workspace_size(size_t m, size_t n, size_t k, size_t crossover,
+                               bool needs_product_buffer) {
+    crossover = std::max(crossover, kStrassenMinCrossover);
+    return level_workspace(m, n, k, crossover) + (needs_product_buffer ? m * n : 0);
+}
+
+// Row range [begin, end) of z = x + y, or x - y when subtract is set
+static void add_rows(size_t begin, size_t end, size_t n,
+                     const double* x, size_t ldx, const double* y, size_t ldy,
+                     double* z, size_t ldz, bool subtract) {
+    for (size_t i = begin; i < end; i++) {
+        const double* xr = x + i * ldx;
+        const double* yr = y + i * ldy;
+        double* zr = z + i * ldz;
+        size_t j = 0;
+#if USE_X86_SIMD
+        if (subtract) {
+            for (; j + 4 <= n; j += 4) {
+                _mm_storeu_pd(zr + j, _mm_sub_pd(_mm_loadu_pd(xr + j), _mm_loadu_pd(yr + j)));
+                _mm_storeu_pd(zr + j + 2, _mm_sub_pd(_mm_loadu_pd(xr + j + 2), _mm_loadu_pd(yr + j + 2)));
+            }
+        } else {
+            for (; j + 4 <= n; j += 4) {
+                _mm_storeu_pd(zr + j, _mm_add_pd(_mm_loadu_pd(xr + j), _mm_loadu_pd(yr + j)));
+                _mm_storeu_pd(zr + j + 2, _mm_add_pd(_mm_loadu_pd(xr + j + 2), _mm_loadu_pd(yr + j + 2)));
+            }
+        }
+#endif
+        for (; j < n; j++) {
+            zr[j] = subtract ? xr[j] - yr[j] : xr[j] + yr[j];
+        }
+    }
+}
+
+// m x n block z = x +- y; z may be x or y
+static void block_add(size_t m, size_t n, const double* x, size_t ldx,
+                      const double* y, size_t ldy, double* z, size_t ldz,
+                      bool subtract, size_t threads) {
+    threads = std::min(threads, std::max<size_t>(1, m / kAddMinRowsPerThread));
+    if (threads <= 1) {
+        add_rows(0, m, n, x, ldx, y, ldy, z, ldz, subtract);
+        return;
+    }
+    global_thread_pool().parallel_for(threads, [&](size_t t) {
+        add_rows(m * t / threads, m * (t + 1) / threads, n, x, ldx, y, ldy, z, ldz, subtract);
+    });
+}
+
+// C = A * B (C is overwritten), following the two-temporary schedule of
+// Boyer, Dumas, Pernet and Zhou, "Memory efficient scheduling of
+// Strassen-Winograd's matrix multiplication algorithm" (2009)
+static void strassen_rec(size_t m, size_t n, size_t k,
+                         const double* a, size_t lda, const double* b, size_t ldb,
+                         double* c, size_t ldc, size_t crossover,
+                         double* ws, size_t threads) {
+    if (!recurses(m, n, k, crossover)) {
+        dgemm(m, n, k, 1.0, a, lda, b, ldb, 0.0, c, ldc, threads);
+        return;
+    }
+
+    const size_t m2 = m / 2, n2 = n / 2, k2 = k / 2;
+    const double* a11 = a;
+    const double* a12 = a + k2;
+    const double* a21 = a + m2 * lda;
+    const double* a22 = a21 + k2;
+    const double* b11 = b;
+    const double* b12 = b + n2;
+    const double* b21 = b + k2 * ldb;
+    const double* b22 = b21 + n2;
+    double* c11 = c;
+    double* c12 = c + n2;
+    double* c21 = c + m2 * ldc;
+    double* c22 = c21 + n2;
+
+    const size_t ldx = std::max(k2, n2);
+    const size_t ldy = n2;
+    double* x = ws;
+    double* y = x + m2 * ldx;
+    double* rest = y + k2 * ldy;
+
+    auto mul = [&](const double* p, size_t ldp, const double* q, size_t ldq, double* r, size_t ldr) {
+        strassen_rec(m2, n2, k2, p, ldp, q, ldq, r, ldr, crossover, rest, threads);
+    };
+
+    block_add(m2, k2, a11, lda, a21, lda, x, ldx, true, threads);    // S3 = A11 - A21
+    block_add(k2, n2, b22, ldb, b12, ldb, y, ldy, true, threads);    // T3 = B22 - B12
+    mul(x, ldx, y, ldy, c21, ldc);                                   // P7 = S3 * T3
+    block_add(m2, k2, a21, lda, a22, lda, x, ldx, false, threads);   // S1 = A21 + A22
+    block_add(k2, n2, b12, ldb, b11, ldb, y, ldy, true, threads);    // T1 = B12 - B11
+    mul(x, ldx, y, ldy, c22, ldc);                                   // P5 = S1 * T1
+    block_add(m2, k2, x, ldx, a11, lda, x, ldx, true, threads);      // S2 = S1 - A11
+    block_add(k2, n2, b22, ldb, y, ldy, y, ldy, true, threads);      // T2 = B22 - T1
+    mul(x, ldx, y, ldy, c12, ldc);                                   // P6 = S2 * T2
+    block_add(m2, k2, a12, lda, x, ldx, x, ldx, true, threads);      // S4 = A12 - S2
+    mul(x, ldx, b22, ldb, c11, ldc);                                 // P3 = S4 * B22
+    mul(a11, lda, b11, ldb, x, ldx);                                 // P1 = A11 * B11
+    block_add(m2, n2, x, ldx, c12, ldc, c12, ldc, false, threads);   // U2 = P1 + P6
+    block_add(m2, n2, c12, ldc, c21, ldc, c21, ldc, false, threads); // U3 = U2 + P7
+    block_add(m2, n2, c12, ldc, c22, ldc, c12, ldc, false, threads); // U4 = U2 + P5
+    block_add(m2, n2, c21, ldc, c22, ldc, c22, ldc, false, threads); // U7 = U3 + P5 = C22
+    block_add(m2, n2, c12, ldc, c11, ldc, c12, ldc, false, threads); // U5 = U4 + P3 = C12
+    block_add(k2, n2, y, ldy, b21, ldb, y, ldy, true, threads);      // T4 = T2 - B21
+    mul(a22, lda, y, ldy, c11, ldc);                                 // P4 = A22 * T4
+    block_add(m2, n2, c21, ldc, c11, ldc, c21, ldc, true, threads);  // U6 = U3 - P4 = C21
+    mul(a12, lda, b21, ldb, c11, ldc);                               // P2 = A12 * B21
+    block_add(m2, n2, x, ldx, c11, ldc, c11, ldc, false, threads);   // U1 = P1 + P2 = C11
+
+    // Peel odd dimensions: the last column of A / row of B, then the last
+    // column and row of C, through the blocked kernel
+    const size_t me = 2 * m2, ne = 2 * n2, ke = 2 * k2;
+    if (k != ke) {
+        dgemm(me, ne, 1, 1.0, a + ke, lda, b + ke * ldb, ldb, 1.0, c, ldc, threads);
+    }
+    if (n != ne) {
+        dgemm(m, 1, k, 1.0, a, lda, b + ne, ldb, 0.0, c + ne, ldc, threads);
+    }
+    if (m != me) {
+        dgemm(1, ne, k, 1.0, a + me * lda, lda, b, ldb, 0.0, c + me * ldc, ldc, threads);
+    }
+}
+
+void dgemm_strassen(size_t m, size_t n, size_t k,
+                    double alpha, const double* a, size_t lda,
+                    const double* b, size_t ldb,
+                    double beta, double* c, size_t ldc,
+                    size_t crossover, double* workspace,
+                    size_t num_threads) {
+    crossover = std::max(crossover, kStrassenMinCrossover);
+    const bool direct = (alpha == 1.0 && beta == 0.0);
+    if (m == 0 || n == 0 || k == 0 || alpha == 0.0 || !recurses(m, n, k, crossover)) {
+        dgemm(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, num_threads);
+        return;
+    }
+
+    if (workspace == nullptr) {
+        workspace = t_strassen_workspace.reserve<double>(
+            strassen_workspace_size(m, n, k, crossover, !direct));
+    }
+    const size_t threads = resolve_threads(num_threads);
+
+    if (direct) {
+        strassen_rec(m, n, k, a, lda, b, ldb, c, ldc, crossover, workspace, threads);
+        return;
+    }
+
+    // General alpha/beta: form A * B aside, then C = alpha * P + beta * C
+    double* product = workspace;
+    strassen_rec(m, n, k, a, lda, b, ldb, product, n, crossover, product + m * n, threads);
+    for (size_t i = 0; i < m; i++) {
+        const double* p = product + i * n;
+        double* r = c + i * ldc;
+        for (size_t j = 0; j < n; j++) {
+            r[j] = (beta == 0.0) ? alpha * p[j] : alpha * p[j] + beta * r[j];
+        }
+    }
+}
+
+void benchmark_strassen() {
+    std::cout << "\n=== Strassen-Winograd Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    const size_t size = 2048;
+    Matrix a(size, size);
+    Matrix b(size, size);
+    a.randomize();
+    b.randomize();
+    Matrix reference(size, size);
+    Matrix c(size, size);
+    const double flops = 2.0 * size * size * size;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    dgemm(size, size, size, 1.0, a.row(0), a.getStride(), b.row(0), b.getStride(),
+          0.0, reference.row(0), reference.getStride());
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Matrix size: " << size << "x" << size << std::endl;
+    std::cout << "Classical: " << static_cast<long>(seconds * 1000) << " ms, "
+              << flops / seconds / 1e9 << " GFLOP/s" << std::endl;
+
+    const size_t crossovers[] = { 1024, 512, 256 };
+    for (size_t crossover : crossovers) {
+        // Allocate up front so the timed run measures only the multiply
+        std::vector<double> workspace(strassen_workspace_size(size, size, size, crossover));
+
+        start = std::chrono::high_resolution_clock::now();
+        dgemm_strassen(size, size, size, 1.0, a.row(0), a.getStride(), b.row(0), b.getStride(),
+                       0.0, c.row(0), c.getStride(), crossover, workspace.data());
+        end = std::chrono::high_resolution_clock::now();
+        seconds = std::chrono::duration<double>(end - start).count();
+
+        double max_error = 0.0;
+        double max_value = 0.0;
+        for (size_t i = 0; i < size; i++) {
+            for (size_t j = 0; j < size; j++) {
+                max_error = std::max(max_error, std::fabs(c(i, j) - reference(i, j)));
+                max_value = std::max(max_value, std::fabs(reference(i, j)));
+            }
+        }
+
+        std::cout << "Strassen, crossover " << crossover << ": "
+                  << static_cast<long>(seconds * 1000) << " ms, "
+                  << flops / seconds / 1e9 << " effective GFLOP/s, "
+                  << "max relative difference " << max_error / max_value << std::endl;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include <cstddef>
+
+// Strassen-Winograd fast path for large double-precision multiplies.
+//
+// Each recursion level splits A, B and C into 2x2 blocks and forms C from
+// 7 half-size products and 15 block additions instead of 8 products, so d
+// levels do (7/8)^d of the classical flops. Odd dimensions are peeled off
+// and finished with the blocked kernel, which also runs every product
+// whose smallest dimension is below the crossover.
+//
+// Error bound (Higham, "Accuracy and Stability of Numerical Algorithms",
+// Thm. 23.3, Winograd variant): with d levels above base blocks of size n0,
+//     max|C - fl(C)| <= (18^d * (n0^2 + 6 n0) - 6 n) * u * max|A| * max|B|
+// to first order in the unit roundoff u (2^-53). The classical product
+// satisfies |C - fl(C)| <= n * u * |A| * |B| element-wise, so every level
+// gives up roughly a factor of 4.5 in the worst case; observed errors are
+// far smaller. Raising the crossover trades speed back for accuracy.
+
+// Products whose smallest dimension is at least the crossover use Strassen
+// in Matrix::multiply and gemm<double>. 0 (the default) disables the fast
+// path; the GEMM_STRASSEN environment variable sets the startup value.
+size_t strassen_get_crossover();
+void strassen_set_crossover(size_t crossover);
+
+// Doubles of workspace dgemm_strassen needs for this problem and crossover
+size_t strassen_workspace_size(size_t m, size_t n, size_t k, size_t crossover,
+                               bool needs_product_buffer = false);
+
+// C = alpha * A * B + beta * C through Strassen-Winograd recursion down to
+// the crossover. All temporaries come from workspace, which must hold
+// strassen_workspace_size(m, n, k, crossover, alpha != 1 || beta != 0)
+// doubles; pass null to use a grow-only per-thread workspace instead.
+void dgemm_strassen(size_t m, size_t n, size_t k,
+                    double alpha, const double* a, size_t lda,
+                    const double* b, size_t ldb,
+                    double beta, double* c, size_t ldc,
+                    size_t crossover, double* workspace = nullptr,
+                    size_t num_threads = 0);
+
+// Benchmark function: classical vs Strassen time and error at 2048x2048
+void benchmark_strassen();
+
+#endif // STRASSEN_H
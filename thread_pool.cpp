@@ -0,0 +1,195 @@
+#include "thread_pool.h"
+#include "numa.h"
+#include <cstdlib>
+#include <memory>
+
+// Set on pool workers and on callers while they execute pool tasks
+static thread_local bool t_inside_pool = false;
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : thread_count(1), job(nullptr), job_count(0), next_index(0), active_workers(0),
+      generation(0), stop(false), pinned(false) {
+    start_workers(num_threads);
+    pin_workers();
+}
+
+ThreadPool::~ThreadPool() {
+    stop_workers();
+}
+
+// Called with no loop in flight, so generation is stable
+void ThreadPool::start_workers(size_t num_threads) {
+    for (size_t i = 1; i < num_threads; i++) {
+        workers.push_back(std::thread(&ThreadPool::worker_loop, this, generation));
+    }
+    thread_count.store(workers.size() + 1);
+}
+
+void ThreadPool::stop_workers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    workers.clear();
+    thread_count.store(1);
+    stop = false;
+}
+
+void ThreadPool::resize(size_t num_threads) {
+    // Held by every parallel_for, so no loop is using the old workers
+    std::lock_guard<std::mutex> submit(submit_mutex);
+    stop_workers();
+    pinned = false;
+    start_workers(num_threads);
+    pin_workers();
+}
+
+void ThreadPool::pin_workers() {
+    std::vector<int> cpus = numa_thread_cpus(size());
+    bool any = false;
+    for (size_t i = 1; i < cpus.size(); i++) {
+        any = any || cpus[i] >= 0;
+    }
+    if (!any && !pinned) {
+        return;
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        pin_thread(workers[i].native_handle(), cpus[i + 1]);
+    }
+    pinned = any;
+}
+
+void ThreadPool::run_items(const std::function<void(size_t)>& fn, size_t count) {
+    bool was_inside = t_inside_pool;
+    t_inside_pool = true;
+    for (;;) {
+        size_t i = next_index.fetch_add(1);
+        if (i >= count) {
+            break;
+        }
+        try {
+            fn(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    t_inside_pool = was_inside;
+}
+
+// seen is the generation when the worker was started; earlier loops are
+// not its business
+void ThreadPool::worker_loop(unsigned long long seen) {
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stop || generation != seen; });
+        if (stop) {
+            return;
+        }
+        seen = generation;
+        const std::function<void(size_t)>* fn = job;
+        size_t count = job_count;
+        lock.unlock();
+
+        run_items(*fn, count);
+
+        lock.lock();
+        if (--active_workers == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> submit(submit_mutex, std::defer_lock);
+    if (count > 1 && !t_inside_pool) {
+        submit.lock();
+    }
+    if (!submit.owns_lock() || workers.empty()) {
+        if (submit.owns_lock()) {
+            submit.unlock();
+        }
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        job_count = count;
+        next_index.store(0);
+        active_workers = workers.size();
+        error = nullptr;
+        generation++;
+    }
+    wake.notify_all();
+
+    run_items(fn, count);
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return active_workers == 0; });
+        job = nullptr;
+        failure = error;
+        error = nullptr;
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+static std::mutex g_pool_mutex;
+static std::unique_ptr<ThreadPool> g_pool;
+static size_t g_num_threads = 0;
+
+static size_t default_num_threads() {
+    const char* env = std::getenv("COMPUTE_THREADS");
+    if (env != nullptr) {
+        long n = std::strtol(env, nullptr, 10);
+        if (n > 0) {
+            return static_cast<size_t>(n);
+        }
+    }
+    size_t hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+ThreadPool& global_thread_pool() {
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    if (!g_pool) {
+        if (g_num_threads == 0) {
+            g_num_threads = default_num_threads();
+        }
+        g_pool.reset(new ThreadPool(g_num_threads));
+    }
+    return *g_pool;
+}
+
+size_t get_num_threads() {
+    return global_thread_pool().size();
+}
+
+void set_num_threads(size_t num_threads) {
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    g_num_threads = num_threads > 0 ? num_threads : default_num_threads();
+    if (g_pool && g_pool->size() != g_num_threads) {
+        g_pool->resize(g_num_threads);
+    }
+}
+
+size_t resolve_threads(size_t num_threads) {
+    size_t pool_size = global_thread_pool().size();
+    return (num_threads == 0) ? pool_size : std::min(num_threads, pool_size);
+}
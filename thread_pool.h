@@ -0,0 +1,93 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool of worker threads that runs index-space loops.
+// The calling thread takes part in every loop, so a pool of size N
+// starts N - 1 workers.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::atomic<size_t> thread_count;
+    std::mutex mutex;
+    std::mutex submit_mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* job;
+    size_t job_count;
+    std::atomic<size_t> next_index;
+    size_t active_workers;
+    unsigned long long generation;
+    bool stop;
+    bool pinned;
+    std::exception_ptr error;
+
+    void worker_loop(unsigned long long seen);
+    void run_items(const std::function<void(size_t)>& fn, size_t count);
+    void start_workers(size_t num_threads);
+    void stop_workers();
+
+public:
+    explicit ThreadPool(size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return thread_count.load(); }
+
+    // Replaces the workers once any loop in flight has finished; the pool
+    // object itself, and references to it, stay valid. Not for pool tasks.
+    void resize(size_t num_threads);
+
+    // Pins the workers to the CPUs the NUMA policy picks (numa.h), or frees
+    // them again; done on creation and whenever the policy changes
+    void pin_workers();
+
+    // Run fn(i) for every i in [0, count) and return once all have finished.
+    // Calls made from inside a pool task run serially on the calling thread.
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+};
+
+// Process-wide pool. Its size comes from set_num_threads(), else the
+// COMPUTE_THREADS environment variable, else the hardware thread count.
+// It lives until exit; set_num_threads() resizes it in place.
+ThreadPool& global_thread_pool();
+size_t get_num_threads();
+void set_num_threads(size_t num_threads);
+
+// Threads a kernel asks for: the whole global pool for 0, else num_threads
+// capped at the pool size
+size_t resolve_threads(size_t num_threads);
+
+// Runs fn(block) for every block in [0, blocks), striding the blocks over
+// up to resolve_threads(num_threads) pool threads, or on the calling thread
+// while work is below min_work. Blocks are cut by position rather than by
+// thread, so per-block results do not depend on the thread count.
+template <typename F>
+void parallel_blocks(size_t blocks, size_t work, size_t min_work, size_t num_threads, const F& fn) {
+    size_t threads = (work < min_work) ? 1 : std::min(resolve_threads(num_threads), blocks);
+    if (threads <= 1) {
+        for (size_t block = 0; block < blocks; block++) {
+            fn(block);
+        }
+        return;
+    }
+    global_thread_pool().parallel_for(threads, [&](size_t t) {
+        for (size_t block = t; block < blocks; block += threads) {
+            fn(block);
+        }
+    });
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,90 @@
+#ifndef TILED_MATRIX_H
+#define TILED_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk tiled matrix for products that do not fit in memory.
+//
+// File layout: a 4096-byte header page (magic, rows, cols, tile size)
+// followed by the tiles in row-major tile order. Every tile holds
+// tile x tile row-major doubles; edge tiles are zero-padded to full size so
+// tile (ti, tj) always sits at a fixed offset. The file is accessed through
+// a shared mmap, so the kernel pages tiles in and out on demand and writes
+// are persisted by the page cache.
+class TiledMatrixFile {
+public:
+    // Create (or truncate) a zero-filled file and map it read-write
+    static TiledMatrixFile create(const std::string& path, size_t rows, size_t cols,
+                                  size_t tile);
+    // Map an existing file; throws if the header or file size is invalid
+    explicit TiledMatrixFile(const std::string& path, bool writable = false);
+    TiledMatrixFile(TiledMatrixFile&& other);
+    ~TiledMatrixFile();
+
+    TiledMatrixFile(const TiledMatrixFile&) = delete;
+    TiledMatrixFile& operator=(const TiledMatrixFile&) = delete;
+    TiledMatrixFile& operator=(TiledMatrixFile&&) = delete;
+
+    size_t getRows() const { return rows; }
+    size_t getCols() const { return cols; }
+    size_t getTile() const { return tile; }
+    size_t tileRows() const { return (rows + tile - 1) / tile; }
+    size_t tileCols() const { return (cols + tile - 1) / tile; }
+    bool isWritable() const { return writable; }
+
+    // Row-major tile x tile block; the leading dimension is getTile()
+    double* tileData(size_t ti, size_t tj);
+    const double* tileData(size_t ti, size_t tj) const;
+    size_t tileBytes() const { return tile * tile * sizeof(double); }
+
+    double at(size_t row, size_t col) const;
+
+    // Start asynchronous read-ahead of a tile (MADV_WILLNEED)
+    void prefetchTile(size_t ti, size_t tj) const;
+    // Drop a tile's pages from this mapping (MADV_DONTNEED); dirty pages
+    // stay in the page cache and are written back by the kernel
+    void releaseTile(size_t ti, size_t tj) const;
+    // Write dirty pages back to the file and wait for completion
+    void sync() const;
+    // sync() and drop the file from the page cache, so the next access
+    // reads from disk
+    void evictCache() const;
+
+private:
+    TiledMatrixFile(int fd, bool writable);
+    void map(size_t expected_size);
+
+    int fd;
+    bool writable;
+    size_t rows;
+    size_t cols;
+    size_t tile;
+    size_t mapped_size;
+    unsigned char* base;
+};
+
+// Traffic and timing of one tiled_multiply call
+struct TiledMultiplyStats {
+    double seconds;
+    uint64_t bytes_read;     // tile bytes of A and B fed to the kernel
+    uint64_t bytes_written;  // tile bytes of C produced
+};
+
+// C = A * B over tiled files with equal tile sizes. C tiles are produced in
+// row-major order: the row panel of A tiles stays mapped while B tiles
+// stream past it, and tiles a few steps ahead are prefetched with
+// MADV_WILLNEED so disk reads overlap the blocked kernel. Consumed B tiles
+// and finished C tiles are released immediately, so the resident set is
+// one A row panel plus a handful of tiles. Each tile product runs dgemm
+// with up to num_threads workers (0 = global pool).
+void tiled_multiply(const TiledMatrixFile& a, const TiledMatrixFile& b, TiledMatrixFile& c,
+                    size_t num_threads = 0, TiledMultiplyStats* stats = nullptr);
+
+// Benchmark function. Not part of the default run: it writes three
+// TILED_MATRIX_SIZE (default 4096) square matrices to TILED_MATRIX_DIR
+// (default /tmp) and reports GFLOP/s and I/O MB/s
+void benchmark_tiled_matrix();
+
+#endif // TILED_MATRIX_H
@@ -0,0 +1,453 @@
+#include "transpose.h"
+#include "bench_util.h"
+#include "cpu_features.h"
+#include "matrix_operations.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#define USE_X86_SIMD 1
+#else
+#define USE_X86_SIMD 0
+#endif
+
+// Blocks with both sides at most this many elements are leaves: 32 for
+// floats and doubles, 64 for 16-bit types so each leaf row still spans two
+// or more cache lines. The staged block stays within 8 KB either way.
+template <typename T>
+struct TransposeLeafSide {
+    static const size_t side = sizeof(T) >= 4 ? 32 : 128 / sizeof(T);
+};
+// Elements below which the work stays on the calling thread
+static const size_t kTransposeParallelMin = 1 << 18;
+
+template <typename T>
+struct TransposeLeaf {
+    typedef void (*Fn)(size_t rows, size_t cols, const T* src, size_t lds, T* dst, size_t ldd);
+};
+
+template <typename T>
+static void leaf_scalar(size_t rows, size_t cols, const T* src, size_t lds, T* dst, size_t ldd) {
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            dst[j * ldd + i] = src[i * lds + j];
+        }
+    }
+}
+
+// Transposes rows [0, full_rows) x cols [full_cols, cols) and the rows below
+// full_rows, which the register blocks did not cover
+template <typename T>
+static void leaf_edges(size_t rows, size_t cols, size_t full_rows, size_t full_cols,
+                       const T* src, size_t lds, T* dst, size_t ldd) {
+    leaf_scalar(full_rows, cols - full_cols, src + full_cols, lds, dst + full_cols * ldd, ldd);
+    leaf_scalar(rows - full_rows, cols, src + full_rows * lds, lds, dst + full_rows, ldd);
+}
+
+#if USE_X86_SIMD
+static void leaf_f64_sse2(size_t rows, size_t cols, const double* src, size_t lds,
+                          double* dst, size_t ldd) {
+    size_t full_rows = rows & ~size_t(1), full_cols = cols & ~size_t(1);
+    for (size_t i = 0; i < full_rows; i += 2) {
+        const double* s = src + i * lds;
+        for (size_t j = 0; j < full_cols; j += 2) {
+            __m128d r0 = _mm_loadu_pd(s + j);
+            __m128d r1 = _mm_loadu_pd(s + lds + j);
+            _mm_storeu_pd(dst + j * ldd + i, _mm_unpacklo_pd(r0, r1));
+            _mm_storeu_pd(dst + (j + 1) * ldd + i, _mm_unpackhi_pd(r0, r1));
+        }
+    }
+    leaf_edges(rows, cols, full_rows, full_cols, src, lds, dst, ldd);
+}
+
+TARGET_AVX2
+static void leaf_f64_avx2(size_t rows, size_t cols, const double* src, size_t lds,
+                          double* dst, size_t ldd) {
+    size_t full_rows = rows & ~size_t(3), full_cols = cols & ~size_t(3);
+    for (size_t i = 0; i < full_rows; i += 4) {
+        const double* s = src + i * lds;
+        for (size_t j = 0; j < full_cols; j += 4) {
+            __m256d r0 = _mm256_loadu_pd(s + j);
+            __m256d r1 = _mm256_loadu_pd(s + lds + j);
+            __m256d r2 = _mm256_loadu_pd(s + 2 * lds + j);
+            __m256d r3 = _mm256_loadu_pd(s + 3 * lds + j);
+            __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+            __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+            __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+            __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+            double* d = dst + j * ldd + i;
+            _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+            _mm256_storeu_pd(d + ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+            _mm256_storeu_pd(d + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+            _mm256_storeu_pd(d + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+        }
+    }
+    leaf_edges(rows, cols, full_rows, full_cols, src, lds, dst, ldd);
+}
+
+static void leaf_f32_sse2(size_t rows, size_t cols, const float* src, size_t lds,
+                          float* dst, size_t ldd) {
+    size_t full_rows = rows & ~size_t(3), full_cols = cols & ~size_t(3);
+    for (size_t i = 0; i < full_rows; i += 4) {
+        const float* s = src + i * lds;
+        for (size_t j = 0; j < full_cols; j += 4) {
+            __m128 r0 = _mm_loadu_ps(s + j);
+            __m128 r1 = _mm_loadu_ps(s + lds + j);
+            __m128 r2 = _mm_loadu_ps(s + 2 * lds + j);
+            __m128 r3 = _mm_loadu_ps(s + 3 * lds + j);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            float* d = dst + j * ldd + i;
+            _mm_storeu_ps(d, r0);
+            _mm_storeu_ps(d + ldd, r1);
+            _mm_storeu_ps(d + 2 * ldd, r2);
+            _mm_storeu_ps(d + 3 * ldd, r3);
+        }
+    }
+    leaf_edges(rows, cols, full_rows, full_cols, src, lds, dst, ldd);
+}
+
+TARGET_AVX2
+static void leaf_f32_avx2(size_t rows, size_t cols, const float* src, size_t lds,
+                          float* dst, size_t ldd) {
+    size_t full_rows = rows & ~size_t(7), full_cols = cols & ~size_t(7);
+    for (size_t i = 0; i < full_rows; i += 8) {
+        const float* s = src + i * lds;
+        for (size_t j = 0; j < full_cols; j += 8) {
+            __m256 r[8], t[8];
+            for (int q = 0; q < 8; q++) {
+                r[q] = _mm256_loadu_ps(s + q * lds + j);
+            }
+            // Interleave pairs of rows, then pairs of pairs, then 128-bit halves
+            for (int q = 0; q < 8; q += 2) {
+                t[q] = _mm256_unpacklo_ps(r[q], r[q + 1]);
+                t[q + 1] = _mm256_unpackhi_ps(r[q], r[q + 1]);
+            }
+            for (int q = 0; q < 8; q += 4) {
+                r[q] = _mm256_shuffle_ps(t[q], t[q + 2], 0x44);
+                r[q + 1] = _mm256_shuffle_ps(t[q], t[q + 2], 0xEE);
+                r[q + 2] = _mm256_shuffle_ps(t[q + 1], t[q + 3], 0x44);
+                r[q + 3] = _mm256_shuffle_ps(t[q + 1], t[q + 3], 0xEE);
+            }
+            float* d = dst + j * ldd + i;
+            for (int q = 0; q < 4; q++) {
+                _mm256_storeu_ps(d + q * ldd, _mm256_permute2f128_ps(r[q], r[q + 4], 0x20));
+                _mm256_storeu_ps(d + (q + 4) * ldd, _mm256_permute2f128_ps(r[q], r[q + 4], 0x31));
+            }
+        }
+    }
+    leaf_edges(rows, cols, full_rows, full_cols, src, lds, dst, ldd);
+}
+
+static void leaf_u16_sse2(size_t rows, size_t cols, const uint16_t* src, size_t lds,
+                          uint16_t* dst, size_t ldd) {
+    size_t full_rows = rows & ~size_t(7), full_cols = cols & ~size_t(7);
+    for (size_t i = 0; i < full_rows; i += 8) {
+        const uint16_t* s = src + i * lds;
+        for (size_t j = 0; j < full_cols; j += 8) {
+            __m128i r[8], lo[4], hi[4];
+            for (int q = 0; q < 8; q++) {
+                r[q] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + q * lds + j));
+            }
+            for (int q = 0; q < 4; q++) {
+                lo[q] = _mm_unpacklo_epi16(r[2 * q], r[2 * q + 1]);
+                hi[q] = _mm_unpackhi_epi16(r[2 * q], r[2 * q + 1]);
+            }
+            // lo holds columns 0-3 of each row pair, hi columns 4-7
+            __m128i c[8];
+            c[0] = _mm_unpacklo_epi32(lo[0], lo[1]);
+            c[1] = _mm_unpackhi_epi32(lo[0], lo[1]);
+            c[2] = _mm_unpacklo_epi32(lo[2], lo[3]);
+            c[3] = _mm_unpackhi_epi32(lo[2], lo[3]);
+            c[4] = _mm_unpacklo_epi32(hi[0], hi[1]);
+            c[5] = _mm_unpackhi_epi32(hi[0], hi[1]);
+            c[6] = _mm_unpacklo_epi32(hi[2], hi[3]);
+            c[7] = _mm_unpackhi_epi32(hi[2], hi[3]);
+            uint16_t* d = dst + j * ldd + i;
+            for (int q = 0; q < 2; q++) {
+                __m128i a = c[4 * q], b = c[4 * q + 1], e = c[4 * q + 2], f = c[4 * q + 3];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + (4 * q) * ldd), _mm_unpacklo_epi64(a, e));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + (4 * q + 1) * ldd), _mm_unpackhi_epi64(a, e));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + (4 * q + 2) * ldd), _mm_unpacklo_epi64(b, f));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + (4 * q + 3) * ldd), _mm_unpackhi_epi64(b, f));
+            }
+        }
+    }
+    leaf_edges(rows, cols, full_rows, full_cols, src, lds, dst, ldd);
+}
+#endif
+
+static TransposeLeaf<double>::Fn leaf_kernel(const double*) {
+#if USE_X86_SIMD
+    static const TransposeLeaf<double>::Fn fn = cpu_features().avx2 ? leaf_f64_avx2 : leaf_f64_sse2;
+    return fn;
+#else
+    return leaf_scalar<double>;
+#endif
+}
+
+static TransposeLeaf<float>::Fn leaf_kernel(const float*) {
+#if USE_X86_SIMD
+    static const TransposeLeaf<float>::Fn fn = cpu_features().avx2 ? leaf_f32_avx2 : leaf_f32_sse2;
+    return fn;
+#else
+    return leaf_scalar<float>;
+#endif
+}
+
+static TransposeLeaf<uint16_t>::Fn leaf_kernel(const uint16_t*) {
+#if USE_X86_SIMD
+    return leaf_u16_sse2;
+#else
+    return leaf_scalar<uint16_t>;
+#endif
+}
+
+// Split point of a side being halved, kept on a multiple of 8 so leaves
+// stay aligned to whole register blocks
+static size_t split_point(size_t n) {
+    return (n / 2 + 7) & ~size_t(7);
+}
+
+// A leaf touches a few cache lines in each of many rows: runs too short
+// for the hardware prefetcher, so request them all before the shuffles
+template <typename T>
+static void prefetch_block(size_t rows, size_t cols, const T* p, size_t ld) {
+#if USE_X86_SIMD
+    for (size_t i = 0; i < rows; i++) {
+        const char* line = reinterpret_cast<const char*>(p + i * ld);
+        for (size_t b = 0; b < cols * sizeof(T); b += 64) {
+            _mm_prefetch(line + b, _MM_HINT_T0);
+        }
+    }
+#else
+    (void)rows;
+    (void)cols;
+    (void)p;
+    (void)ld;
+#endif
+}
+
+template <typename T>
+static void transpose_recursive(size_t rows, size_t cols, const T* src, size_t lds,
+                                T* dst, size_t ldd, typename TransposeLeaf<T>::Fn leaf) {
+    if (rows <= TransposeLeafSide<T>::side && cols <= TransposeLeafSide<T>::side) {
+        // Staging through a contiguous block writes each destination row
+        // segment in one go instead of in partial lines per register block
+        T staged[TransposeLeafSide<T>::side * TransposeLeafSide<T>::side];
+        prefetch_block(rows, cols, src, lds);
+        prefetch_block(cols, rows, dst, ldd);
+        leaf(rows, cols, src, lds, staged, rows);
+        for (size_t j = 0; j < cols; j++) {
+            std::memcpy(dst + j * ldd, staged + j * rows, rows * sizeof(T));
+        }
+    } else if (rows >= cols) {
+        size_t h = split_point(rows);
+        transpose_recursive(h, cols, src, lds, dst, ldd, leaf);
+        transpose_recursive(rows - h, cols, src + h * lds, lds, dst + h, ldd, leaf);
+    } else {
+        size_t h = split_point(cols);
+        transpose_recursive(rows, h, src, lds, dst, ldd, leaf);
+        transpose_recursive(rows, cols - h, src + h, lds, dst + h * ldd, ldd, leaf);
+    }
+}
+
+// Exchange a (rows x cols) with the transpose of b (cols x rows)
+template <typename T>
+static void swap_recursive(size_t rows, size_t cols, T* a, size_t lda, T* b, size_t ldb,
+                           typename TransposeLeaf<T>::Fn leaf) {
+    if (rows <= TransposeLeafSide<T>::side && cols <= TransposeLeafSide<T>::side) {
+        T saved[TransposeLeafSide<T>::side * TransposeLeafSide<T>::side];
+        prefetch_block(rows, cols, a, lda);
+        prefetch_block(cols, rows, b, ldb);
+        leaf(rows, cols, a, lda, saved, rows);
+        leaf(cols, rows, b, ldb, a, lda);
+        for (size_t j = 0; j < cols; j++) {
+            std::memcpy(b + j * ldb, saved + j * rows, rows * sizeof(T));
+        }
+    } else if (rows >= cols) {
+        size_t h = split_point(rows);
+        swap_recursive(h, cols, a, lda, b, ldb, leaf);
+        swap_recursive(rows - h, cols, a + h * lda, lda, b + h, ldb, leaf);
+    } else {
+        size_t h = split_point(cols);
+        swap_recursive(rows, h, a, lda, b, ldb, leaf);
+        swap_recursive(rows, cols - h, a + h, lda, b + h * ldb, ldb, leaf);
+    }
+}
+
+template <typename T>
+static void transpose_square_recursive(size_t n, T* a, size_t lda,
+                                       typename TransposeLeaf<T>::Fn leaf) {
+    if (n <= TransposeLeafSide<T>::side) {
+        T saved[TransposeLeafSide<T>::side * TransposeLeafSide<T>::side];
+        leaf(n, n, a, lda, saved, n);
+        for (size_t i = 0; i < n; i++) {
+            std::memcpy(a + i * lda, saved + i * n, n * sizeof(T));
+        }
+        return;
+    }
+    size_t h = split_point(n);
+    transpose_square_recursive(h, a, lda, leaf);
+    transpose_square_recursive(n - h, a + h * lda + h, lda, leaf);
+    swap_recursive(h, n - h, a + h, lda, a + h * lda, lda, leaf);
+}
+
+static size_t transpose_thread_count(size_t elements, size_t num_threads) {
+    if (elements < kTransposeParallelMin) {
+        return 1;
+    }
+    return resolve_threads(num_threads);
+}
+
+// Start of stripe t when [0, n) is cut into parts stripes on multiples of 8
+static size_t stripe_begin(size_t n, size_t parts, size_t t) {
+    return t == parts ? n : (n * t / parts) & ~size_t(7);
+}
+
+template <typename T>
+static void transpose_impl(size_t rows, size_t cols, const T* src, size_t lds,
+                           T* dst, size_t ldd, size_t num_threads) {
+    typename TransposeLeaf<T>::Fn leaf = leaf_kernel(src);
+    size_t threads = transpose_thread_count(rows * cols, num_threads);
+    if (threads <= 1) {
+        transpose_recursive(rows, cols, src, lds, dst, ldd, leaf);
+        return;
+    }
+    // Independent stripes along the longer side, a few per thread for balance
+    bool by_rows = rows >= cols;
+    size_t side = by_rows ? rows : cols;
+    size_t parts = std::max<size_t>(1, std::min(threads * 4, side / TransposeLeafSide<T>::side));
+    global_thread_pool().parallel_for(parts, [&](size_t t) {
+        size_t begin = stripe_begin(side, parts, t), end = stripe_begin(side, parts, t + 1);
+        if (by_rows) {
+            transpose_recursive(end - begin, cols, src + begin * lds, lds, dst + begin, ldd, leaf);
+        } else {
+            transpose_recursive(rows, end - begin, src + begin, lds, dst + begin * ldd, ldd, leaf);
+        }
+    });
+}
+
+template <typename T>
+static void transpose_in_place_impl(size_t n, T* a, size_t lda, size_t num_threads) {
+    typename TransposeLeaf<T>::Fn leaf = leaf_kernel(static_cast<const T*>(a));
+    size_t threads = transpose_thread_count(n * n, num_threads);
+    if (threads <= 1) {
+        transpose_square_recursive(n, a, lda, leaf);
+        return;
+    }
+    // Diagonal blocks transpose in place; each block above the diagonal
+    // swaps with its mirror, so all tasks touch disjoint memory
+    size_t parts = std::max<size_t>(1, std::min(threads * 2, n / TransposeLeafSide<T>::side));
+    size_t tasks = parts * (parts + 1) / 2;
+    global_thread_pool().parallel_for(tasks, [&](size_t index) {
+        size_t t = 0;
+        while (index >= parts - t) {
+            index -= parts - t;
+            t++;
+        }
+        size_t u = t + index;
+        size_t r0 = stripe_begin(n, parts, t), r1 = stripe_begin(n, parts, t + 1);
+        size_t c0 = stripe_begin(n, parts, u), c1 = stripe_begin(n, parts, u + 1);
+        if (t == u) {
+            transpose_square_recursive(r1 - r0, a + r0 * lda + r0, lda, leaf);
+        } else {
+            swap_recursive(r1 - r0, c1 - c0, a + r0 * lda + c0, lda, a + c0 * lda + r0, lda, leaf);
+        }
+    });
+}
+
+void transpose(size_t rows, size_t cols, const double* src, size_t lds,
+               double* dst, size_t ldd, size_t num_threads) {
+    transpose_impl(rows, cols, src, lds, dst, ldd, num_threads);
+}
+
+void transpose(size_t rows, size_t cols, const float* src, size_t lds,
+               float* dst, size_t ldd, size_t num_threads) {
+    transpose_impl(rows, cols, src, lds, dst, ldd, num_threads);
+}
+
+void transpose(size_t rows, size_t cols, const uint16_t* src, size_t lds,
+               uint16_t* dst, size_t ldd, size_t num_threads) {
+    transpose_impl(rows, cols, src, lds, dst, ldd, num_threads);
+}
+
+void transpose(size_t rows, size_t cols, const bfloat16* src, size_t lds,
+               bfloat16* dst, size_t ldd, size_t num_threads) {
+    transpose_impl(rows, cols, reinterpret_cast<const uint16_t*>(src), lds,
+                   reinterpret_cast<uint16_t*>(dst), ldd, num_threads);
+}
+
+void transpose(size_t rows, size_t cols, const float16* src, size_t lds,
+               float16* dst, size_t ldd, size_t num_threads) {
+    transpose_impl(rows, cols, reinterpret_cast<const uint16_t*>(src), lds,
+                   reinterpret_cast<uint16_t*>(dst), ldd, num_threads);
+}
+
+void transpose_in_place(size_t n, double* a, size_t lda, size_t num_threads) {
+    transpose_in_place_impl(n, a, lda, num_threads);
+}
+
+void transpose_in_place(size_t n, float* a, size_t lda, size_t num_threads) {
+    transpose_in_place_impl(n, a, lda, num_threads);
+}
+
+void transpose_in_place(size_t n, uint16_t* a, size_t lda, size_t num_threads) {
+    transpose_in_place_impl(n, a, lda, num_threads);
+}
+
+void transpose_in_place(size_t n, bfloat16* a, size_t lda, size_t num_threads) {
+    transpose_in_place_impl(n, reinterpret_cast<uint16_t*>(a), lda, num_threads);
+}
+
+void transpose_in_place(size_t n, float16* a, size_t lda, size_t num_threads) {
+    transpose_in_place_impl(n, reinterpret_cast<uint16_t*>(a), lda, num_threads);
+}
+
+template <typename T>
+static void benchmark_transpose_size(const char* label, size_t size) {
+    BasicMatrix<T> a(size, size);
+    a.randomize();
+    BasicMatrix<T> copy(size, size);
+    BasicMatrix<T> t(size, size);
+    const double bytes = 2.0 * size * size * sizeof(T);
+
+    double memcpy_seconds = best_seconds([&] {
+        for (size_t i = 0; i < size; i++) {
+            std::memcpy(copy.row(i), a.row(i), size * sizeof(T));
+        }
+    });
+    double seconds = best_seconds([&] {
+        transpose(size, size, a.row(0), a.getStride(), t.row(0), t.getStride());
+    });
+    // An even number of in-place runs leaves copy equal to a
+    double in_place_seconds = best_seconds([&] {
+        transpose_in_place(size, copy.row(0), copy.getStride());
+        transpose_in_place(size, copy.row(0), copy.getStride());
+    }) / 2;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < size; i++) {
+        for (size_t j = 0; j < size; j++) {
+            mismatches += std::memcmp(&t(j, i), &a(i, j), sizeof(T)) != 0;
+            mismatches += std::memcmp(&copy(i, j), &a(i, j), sizeof(T)) != 0;
+        }
+    }
+
+    std::cout << label << " " << size << "x" << size << ": memcpy "
+              << bytes / memcpy_seconds / 1e9 << " GB/s, transpose "
+              << bytes / seconds / 1e9 << " GB/s, in-place "
+              << bytes / in_place_seconds / 1e9 << " GB/s, mismatches " << mismatches << std::endl;
+}
+
+void benchmark_transpose() {
+    std::cout << "\n=== Transpose Benchmark ===" << std::endl;
+    std::cout << "Threads: " << get_num_threads() << std::endl;
+
+    benchmark_transpose_size<double>("fp64", 1024);
+    benchmark_transpose_size<double>("fp64", 4096);
+    benchmark_transpose_size<float>("fp32", 4096);
+    benchmark_transpose_size<bfloat16>("bf16", 4096);
+}
@@ -0,0 +1,40 @@
+#ifndef TRANSPOSE_H
+#define TRANSPOSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "half_precision.h"
+
+// Cache-oblivious transpose kernels.
+//
+// The matrix is halved along its longer side until a block fits in L1, so
+// every level of the cache hierarchy sees blocks it can hold without any
+// tuned tile size. Leaf blocks are transposed with in-register shuffles:
+// 4x4 doubles and 8x8 floats with AVX2, 2x2 doubles and 4x4 floats with
+// SSE2, and 8x8 16-bit elements with SSE2. num_threads caps the worker
+// count (0 = global pool); small matrices run on the calling thread.
+
+// dst (cols x rows, leading dimension ldd) = transpose of src (rows x cols,
+// leading dimension lds). src and dst must not overlap.
+void transpose(size_t rows, size_t cols, const double* src, size_t lds,
+               double* dst, size_t ldd, size_t num_threads = 0);
+void transpose(size_t rows, size_t cols, const float* src, size_t lds,
+               float* dst, size_t ldd, size_t num_threads = 0);
+void transpose(size_t rows, size_t cols, const uint16_t* src, size_t lds,
+               uint16_t* dst, size_t ldd, size_t num_threads = 0);
+void transpose(size_t rows, size_t cols, const bfloat16* src, size_t lds,
+               bfloat16* dst, size_t ldd, size_t num_threads = 0);
+void transpose(size_t rows, size_t cols, const float16* src, size_t lds,
+               float16* dst, size_t ldd, size_t num_threads = 0);
+
+// In-place transpose of the n x n matrix a (leading dimension lda)
+void transpose_in_place(size_t n, double* a, size_t lda, size_t num_threads = 0);
+void transpose_in_place(size_t n, float* a, size_t lda, size_t num_threads = 0);
+void transpose_in_place(size_t n, uint16_t* a, size_t lda, size_t num_threads = 0);
+void transpose_in_place(size_t n, bfloat16* a, size_t lda, size_t num_threads = 0);
+void transpose_in_place(size_t n, float16* a, size_t lda, size_t num_threads = 0);
+
+// Benchmark function: transpose GB/s against memcpy of the same bytes
+void benchmark_transpose();
+
+#endif // TRANSPOSE_H